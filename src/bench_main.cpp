@@ -0,0 +1,1038 @@
+// TroubleTanks - Simulation benchmarks
+// Times the simulation hot paths in isolation and reports ns/op.
+//
+// Usage: trouble_bench [--reps N] [--min-time S] [--json FILE] [name...]
+//
+// Every benchmark runs one untimed warmup repetition and then --reps timed
+// repetitions of at least --min-time seconds each; the table and the JSON
+// file report the mean, standard deviation, minimum and median ns/op across
+// repetitions. A name selects every benchmark whose name starts with it;
+// with no name everything runs. Diff the JSON of two builds to spot
+// regressions.
+
+#include "camera.h"
+#include "chunked_maze.h"
+#include "framing.h"
+#include "maze_generator.h"
+#include "net_socket.h"
+#include "net_thread.h"
+#include "navigation.h"
+#include "packets.h"
+#include "particles.h"
+#include "rng.h"
+#include "rollback.h"
+#include "shot_solver.h"
+#include "snapshot_delta.h"
+#include "spsc_queue.h"
+#include "udp_transport.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Result of one benchmark across its timed repetitions
+struct BenchResult {
+    std::string name;
+    double meanNs;
+    double stddevNs;
+    double minNs;
+    double medianNs;
+    long long ops;      // Operations timed over all repetitions
+};
+
+static int g_repetitions = 10;
+static double g_minRepSeconds = 0.05;
+static std::vector<const char*> g_filters;
+static std::vector<BenchResult> g_results;
+static volatile int g_sink;             // Keeps results of pure queries alive
+
+static double NowSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool Selected(const std::string& name) {
+    if (g_filters.empty()) {
+        return true;
+    }
+    for (const char* filter : g_filters) {
+        if (name.compare(0, strlen(filter), filter) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Time op() per call. reset() restores the fixture and is run untimed before
+// every batch of at most maxBatch calls, so ops that consume their fixture
+// (bullets expiring, particles dying) are measured under a steady load.
+template <typename Reset, typename Op>
+static void Measure(const std::string& name, int maxBatch, Reset reset, Op op) {
+    if (!Selected(name)) {
+        return;
+    }
+
+    std::vector<double> samples;
+    long long totalOps = 0;
+    for (int rep = -1; rep < g_repetitions; rep++) {
+        double timed = 0;
+        long long ops = 0;
+        while (timed < g_minRepSeconds) {
+            reset();
+            double start = NowSeconds();
+            for (int i = 0; i < maxBatch; i++) {
+                op();
+            }
+            timed += NowSeconds() - start;
+            ops += maxBatch;
+        }
+        // Repetition -1 is the warmup
+        if (rep >= 0) {
+            samples.push_back(timed * 1e9 / ops);
+            totalOps += ops;
+        }
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.ops = totalOps;
+    double sum = 0;
+    for (double s : samples) {
+        sum += s;
+    }
+    result.meanNs = sum / samples.size();
+    double variance = 0;
+    for (double s : samples) {
+        variance += (s - result.meanNs) * (s - result.meanNs);
+    }
+    result.stddevNs = samples.size() > 1 ? sqrt(variance / (samples.size() - 1)) : 0.0;
+    std::sort(samples.begin(), samples.end());
+    result.minNs = samples.front();
+    result.medianNs = samples[samples.size() / 2];
+    g_results.push_back(result);
+
+    printf("%-32s %14.1f ns/op  +-%5.1f%%  min %12.1f  median %12.1f\n", name.c_str(),
+           result.meanNs, result.meanNs > 0 ? result.stddevNs / result.meanNs * 100.0 : 0.0,
+           result.minNs, result.medianNs);
+    fflush(stdout);
+}
+
+// Measure without a fixture to restore
+template <typename Op>
+static void Measure(const std::string& name, Op op) {
+    Measure(name, 1000, [] {}, op);
+}
+
+// Scatter bullets over the open cells of the state's maze with random headings
+template <typename State>
+static void ScatterBullets(State& state, int count, Rng& rng) {
+    state.bullets.Clear();
+    const Maze& maze = state.maze;
+    while (state.bullets.Count() < count) {
+        int cellX = 1 + (int)rng.NextBelow((uint32_t)maze.Width() - 2);
+        int cellY = 1 + (int)rng.NextBelow((uint32_t)maze.Height() - 2);
+        if (maze.IsWall(cellX, cellY)) {
+            continue;
+        }
+        float angle = rng.NextFloat() * 6.2831853f;
+        Bullet bullet((cellX + rng.NextFloat()) * WALL_SIZE, (cellY + rng.NextFloat()) * WALL_SIZE,
+                      cosf(angle) * BULLET_SPEED, sinf(angle) * BULLET_SPEED, 1);
+        bullet.lifetime = BULLET_LIFETIME;
+        state.bullets.Spawn(bullet);
+    }
+}
+
+// GameState::Update with a fixed number of bullets in flight. A single
+// player owns every bullet, so no tank is ever hit and the match never ends
+// mid-measurement; the bullets are re-scattered every 20 ticks.
+static void BenchUpdate() {
+    const int counts[] = { 0, 50, 500, 5000 };
+    for (int count : counts) {
+        GameState fixture(1);
+        fixture.Initialize(1);
+        fixture.bullets = BulletPool(count + 64);
+        Rng rng(7);
+        ScatterBullets(fixture, count, rng);
+
+        GameState state(1);
+        Measure("update/bullets_" + std::to_string(count), 20,
+                [&] { state = fixture; },
+                [&] { state.Update(); });
+    }
+
+    // Particle storm: the particle ring refilled to capacity every batch
+    GameState fixture(2);
+    fixture.Initialize(1);
+    for (int i = 0; i < fixture.particles.Capacity(); i += 8) {
+        fixture.particles.AddExplosion((float)(i % WINDOW_WIDTH), (float)((i / 8) % WINDOW_HEIGHT));
+    }
+    GameState state(2);
+    Measure("update/particle_storm", PARTICLE_LIFETIME - 1,
+            [&] { state = fixture; },
+            [&] { state.Update(); });
+}
+
+// GameState::Update on one arena with 500 bullets in flight, set up as in
+// BenchUpdate so the match never ends
+template <typename ArenaT>
+static void BenchArena() {
+    typedef BasicGameState<ArenaT> State;
+    State fixture(1);
+    fixture.Initialize(1);
+    Rng rng(9);
+    ScatterBullets(fixture, 500, rng);
+
+    State state(1);
+    Measure("update/arena_" + std::to_string(ArenaT::MAZE_WIDTH) + "x" + std::to_string(ArenaT::MAZE_HEIGHT), 20,
+            [&] { state = fixture; },
+            [&] { state.Update(); });
+}
+
+// Point queries against the maze and the tank broadphase
+static void BenchCollision() {
+    const int POINTS = 1024;
+    std::vector<float> xs(POINTS), ys(POINTS);
+    Rng rng(3);
+    for (int i = 0; i < POINTS; i++) {
+        xs[i] = rng.NextFloat() * WINDOW_WIDTH;
+        ys[i] = rng.NextFloat() * WINDOW_HEIGHT;
+    }
+
+    GameState state(MAX_PLAYERS);
+    state.Initialize(1);
+    int i = 0;
+    Measure("collision/wall", [&] {
+        g_sink += state.CheckWallCollision(xs[i], ys[i]);
+        i = (i + 1) & (POINTS - 1);
+    });
+    Measure("collision/tank_64", [&] {
+        g_sink += state.CheckTankCollision(xs[i], ys[i], 0);
+        i = (i + 1) & (POINTS - 1);
+    });
+}
+
+static void BenchExplosion() {
+    GameState state(2);
+    state.Initialize(1);
+    float x = 0;
+    Measure("explosion/add", [&] {
+        state.AddExplosion(x, 300.0f);
+        x = (x < WINDOW_WIDTH) ? x + 1.0f : 0.0f;
+    });
+}
+
+// ParticleSystem::Update with the ring kept saturated
+static void BenchParticles() {
+    const int counts[] = { 10000, 100000, 1000000 };
+    for (int count : counts) {
+        ParticleSystem particles(count);
+        Measure("particles/update_" + std::to_string(count), PARTICLE_LIFETIME - 1,
+                [&] {
+                    particles.Clear();
+                    for (int i = 0; i < count; i++) {
+                        particles.Spawn((float)(i % 800), (float)(i % 600), 1.0f, -1.0f);
+                    }
+                },
+                [&] { particles.Update(); });
+    }
+}
+
+// Maze generation, both through GameState::Initialize and per algorithm
+static void BenchMazeGeneration() {
+    GameState state(2);
+    unsigned int seed = 1;
+    Measure("maze/initialize", [&] { state.Initialize(seed++); });
+
+    struct Algorithm {
+        const char* name;
+        MazeGenerator generator;
+    };
+    const Algorithm algorithms[] = {
+        { "perfect", GeneratePerfectMaze },
+        { "braided", GenerateBraidedMaze },
+        { "scatter", GenerateScatterMaze },
+    };
+    const int sizes[][2] = { { 25, 19 }, { 1000, 1000 } };
+
+    for (const Algorithm& algorithm : algorithms) {
+        for (const auto& size : sizes) {
+            Maze maze(size[0], size[1]);
+            uint64_t mazeSeed = 1;
+            std::string name = std::string("maze/") + algorithm.name + "_" +
+                               std::to_string(size[0]) + "x" + std::to_string(size[1]);
+            Measure(name, 1, [] {}, [&] { GenerateMaze(maze, mazeSeed++, algorithm.generator); });
+            if (Selected(name) && !IsMazeConnected(maze)) {
+                printf("  %s produced a disconnected maze\n", name.c_str());
+            }
+        }
+    }
+}
+
+// Building and bit-packing a full game state packet, and decoding it on the
+// other end
+static void BenchSerialization() {
+    const int counts[] = { 0, 50 };
+    for (int count : counts) {
+        GameState state(2);
+        state.Initialize(1);
+        Rng rng(5);
+        ScatterBullets(state, count, rng);
+
+        GameStatePacket packet;
+        BitWriter writer(WIRE_MAX_PACKET_BYTES);
+        std::string name = "serialize/game_state_" + std::to_string(count);
+        Measure(name, [&] {
+            BuildGameStatePacket(state, packet);
+            writer.Clear();
+            WritePacket(writer, packet);
+            g_sink += writer.Data()[0];
+        });
+        if (Selected(name)) {
+            printf("  %zu bytes on the wire (entities are %zu bytes in memory)\n", writer.Size(),
+                   sizeof(Tank) * packet.tanks.size() + sizeof(Bullet) * packet.bullets.size());
+        }
+
+        // Encode once more in case only the decode bench is selected
+        BuildGameStatePacket(state, packet);
+        writer.Clear();
+        WritePacket(writer, packet);
+        GameStatePacket decoded;
+        Measure("deserialize/game_state_" + std::to_string(count), [&] {
+            BitReader reader(writer.Data(), writer.Size());
+            g_sink += ReadPacket(reader, decoded) ? (int)decoded.bullets.size() : -1;
+        });
+        if (Selected("deserialize/game_state_" + std::to_string(count)) &&
+            (decoded.tanks.size() != packet.tanks.size() || decoded.bullets.size() != packet.bullets.size())) {
+            printf("  decoded %zu tanks and %zu bullets, sent %zu and %zu\n", decoded.tanks.size(),
+                   decoded.bullets.size(), packet.tanks.size(), packet.bullets.size());
+        }
+    }
+}
+
+// Delta-compressed snapshots of a moving tank and 50 bullets, one per tick,
+// with acks arriving 3 snapshots late as on a ~50 ms round trip. Prints the
+// average size against full snapshots and checks that every decoded delta
+// matches the full encoding of the same tick.
+static void BenchSnapshotDelta() {
+    const int TICKS = 240;
+    const int ACK_LAG = 3;
+    GameState state(1);
+    state.Initialize(1);
+    Rng rng(11);
+    std::vector<GameStatePacket> frames(TICKS);
+    for (int t = 0; t < TICKS; t++) {
+        if (t % 80 == 0) {
+            ScatterBullets(state, 50, rng);
+        }
+        state.ApplyInput(0, (uint8_t)(((t / 40) & 1) ? (INPUT_UP | INPUT_LEFT) : (INPUT_DOWN | INPUT_RIGHT)));
+        state.Update();
+        BuildGameStatePacket(state, frames[t]);
+    }
+
+    SnapshotDeltaEncoder encoder;
+    BitWriter writer(WIRE_MAX_PACKET_BYTES);
+    int frame = 0;
+    Measure("snapshot/delta_encode_50", [&] {
+        if (frame == TICKS) {
+            frame = 0;
+            encoder.Reset();
+        }
+        writer.Clear();
+        uint16_t sequence = encoder.Encode(frames[frame++], writer);
+        encoder.Acknowledge((uint16_t)(sequence - ACK_LAG));
+        g_sink += writer.Data()[0];
+    });
+
+    if (!Selected("snapshot/delta_encode_50")) {
+        return;
+    }
+    SnapshotDeltaDecoder decoder;
+    encoder.Reset();
+    size_t fullBytes = 0, deltaBytes = 0;
+    int mismatches = 0;
+    for (int t = 0; t < TICKS; t++) {
+        BitWriter full(WIRE_MAX_PACKET_BYTES);
+        WritePacket(full, frames[t]);
+        fullBytes += full.Size();
+
+        writer.Clear();
+        uint16_t sequence = encoder.Encode(frames[t], writer);
+        deltaBytes += writer.Size();
+        if (t >= ACK_LAG) {
+            encoder.Acknowledge((uint16_t)(sequence - ACK_LAG));
+        }
+
+        // The decoded snapshot must re-encode to the same bytes
+        GameStatePacket decoded;
+        BitReader deltaReader(writer.Data(), writer.Size());
+        BitWriter check(WIRE_MAX_PACKET_BYTES);
+        if (decoder.Decode(deltaReader, decoded)) {
+            WritePacket(check, decoded);
+        }
+        if (check.Size() != full.Size() || memcmp(check.Data(), full.Data(), full.Size()) != 0) {
+            mismatches++;
+        }
+    }
+    printf("  %.0f bytes/snapshot full, %.0f delta (%u full, %u delta)\n", (double)fullBytes / TICKS,
+           (double)deltaBytes / TICKS, encoder.FullSnapshots(), encoder.DeltaSnapshots());
+    if (mismatches) {
+        printf("  %d decoded snapshots differ from the full encoding\n", mismatches);
+    }
+}
+
+// Counts what a framed stream delivered, checking inputs arrive in order
+struct FrameTally {
+    uint32_t nextTick;
+    int inputs;
+    int states;
+    int errors;
+};
+
+static void TallyInput(void* context, const uint8_t* data, size_t size) {
+    FrameTally& tally = *(FrameTally*)context;
+    BitReader reader(data, size);
+    InputPacket packet;
+    if (!ReadPacket(reader, packet) || packet.tick != tally.nextTick) {
+        tally.errors++;
+    }
+    tally.nextTick = packet.tick + 1;
+    tally.inputs++;
+}
+
+static void TallyGameState(void* context, const uint8_t* data, size_t size) {
+    FrameTally& tally = *(FrameTally*)context;
+    BitReader reader(data, size);
+    GameStatePacket packet;
+    if (!ReadPacket(reader, packet)) {
+        tally.errors++;
+    }
+    tally.states++;
+}
+
+// Framing a TCP stream: 256 frames (mostly inputs, every eighth a full game
+// state with 50 bullets) arriving in segments cut at arbitrary byte
+// offsets, as recv() returns them, each appended to the connection's buffer
+// and every complete frame dispatched by type. Then the same frames go over
+// a real loopback TCP connection and must all arrive intact and in order.
+static void BenchFraming() {
+    const char* name = "framing/split_stream_256";
+    if (!Selected(name)) {
+        return;
+    }
+    const int FRAMES = 256;
+    GameState state(2);
+    state.Initialize(1);
+    Rng rng(17);
+    ScatterBullets(state, 50, rng);
+    GameStatePacket statePacket;
+    BuildGameStatePacket(state, statePacket);
+
+    FrameWriter stream(1 << 20);
+    for (int i = 0; i < FRAMES; i++) {
+        if (i % 8 == 7) {
+            stream.AppendPacket(statePacket);
+        } else {
+            InputPacket input;
+            input.tick = (uint32_t)(i - i / 8);
+            input.buttons = (uint8_t)(i & 31);
+            stream.AppendPacket(input);
+        }
+    }
+    std::vector<uint8_t> bytes(stream.Pending(), stream.Pending() + stream.PendingSize());
+    std::vector<size_t> cuts;
+    for (size_t at = 0; at < bytes.size();) {
+        cuts.push_back(at);
+        at += 1 + rng.NextBelow(1460);
+    }
+    cuts.push_back(bytes.size());
+
+    PacketDispatcher dispatcher;
+    dispatcher.Register(PACKET_INPUT, TallyInput);
+    dispatcher.Register(PACKET_GAME_STATE, TallyGameState);
+    FrameReader reader;
+    FrameTally tally = {};
+    Measure(name, 10, [] {}, [&] {
+        reader.Reset();
+        tally = FrameTally();
+        for (size_t i = 0; i + 1 < cuts.size(); i++) {
+            reader.Append(bytes.data() + cuts[i], cuts[i + 1] - cuts[i]);
+            reader.DispatchFrames(dispatcher, &tally);
+        }
+        g_sink += tally.inputs;
+    });
+    printf("  %zu bytes in %zu segments, %d inputs and %d states per pass\n", bytes.size(), cuts.size() - 1,
+           tally.inputs, tally.states);
+    if (tally.errors || tally.inputs + tally.states != FRAMES || reader.Buffered() != 0) {
+        printf("  split stream lost sync: %d errors, %d frames\n", tally.errors, tally.inputs + tally.states);
+    }
+
+    // The same frames, 100 passes, over loopback TCP
+    const int PASSES = 100;
+    NetStartup();
+    NetSocket listener = OpenTcpListener(0, 1);
+    NetSocket client = NET_INVALID_SOCKET;
+    NetSocket server = NET_INVALID_SOCKET;
+    if (listener != NET_INVALID_SOCKET) {
+        client = ConnectStream(NetAddress::Loopback(LocalPort(listener)));
+    }
+    NetAddress from;
+    for (int i = 0; i < 1000 && client != NET_INVALID_SOCKET && server == NET_INVALID_SOCKET; i++) {
+        server = AcceptStream(listener, from);
+    }
+    if (server == NET_INVALID_SOCKET) {
+        printf("  no loopback TCP connection, skipping the socket check\n");
+    } else {
+        FrameWriter writer(bytes.size() * 2);
+        reader.Reset();
+        tally = FrameTally();
+        int passesQueued = 0;
+        int receives = 0;
+        bool failed = false;
+        while (!failed && tally.inputs + tally.states < FRAMES * PASSES) {
+            if (passesQueued < PASSES && writer.PendingSize() <= bytes.size()) {
+                for (int i = 0; i < FRAMES; i++) {
+                    // Re-number inputs so the order check spans passes
+                    if (i % 8 == 7) {
+                        writer.AppendPacket(statePacket);
+                    } else {
+                        InputPacket input;
+                        input.tick = (uint32_t)(passesQueued * (FRAMES - FRAMES / 8) + i - i / 8);
+                        writer.AppendPacket(input);
+                    }
+                }
+                passesQueued++;
+            }
+            int received = reader.Receive(server);
+            if (!writer.Flush(client) || received < 0 || reader.Corrupt()) {
+                failed = true;
+            }
+            if (received > 0) {
+                receives++;
+                reader.DispatchFrames(dispatcher, &tally);
+            }
+        }
+        int frames = tally.inputs + tally.states;
+        printf("  loopback TCP: %d frames in %d recv calls (%.1f per call)\n", frames, receives,
+               receives ? (double)frames / receives : 0.0);
+        if (failed || tally.errors) {
+            printf("  loopback TCP stream broke: %d errors\n", tally.errors);
+        }
+    }
+    CloseSocket(client);
+    CloseSocket(server);
+    CloseSocket(listener);
+    NetCleanup();
+}
+
+// One 60 Hz network tick between two connections over loopback sockets:
+// each side queues its input and a snapshot-sized latest message, sends a
+// datagram and reads what arrived. A tenth of the datagrams each way are
+// dropped before sending; the check afterwards confirms every input tick,
+// every reliable message and a never-regressing latest message still arrive,
+// including after a burst of 20 consecutive lost host datagrams.
+static void BenchUdpTransport() {
+    const char* name = "udp/loopback_tick";
+    if (!Selected(name)) {
+        return;
+    }
+    const int LOSS_PERCENT = 10;
+    NetStartup();
+    NetSocket hostSocket = OpenUdpSocket(0);
+    NetSocket clientSocket = OpenUdpSocket(0);
+    if (hostSocket == NET_INVALID_SOCKET || clientSocket == NET_INVALID_SOCKET) {
+        printf("  no loopback sockets, skipping %s\n", name);
+        CloseSocket(hostSocket);
+        CloseSocket(clientSocket);
+        return;
+    }
+    NetAddress hostAddress = NetAddress::Loopback(LocalPort(hostSocket));
+    NetAddress clientAddress = NetAddress::Loopback(LocalPort(clientSocket));
+
+    UdpConnection host, client;
+    Rng rng(5);
+    uint8_t snapshot[200] = {};
+    uint8_t buffer[UDP_MAX_DATAGRAM];
+    std::vector<uint8_t> message;
+    uint32_t tick = 0;
+    double now = 0;
+
+    // Delivery state checked after the run
+    uint32_t nextInput = 0;
+    uint32_t nextReliable = 0;
+    uint32_t lastLatest = 0;
+    int errors = 0;
+    int burst = 0;                  // Host datagrams still to drop in a row
+
+    auto exchange = [&] {
+        now += 1.0 / 60.0;
+        host.QueueInput(tick, (uint8_t)(tick & 31));
+        if (tick % 50 == 0) {
+            uint32_t id = tick / 50;
+            if (!host.SendReliable((const uint8_t*)&id, sizeof(id))) {
+                errors++;
+            }
+        }
+        memcpy(snapshot, &tick, sizeof(tick));
+        host.SendLatest(snapshot, sizeof(snapshot));
+        client.QueueInput(tick, 0);
+        tick++;
+
+        BitWriter writer(UDP_MAX_DATAGRAM);
+        host.WriteDatagram(writer, now);
+        bool lost = burst > 0 ? (burst--, true) : (int)rng.NextBelow(100) < LOSS_PERCENT;
+        if (!lost) {
+            SendDatagram(hostSocket, clientAddress, writer.Data(), (int)writer.Size());
+        }
+        writer.Clear();
+        client.WriteDatagram(writer, now);
+        if ((int)rng.NextBelow(100) >= LOSS_PERCENT) {
+            SendDatagram(clientSocket, hostAddress, writer.Data(), (int)writer.Size());
+        }
+
+        NetAddress from;
+        int size;
+        while ((size = ReceiveDatagram(clientSocket, from, buffer, sizeof(buffer))) >= 0) {
+            client.ReadDatagram(buffer, size, now);
+        }
+        while ((size = ReceiveDatagram(hostSocket, from, buffer, sizeof(buffer))) >= 0) {
+            host.ReadDatagram(buffer, size, now);
+        }
+
+        uint32_t inputTick;
+        uint8_t buttons;
+        while (client.PopInput(inputTick, buttons)) {
+            if (inputTick != nextInput || buttons != (inputTick & 31)) {
+                errors++;
+            }
+            nextInput = inputTick + 1;
+        }
+        while (client.PopReliable(message)) {
+            uint32_t id;
+            memcpy(&id, message.data(), sizeof(id));
+            if (id != nextReliable) {
+                errors++;
+            }
+            nextReliable = id + 1;
+        }
+        if (client.TakeLatest(message)) {
+            uint32_t latest;
+            memcpy(&latest, message.data(), sizeof(latest));
+            if (latest < lastLatest) {
+                errors++;
+            }
+            lastLatest = latest;
+        }
+        while (host.PopInput(inputTick, buttons)) {
+        }
+    };
+    Measure(name, exchange);
+
+    // Lose a burst, settle the last ticks, then every input and reliable
+    // message sent must have been delivered exactly once and in order
+    burst = 20;
+    for (int i = 0; i < 60; i++) {
+        exchange();
+    }
+    printf("  %u ticks, %llu datagrams sent, %llu acked, rtt %.1f ms\n", tick,
+           (unsigned long long)host.DatagramsSent(), (unsigned long long)host.DatagramsAcked(),
+           host.RoundTripTime() * 1000.0);
+    if (errors || nextInput + 30 < tick || nextReliable + 1 < (tick + 49) / 50) {
+        printf("  delivery broken: %d errors, inputs through %u, reliable through %u\n", errors, nextInput,
+               nextReliable);
+    }
+    CloseSocket(hostSocket);
+    CloseSocket(clientSocket);
+    NetCleanup();
+}
+
+// Handing messages between the simulation and the network thread. The
+// queue bench pushes one item per op while another thread pops them; the
+// network thread bench is the simulation's whole cost of sending one tick's
+// input over a running loopback connection. A host and a client thread then
+// exchange 300 ticks, the first ones sent into a full command queue, and
+// every input must arrive once and in order.
+static void BenchNetworkThread() {
+    if (Selected("spsc/cross_thread_push")) {
+        std::unique_ptr<SpscQueue<uint64_t, 1024>> queue(new SpscQueue<uint64_t, 1024>());
+        std::atomic<bool> done(false);
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        uint64_t outOfOrder = 0;
+        std::thread consumer([&] {
+            uint64_t value;
+            while (!done.load(std::memory_order_relaxed) || queue->SizeApprox() > 0) {
+                while (queue->TryPop(value)) {
+                    outOfOrder += value != popped;
+                    popped++;
+                }
+                std::this_thread::yield();
+            }
+        });
+        Measure("spsc/cross_thread_push", [&] {
+            while (!queue->TryPush(pushed)) {
+                std::this_thread::yield();
+            }
+            pushed++;
+        });
+        done.store(true);
+        consumer.join();
+        if (popped != pushed || outOfOrder) {
+            printf("  queue lost items: %llu pushed, %llu popped, %llu out of order\n",
+                   (unsigned long long)pushed, (unsigned long long)popped, (unsigned long long)outOfOrder);
+        }
+    }
+
+    const char* name = "net_thread/send_input";
+    if (!Selected(name)) {
+        return;
+    }
+    NetStartup();
+    std::unique_ptr<NetworkThread> host(new NetworkThread());
+    std::unique_ptr<NetworkThread> client(new NetworkThread());
+    if (!host->StartHost(0) || !client->StartClient(NetAddress::Loopback(host->Port()))) {
+        printf("  no loopback sockets, skipping %s\n", name);
+        NetCleanup();
+        return;
+    }
+    uint32_t tick = 0;
+    Measure(name, [&] {
+        client->SendInput(tick++, 0);
+        client->Flush();
+    });
+    printf("  %llu of %u inputs refused: sent faster than the peer acks them\n",
+           (unsigned long long)client->CommandsDropped(), tick);
+
+    // A fresh pair at roughly 1000 ticks/s. The command queue starts full,
+    // so the first inputs have to wait for room, yet every tick must still
+    // arrive in order.
+    const uint32_t TICKS = 300;
+    const uint32_t WAITING_TICKS = 16;
+    host->StartHost(0);
+    client->StartClient(NetAddress::Loopback(host->Port()));
+    uint8_t filler[8] = {};
+    while (client->SendLatest(filler, sizeof(filler))) {
+    }
+    for (uint32_t t = 0; t < WAITING_TICKS; t++) {
+        client->SendInput(t, (uint8_t)(t & 31));
+    }
+    size_t waited = client->InputsWaiting();
+    bool joined = false;
+    uint32_t nextTick = 0;
+    int errors = 0;
+    auto drain = [&] {
+        while (const NetEvent* event = host->PeekEvent()) {
+            if (event->type == NET_PEER_JOINED) {
+                joined = true;
+            } else if (event->type == NET_INPUT) {
+                errors += event->tick != nextTick || event->buttons != (event->tick & 31);
+                nextTick = event->tick + 1;
+            }
+            host->PopEvent();
+        }
+    };
+    for (uint32_t t = WAITING_TICKS; t < TICKS; t++) {
+        client->SendInput(t, (uint8_t)(t & 31));
+        client->Flush();
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 500 && nextTick < TICKS; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        drain();
+    }
+    printf("  loopback threads: %u of %u ticks delivered, %zu waited for a full queue, %llu datagrams sent\n",
+           nextTick, TICKS, waited, (unsigned long long)client->DatagramsSent());
+    if (!joined || errors || nextTick != TICKS || waited == 0) {
+        printf("  network thread delivery broken: %d errors\n", errors);
+    }
+    client->Stop();
+    host->Stop();
+    NetCleanup();
+}
+
+// Cost of correcting a misprediction: restore a snapshot and re-simulate the
+// rollback window, against a 60 Hz frame of 16.7 ms
+static void BenchRollback() {
+    const int depths[] = { 1, 4, 8, 10 };
+    for (int depth : depths) {
+        GameState state(2);
+        state.Initialize(1);
+        RollbackSession session(state, 0, depth);
+        int round = 0;
+
+        Measure("rollback/resim_" + std::to_string(depth), 1,
+                [&] {
+                    // Run ahead of the remote player, predicted to repeat its last input...
+                    if (state.gameOver) {
+                        state.Initialize((unsigned int)round + 2);
+                        session.Reset(0);
+                    }
+                    uint32_t first = state.tick;
+                    for (int t = 0; t < depth; t++) {
+                        uint8_t buttons = (uint8_t)(((state.tick / 30) & 1) ? INPUT_LEFT : INPUT_RIGHT);
+                        if (state.tick % 7 == 0) {
+                            buttons |= INPUT_FIRE;
+                        }
+                        session.AdvanceTick(buttons);
+                    }
+                    // ...then learn it changed direction right away
+                    uint8_t remote = (uint8_t)((round++ & 1) ? (INPUT_UP | INPUT_FIRE) : INPUT_DOWN);
+                    for (int t = 0; t < depth; t++) {
+                        session.AddRemoteInput(1, first + t, remote);
+                    }
+                },
+                [&] { session.Synchronize(); });
+    }
+}
+
+// Flow-field pathfinding: a full BFS rebuild, and the per-tick cost of 64
+// bots chasing 4 wandering targets (16 bots share each field) on a large maze
+static void BenchNavigation() {
+    const int sizes[][2] = { { 25, 19 }, { 1000, 1000 } };
+    for (const auto& size : sizes) {
+        Maze maze(size[0], size[1]);
+        GenerateMaze(maze, 1, GenerateBraidedMaze);
+        std::string suffix = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+
+        FlowField field;
+        field.Reset(maze);
+        int target = 0;
+        Measure("nav/build_" + suffix, 1, [] {}, [&] {
+            field.SetTarget(1 + (target++ % (size[0] - 2)) / 2 * 2, 1);
+            field.Build(maze);
+        });
+
+        // Bots and targets walk one cell every 8 ticks; targets wander at random
+        const int TARGETS = 4;
+        const int BOTS = 64;
+        const int CELL_TICKS = 8;
+        Rng rng(11);
+        auto randomOpenCell = [&](int& x, int& y) {
+            do {
+                x = 1 + (int)rng.NextBelow((uint32_t)maze.Width() - 2);
+                y = 1 + (int)rng.NextBelow((uint32_t)maze.Height() - 2);
+            } while (maze.IsWall(x, y));
+        };
+        int targetX[TARGETS], targetY[TARGETS], botX[BOTS], botY[BOTS];
+        for (int t = 0; t < TARGETS; t++) {
+            randomOpenCell(targetX[t], targetY[t]);
+        }
+        for (int b = 0; b < BOTS; b++) {
+            randomOpenCell(botX[b], botY[b]);
+        }
+
+        NavigationService navigation;
+        navigation.Rebuild(maze);
+        int fields[TARGETS];
+        for (int t = 0; t < TARGETS; t++) {
+            fields[t] = navigation.FieldFor(t);
+            navigation.MoveTarget(fields[t], (targetX[t] + 0.5f) * WALL_SIZE, (targetY[t] + 0.5f) * WALL_SIZE);
+        }
+
+        uint32_t tick = 0;
+        Measure("nav/64_bots_" + suffix, [&] {
+            tick++;
+            for (int t = 0; t < TARGETS; t++) {
+                if ((tick + t) % CELL_TICKS == 0) {
+                    static const int stepX[4] = { 0, 0, -1, 1 };
+                    static const int stepY[4] = { -1, 1, 0, 0 };
+                    int d = (int)rng.NextBelow(4);
+                    if (!maze.IsWall(targetX[t] + stepX[d], targetY[t] + stepY[d])) {
+                        targetX[t] += stepX[d];
+                        targetY[t] += stepY[d];
+                    }
+                }
+                navigation.MoveTarget(fields[t], (targetX[t] + 0.5f) * WALL_SIZE, (targetY[t] + 0.5f) * WALL_SIZE);
+            }
+            navigation.Update();
+
+            for (int b = 0; b < BOTS; b++) {
+                uint8_t buttons = navigation.Steer(fields[b % TARGETS], (botX[b] + 0.5f) * WALL_SIZE,
+                                                   (botY[b] + 0.5f) * WALL_SIZE);
+                if ((tick + b) % CELL_TICKS == 0) {
+                    botX[b] += ((buttons & INPUT_RIGHT) ? 1 : 0) - ((buttons & INPUT_LEFT) ? 1 : 0);
+                    botY[b] += ((buttons & INPUT_DOWN) ? 1 : 0) - ((buttons & INPUT_UP) ? 1 : 0);
+                }
+                g_sink += buttons;
+            }
+        });
+    }
+}
+
+// Shot planning between tanks placed on random open cells of the standard
+// arena. Every plan found is replayed through GameState::Update to check
+// that the bullet really does hit.
+static void BenchShotSolver() {
+    const int PAIRS = 64;
+    GameState fixture(2);
+    fixture.Initialize(1);
+    Rng rng(13);
+    std::vector<float> positions;
+    while ((int)positions.size() < PAIRS * 4) {
+        int cellX = (int)rng.NextBelow(GameState::MAZE_WIDTH);
+        int cellY = (int)rng.NextBelow(GameState::MAZE_HEIGHT);
+        if (!fixture.IsWall(cellX, cellY)) {
+            positions.push_back((float)(cellX * WALL_SIZE));
+            positions.push_back((float)(cellY * WALL_SIZE));
+        }
+    }
+    auto place = [&](GameState& state, int pair) {
+        for (int p = 0; p < 2; p++) {
+            state.tanks[p] = Tank(positions[pair * 4 + p * 2], positions[pair * 4 + p * 2 + 1], p + 1);
+        }
+        state.RebuildTankHash();
+    };
+
+    const int angleCounts[] = { 64, 256 };
+    for (int angles : angleCounts) {
+        ShotSolver solver(angles);
+        GameState state = fixture;
+        std::string name = "shot/solve_" + std::to_string(angles);
+        int pair = 0;
+        Measure(name, [&] {
+            place(state, pair);
+            g_sink += solver.SolveTanks(state, 0, 1).ticks;
+            pair = (pair + 1) % PAIRS;
+        });
+
+        if (!Selected(name)) {
+            continue;
+        }
+        int found = 0, landed = 0;
+        for (int p = 0; p < PAIRS; p++) {
+            place(state, p);
+            ShotPlan plan = solver.SolveTanks(state, 0, 1);
+            if (!plan.found) {
+                continue;
+            }
+            found++;
+            GameState check = state;
+            check.tanks[0].rotation = plan.angle;
+            check.ApplyInput(0, INPUT_FIRE);
+            for (int t = 0; t < plan.ticks && check.tanks[1].alive; t++) {
+                check.Update();
+            }
+            landed += !check.tanks[1].alive;
+        }
+        printf("  %d/%d pairs have a shot, %d of them land in the simulation\n", found, PAIRS, landed);
+    }
+}
+
+// Per-frame maze work of a window-sized view: the standard map walked whole,
+// against a 2000x2000 chunked arena with the camera panning across it and
+// chunks streamed in and dropped as it goes. Generating one chunk is timed
+// separately.
+static void BenchView() {
+    GameState state(2);
+    state.Initialize(1);
+    Camera camera;
+    Measure("view/walls_25x19", [&] {
+        ForEachVisibleWall(state.maze, camera, [&](int x, int y) { g_sink += x + y; });
+    });
+
+    const int SIZE = 2000;
+    const int WORLD = SIZE * WALL_SIZE;
+    ChunkedMaze arena(SIZE, SIZE, 1);
+    float panX = 0;
+    float panY = 0;
+    Measure("view/walls_2000x2000", [&] {
+        // Diagonal sweep, wrapping at the far corner
+        panX = (panX < WORLD) ? panX + 7.0f : 0.0f;
+        panY = (panY < WORLD) ? panY + 5.0f : 0.0f;
+        camera.Follow(panX, panY, WORLD, WORLD);
+
+        int x0, y0, x1, y1;
+        camera.VisibleCells(x0, y0, x1, y1);
+        arena.UnloadOutside(x0 - MAZE_CHUNK_SIZE, y0 - MAZE_CHUNK_SIZE, x1 + MAZE_CHUNK_SIZE, y1 + MAZE_CHUNK_SIZE);
+        arena.ForEachWall(x0, y0, x1, y1, [&](int x, int y) { g_sink += x + y; });
+    });
+    if (Selected("view/walls_2000x2000")) {
+        printf("  %d of %d chunks loaded\n", arena.LoadedCount(), arena.ChunksX() * arena.ChunksY());
+    }
+
+    int chunk = 0;
+    Measure("view/chunk_load", 1,
+            [&] { arena.UnloadOutside(-1, -1, -1, -1); },
+            [&] {
+                int cell = (chunk++ % (SIZE / MAZE_CHUNK_SIZE)) * MAZE_CHUNK_SIZE;
+                arena.Load(cell, cell, cell, cell);
+            });
+}
+
+static bool WriteJson(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\n  \"repetitions\": %d,\n  \"min_time_s\": %g,\n  \"benchmarks\": [\n",
+            g_repetitions, g_minRepSeconds);
+    for (size_t i = 0; i < g_results.size(); i++) {
+        const BenchResult& r = g_results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"ns_per_op\": %.3f, \"stddev_ns\": %.3f, "
+                      "\"min_ns\": %.3f, \"median_ns\": %.3f, \"ops\": %lld }%s\n",
+                r.name.c_str(), r.meanNs, r.stddevNs, r.minNs, r.medianNs, r.ops,
+                (i + 1 < g_results.size()) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+static void PrintUsage() {
+    printf("Usage: trouble_bench [--reps N] [--min-time S] [--json FILE] [name...]\n");
+    printf("  --reps N      Timed repetitions per benchmark (default 10)\n");
+    printf("  --min-time S  Minimum seconds per repetition (default 0.05)\n");
+    printf("  --json FILE   Also write the results as JSON\n");
+    printf("  name          Run only benchmarks whose name starts with this\n");
+}
+
+int main(int argc, char** argv) {
+    const char* jsonPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            g_repetitions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            g_minRepSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        } else {
+            g_filters.push_back(argv[i]);
+        }
+    }
+    if (g_repetitions < 1) {
+        g_repetitions = 1;
+    }
+
+    BenchUpdate();
+    BenchArena<StandardArena>();
+    BenchArena<LargeArena>();
+    BenchArena<HugeArena>();
+    BenchCollision();
+    BenchExplosion();
+    BenchParticles();
+    BenchMazeGeneration();
+    BenchSerialization();
+    BenchFraming();
+    BenchSnapshotDelta();
+    BenchUdpTransport();
+    BenchNetworkThread();
+    BenchRollback();
+    BenchNavigation();
+    BenchShotSolver();
+    BenchView();
+
+    if (jsonPath && !WriteJson(jsonPath)) {
+        fprintf(stderr, "trouble_bench: cannot write %s\n", jsonPath);
+        return 1;
+    }
+    return 0;
+}
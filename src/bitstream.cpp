@@ -0,0 +1,114 @@
+#include "bitstream.h"
+#include <cstring>
+
+// Largest value representable in bits (1..32)
+static uint32_t MaxValue(int bits) {
+    return (bits >= 32) ? 0xFFFFFFFFu : ((1u << bits) - 1);
+}
+
+// Little-endian 64-bit access to an unaligned byte position
+static inline uint64_t LoadWord(const uint8_t* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    uint64_t word = 0;
+    for (int i = 0; i < 8; i++) {
+        word |= (uint64_t)p[i] << (8 * i);
+    }
+    return word;
+#else
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+#endif
+}
+
+static inline void StoreWord(uint8_t* p, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (int i = 0; i < 8; i++) {
+        p[i] = (uint8_t)(word >> (8 * i));
+    }
+#else
+    memcpy(p, &word, sizeof(word));
+#endif
+}
+
+// BitWriter methods
+void BitWriter::WriteBits(uint32_t value, int bits) {
+    // Accumulate in a 64-bit scratch word and store all of it at the current
+    // 32-bit boundary on every write. Only stores touch the buffer, so there
+    // is no read-modify-write of bytes that were just written.
+    scratch |= (uint64_t)(value & MaxValue(bits)) << scratchBits;
+    scratchBits += bits;
+    if (flushedBytes + 8 > bytes.size()) {
+        bytes.resize(bytes.size() * 2 + 16);
+    }
+    StoreWord(&bytes[flushedBytes], scratch);
+    if (scratchBits >= 32) {
+        scratch >>= 32;
+        scratchBits -= 32;
+        flushedBytes += 4;
+    }
+}
+
+void BitWriter::WriteVarUint(uint32_t value) {
+    do {
+        WriteBits(value & 15, 4);
+        value >>= 4;
+        WriteBool(value != 0);
+    } while (value != 0);
+}
+
+void BitWriter::WriteQuantized(float value, float min, float max, int bits) {
+    WriteBits(Quantize(value, min, max, bits), bits);
+}
+
+// BitReader methods
+uint32_t BitReader::ReadBits(int bits) {
+    if (overflowed || (size_t)bits > BitsLeft()) {
+        overflowed = true;
+        return 0;
+    }
+    size_t first = bitPosition >> 3;
+    int offset = (int)(bitPosition & 7);
+    bitPosition += bits;
+    uint64_t word;
+    if (first + 8 <= size) {
+        word = LoadWord(data + first);
+    } else {
+        // Near the end of the data: gather the remaining bytes one at a time
+        word = 0;
+        for (size_t i = first; i < size; i++) {
+            word |= (uint64_t)data[i] << (8 * (i - first));
+        }
+    }
+    return (uint32_t)(word >> offset) & MaxValue(bits);
+}
+
+uint32_t BitReader::ReadVarUint() {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 32; shift += 4) {
+        value |= ReadBits(4) << shift;
+        if (!ReadBool()) {
+            return value;
+        }
+    }
+    overflowed = true; // More groups than a uint32_t holds
+    return 0;
+}
+
+float BitReader::ReadQuantized(float min, float max, int bits) {
+    return Dequantize(ReadBits(bits), min, max, bits);
+}
+
+// Quantization
+uint32_t Quantize(float value, float min, float max, int bits) {
+    if (!(value > min)) value = min;   // Also catches NaN
+    if (value > max) value = max;
+    // value >= min here, so truncation rounds to the nearest step
+    double scale = (double)MaxValue(bits) / ((double)max - min);
+    return (uint32_t)(((double)value - min) * scale + 0.5);
+}
+
+float Dequantize(uint32_t value, float min, float max, int bits) {
+    double step = ((double)max - min) / (double)MaxValue(bits);
+    return (float)(min + value * step);
+}
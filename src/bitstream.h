@@ -0,0 +1,77 @@
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Map a float clamped to [min, max] onto bits (1..32) evenly spaced steps
+uint32_t Quantize(float value, float min, float max, int bits);
+
+// Value of a quantized step
+float Dequantize(uint32_t value, float min, float max, int bits);
+
+// Bit-level writer for the wire format.
+// Values are appended least significant bit first into consecutive bytes, so
+// the encoding depends only on the values written and never on the
+// compiler's struct layout or the host's byte order. The last byte is zero
+// padded. A reused writer keeps its buffer, so it does not reallocate.
+class BitWriter {
+public:
+    explicit BitWriter(size_t reserveBytes = 256)
+        : bytes(reserveBytes + 8), scratch(0), scratchBits(0), flushedBytes(0) {}
+
+    // Append the low bits (1..32) of value
+    void WriteBits(uint32_t value, int bits);
+
+    void WriteBool(bool value) { WriteBits(value ? 1u : 0u, 1); }
+
+    // Unsigned integer in 4-bit groups, each followed by a continuation bit;
+    // small counts cost 5 bits
+    void WriteVarUint(uint32_t value);
+
+    // Float written as Quantize(value, min, max, bits)
+    void WriteQuantized(float value, float min, float max, int bits);
+
+    // Drop everything written so far, keeping the buffer
+    void Clear() { scratch = 0; scratchBits = 0; flushedBytes = 0; }
+
+    const uint8_t* Data() const { return bytes.data(); }
+    size_t Size() const { return (BitCount() + 7) >> 3; }  // Whole bytes, last one padded
+    size_t BitCount() const { return flushedBytes * 8 + scratchBits; }
+
+private:
+    std::vector<uint8_t> bytes;     // Written bytes plus room for one 64-bit store
+    uint64_t scratch;               // Bits not yet past a 32-bit boundary
+    int scratchBits;
+    size_t flushedBytes;            // Bytes complete in the buffer, a multiple of 4
+};
+
+// Reads what BitWriter wrote. Reading past the end returns zeros and sets
+// Overflowed(), so a parser can run to completion and check once at the end.
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size), bitPosition(0), overflowed(false) {}
+
+    uint32_t ReadBits(int bits);
+
+    bool ReadBool() { return ReadBits(1) != 0; }
+
+    uint32_t ReadVarUint();
+
+    float ReadQuantized(float min, float max, int bits);
+
+    // Did any read run past the end of the data?
+    bool Overflowed() const { return overflowed; }
+
+    // Bits left to read
+    size_t BitsLeft() const { return size * 8 - bitPosition; }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t bitPosition;
+    bool overflowed;
+};
+
+#endif // BITSTREAM_H
@@ -0,0 +1,79 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <cmath>
+#include "game.h"
+#include "maze.h"
+
+// View onto a world that may be larger than the window.
+// The camera is a rectangle in world pixels; rendering subtracts its corner
+// from world positions and skips anything the rectangle does not overlap, so
+// the cost of a frame follows the size of the view rather than of the world.
+// When the world fits in the view the camera stays at the origin and nothing
+// is culled.
+struct Camera {
+    float x, y;           // World position of the top-left corner of the view
+    int width, height;    // View size in pixels
+
+    explicit Camera(int viewWidth = WINDOW_WIDTH, int viewHeight = WINDOW_HEIGHT)
+        : x(0), y(0), width(viewWidth), height(viewHeight) {}
+
+    // Center the view on a world point, kept inside a world of the given size
+    void Follow(float targetX, float targetY, int worldWidth, int worldHeight) {
+        x = Clamp(targetX - width / 2.0f, (float)(worldWidth - width));
+        y = Clamp(targetY - height / 2.0f, (float)(worldHeight - height));
+    }
+
+    // Does the view overlap the world box, grown by margin on every side?
+    bool Sees(float left, float top, float right, float bottom, float margin = 0) const {
+        return right >= x - margin && left <= x + width + margin &&
+               bottom >= y - margin && top <= y + height + margin;
+    }
+
+    // Inclusive range of WALL_SIZE cells the view overlaps
+    void VisibleCells(int& cellX0, int& cellY0, int& cellX1, int& cellY1) const {
+        cellX0 = (int)floorf(x / WALL_SIZE);
+        cellY0 = (int)floorf(y / WALL_SIZE);
+        cellX1 = (int)floorf((x + width - 1) / WALL_SIZE);
+        cellY1 = (int)floorf((y + height - 1) / WALL_SIZE);
+    }
+
+    // Screen position of a world position
+    int ScreenX(float worldX) const { return (int)floorf(worldX - x); }
+    int ScreenY(float worldY) const { return (int)floorf(worldY - y); }
+
+private:
+    // Keep a corner coordinate in [0, limit]; a world smaller than the view pins it to 0
+    static float Clamp(float value, float limit) {
+        if (value > limit) value = limit;
+        if (value < 0) value = 0;
+        return value;
+    }
+};
+
+// Call fn(cellX, cellY) for every wall cell of the maze inside the camera's
+// view, reading the visible part of each row up to 64 cells at a time
+template <typename Fn>
+void ForEachVisibleWall(const Maze& maze, const Camera& camera, Fn fn) {
+    int x0, y0, x1, y1;
+    camera.VisibleCells(x0, y0, x1, y1);
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= maze.Width()) x1 = maze.Width() - 1;
+    if (y1 >= maze.Height()) y1 = maze.Height() - 1;
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x += 64) {
+            uint64_t bits = maze.RowBits(y, x, (x1 - x + 1 < 64) ? x1 - x + 1 : 64);
+            while (bits) {
+                fn(x + LowestSetBit(bits), y);
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+
+#endif // CAMERA_H
@@ -0,0 +1,95 @@
+#include "chunked_maze.h"
+#include "rng.h"
+
+ChunkedMaze::ChunkedMaze(int width, int height, uint64_t seed, MazeGenerator generator)
+    : width(width < 1 ? 1 : width), height(height < 1 ? 1 : height), seed(seed),
+      generator(generator) {
+    chunksX = (this->width + MAZE_CHUNK_SIZE - 1) / MAZE_CHUNK_SIZE;
+    chunksY = (this->height + MAZE_CHUNK_SIZE - 1) / MAZE_CHUNK_SIZE;
+    chunks.resize((size_t)chunksX * chunksY);
+}
+
+bool ChunkedMaze::IsWall(int x, int y) {
+    if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) {
+        return true;
+    }
+    const Chunk& chunk = ChunkAt(x / MAZE_CHUNK_SIZE, y / MAZE_CHUNK_SIZE);
+    return (chunk.rows[y % MAZE_CHUNK_SIZE] >> (x % MAZE_CHUNK_SIZE)) & 1;
+}
+
+bool ChunkedMaze::Loaded(int chunkX, int chunkY) const {
+    if ((unsigned)chunkX >= (unsigned)chunksX || (unsigned)chunkY >= (unsigned)chunksY) {
+        return false;
+    }
+    return chunks[(size_t)chunkY * chunksX + chunkX] != nullptr;
+}
+
+void ChunkedMaze::Load(int x0, int y0, int x1, int y1) {
+    ForEachWall(x0, y0, x1, y1, [](int, int) {});
+}
+
+void ChunkedMaze::UnloadOutside(int x0, int y0, int x1, int y1) {
+    // Only the resident list is walked, so the cost is independent of the world size
+    size_t i = 0;
+    while (i < resident.size()) {
+        int index = resident[i];
+        int left = (index % chunksX) * MAZE_CHUNK_SIZE;
+        int top = (index / chunksX) * MAZE_CHUNK_SIZE;
+        bool overlaps = left + MAZE_CHUNK_SIZE - 1 >= x0 && left <= x1 &&
+                        top + MAZE_CHUNK_SIZE - 1 >= y0 && top <= y1;
+        if (overlaps) {
+            i++;
+            continue;
+        }
+        chunks[index].reset();
+        resident[i] = resident.back();
+        resident.pop_back();
+    }
+}
+
+const ChunkedMaze::Chunk& ChunkedMaze::ChunkAt(int chunkX, int chunkY) {
+    int index = chunkY * chunksX + chunkX;
+    std::unique_ptr<Chunk>& chunk = chunks[index];
+    if (!chunk) {
+        chunk.reset(new Chunk());
+        Generate(chunkX, chunkY, *chunk);
+        resident.push_back(index);
+    }
+    return *chunk;
+}
+
+void ChunkedMaze::Generate(int chunkX, int chunkY, Chunk& chunk) {
+    int baseX = chunkX * MAZE_CHUNK_SIZE;
+    int baseY = chunkY * MAZE_CHUNK_SIZE;
+
+    // Generate one cell past the chunk so the generator's border lands on the
+    // neighbors' edge walls, or on the world border for the last chunks.
+    // Chunk origins are even, so the generator's odd rooms are the world's.
+    int localWidth = width - baseX < MAZE_CHUNK_SIZE + 1 ? width - baseX : MAZE_CHUNK_SIZE + 1;
+    int localHeight = height - baseY < MAZE_CHUNK_SIZE + 1 ? height - baseY : MAZE_CHUNK_SIZE + 1;
+    Rng rng(seed * 0x9E3779B97F4A7C15ull + ((uint64_t)(uint32_t)chunkY << 32 | (uint32_t)chunkX));
+    scratch.Resize(localWidth, localHeight);
+    generator(scratch, rng);
+
+    // Copy the rows; columns and rows past the world's edge are walls
+    uint64_t outside = (localWidth >= MAZE_CHUNK_SIZE) ? 0 : ~(uint64_t)0 << localWidth;
+    for (int y = 0; y < MAZE_CHUNK_SIZE; y++) {
+        chunk.rows[y] = (y < localHeight) ? (scratch.RowBits(y, 0, localWidth < 64 ? localWidth : 64) | outside)
+                                          : ~(uint64_t)0;
+    }
+
+    // Doors through the left and top edge walls into the neighbors' rooms
+    const int DOORS_PER_EDGE = 2;
+    int roomsY = (localHeight - 1) / 2;
+    int roomsX = (localWidth - 1) / 2;
+    for (int door = 0; door < DOORS_PER_EDGE; door++) {
+        if (chunkX > 0 && roomsY > 0) {
+            int y = (int)rng.NextBelow((uint32_t)roomsY) * 2 + 1;
+            chunk.rows[y] &= ~(uint64_t)1;
+        }
+        if (chunkY > 0 && roomsX > 0) {
+            int x = (int)rng.NextBelow((uint32_t)roomsX) * 2 + 1;
+            chunk.rows[0] &= ~((uint64_t)1 << x);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef CHUNKED_MAZE_H
+#define CHUNKED_MAZE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "maze.h"
+#include "maze_generator.h"
+
+const int MAZE_CHUNK_SIZE = 64;   // Cells per chunk side: one bitboard word per chunk row
+
+// Maze of any size stored as 64x64-cell chunks that are generated on first
+// touch, for arenas far too large to generate (or keep) whole.
+// Every chunk is generated from the world seed and its own coordinates, so
+// chunks can be loaded in any order, dropped and regenerated identically,
+// and every peer gets the same world from the seed alone. A chunk is a
+// room-based maze (GeneratePerfectMaze or GenerateBraidedMaze) aligned to
+// the world's odd coordinates, and owns the wall column and row on its left
+// and top edges; it opens a couple of doors in each of them, which always
+// lead into rooms of the neighboring chunk, so the whole world is one
+// connected region. Cells outside the world are walls.
+//
+// Loading is not thread-safe: IsWall and ForEachWall may generate chunks.
+class ChunkedMaze {
+public:
+    ChunkedMaze(int width, int height, uint64_t seed, MazeGenerator generator = GenerateBraidedMaze);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+    int ChunksX() const { return chunksX; }
+    int ChunksY() const { return chunksY; }
+
+    // Is the cell a wall? Loads its chunk on first touch.
+    bool IsWall(int x, int y);
+
+    // Has the chunk been generated?
+    bool Loaded(int chunkX, int chunkY) const;
+
+    // Number of chunks currently in memory
+    int LoadedCount() const { return (int)resident.size(); }
+
+    // Load every chunk overlapping the inclusive cell rectangle
+    void Load(int x0, int y0, int x1, int y1);
+
+    // Free every chunk not overlapping the inclusive cell rectangle
+    void UnloadOutside(int x0, int y0, int x1, int y1);
+
+    // Call fn(x, y) for every wall cell inside the inclusive cell rectangle
+    // (clipped to the world), loading only the chunks it overlaps
+    template <typename Fn>
+    void ForEachWall(int x0, int y0, int x1, int y1, Fn fn);
+
+private:
+    struct Chunk {
+        uint64_t rows[MAZE_CHUNK_SIZE];    // Bit i of rows[y] is cell (i, y) of the chunk
+    };
+
+    // The chunk, generated first if needed (coordinates must be in range)
+    const Chunk& ChunkAt(int chunkX, int chunkY);
+
+    void Generate(int chunkX, int chunkY, Chunk& chunk);
+
+    int width, height;
+    int chunksX, chunksY;
+    uint64_t seed;
+    MazeGenerator generator;
+    std::vector<std::unique_ptr<Chunk>> chunks;   // Row-major, null until loaded
+    std::vector<int> resident;                    // Indices of the loaded chunks
+    Maze scratch;                                 // Generation buffer reused between chunks
+};
+
+template <typename Fn>
+void ChunkedMaze::ForEachWall(int x0, int y0, int x1, int y1, Fn fn) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 >= width) x1 = width - 1;
+    if (y1 >= height) y1 = height - 1;
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    for (int chunkY = y0 / MAZE_CHUNK_SIZE; chunkY <= y1 / MAZE_CHUNK_SIZE; chunkY++) {
+        int rowStart = (chunkY * MAZE_CHUNK_SIZE > y0) ? chunkY * MAZE_CHUNK_SIZE : y0;
+        int rowEnd = (chunkY * MAZE_CHUNK_SIZE + MAZE_CHUNK_SIZE - 1 < y1) ? chunkY * MAZE_CHUNK_SIZE + MAZE_CHUNK_SIZE - 1 : y1;
+        for (int chunkX = x0 / MAZE_CHUNK_SIZE; chunkX <= x1 / MAZE_CHUNK_SIZE; chunkX++) {
+            const Chunk& chunk = ChunkAt(chunkX, chunkY);
+            int baseX = chunkX * MAZE_CHUNK_SIZE;
+
+            // Columns of this chunk inside the rectangle
+            int first = (baseX > x0) ? 0 : x0 - baseX;
+            int last = (baseX + MAZE_CHUNK_SIZE - 1 < x1) ? MAZE_CHUNK_SIZE - 1 : x1 - baseX;
+            uint64_t mask = (~(uint64_t)0 << first) & (~(uint64_t)0 >> (63 - last));
+
+            for (int y = rowStart; y <= rowEnd; y++) {
+                uint64_t bits = chunk.rows[y - chunkY * MAZE_CHUNK_SIZE] & mask;
+                while (bits) {
+                    fn(baseX + LowestSetBit(bits), y);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
+
+#endif // CHUNKED_MAZE_H
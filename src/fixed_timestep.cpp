@@ -0,0 +1,29 @@
+#include "fixed_timestep.h"
+
+FixedTimestep::FixedTimestep(double tickRate, int maxTicks)
+    : tickSeconds(1.0 / tickRate), maxTicksPerFrame(maxTicks), accumulator(0) {
+    Reset();
+}
+
+void FixedTimestep::Reset() {
+    accumulator = 0;
+    lastTime = Clock::now();
+}
+
+int FixedTimestep::Advance() {
+    Clock::time_point now = Clock::now();
+    accumulator += std::chrono::duration<double>(now - lastTime).count();
+    lastTime = now;
+
+    int ticks = 0;
+    while (accumulator >= tickSeconds && ticks < maxTicksPerFrame) {
+        accumulator -= tickSeconds;
+        ticks++;
+    }
+
+    // Too far behind: drop the backlog rather than spiral
+    if (accumulator >= tickSeconds) {
+        accumulator = 0;
+    }
+    return ticks;
+}
@@ -0,0 +1,41 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <chrono>
+
+// Fixed-timestep clock with an accumulator.
+// Each frame, Advance() adds the real time elapsed since the previous call
+// and returns how many whole simulation ticks are due, so the simulation runs
+// at exactly tickRate regardless of frame rate or scheduler granularity.
+// Alpha() is the leftover fraction of a tick, used to interpolate rendering
+// between the last two simulated states. If the host falls far behind, at
+// most maxTicksPerFrame ticks are run and the rest of the backlog is dropped.
+class FixedTimestep {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit FixedTimestep(double tickRate = 60.0, int maxTicksPerFrame = 8);
+
+    // Restart timing from now with an empty accumulator
+    void Reset();
+
+    // Accumulate elapsed time and return the number of ticks to run now
+    int Advance();
+
+    // Fraction (0..1) of the next tick already elapsed
+    double Alpha() const { return accumulator / tickSeconds; }
+
+    // Seconds until the next tick is due
+    double TimeUntilNextTick() const { return tickSeconds - accumulator; }
+
+    double TickSeconds() const { return tickSeconds; }
+    double TickRate() const { return 1.0 / tickSeconds; }
+
+private:
+    double tickSeconds;
+    int maxTicksPerFrame;
+    double accumulator;
+    Clock::time_point lastTime;
+};
+
+#endif // FIXED_TIMESTEP_H
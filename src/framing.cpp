@@ -0,0 +1,163 @@
+#include "framing.h"
+#include <cstring>
+
+// PacketDispatcher methods
+PacketDispatcher::PacketDispatcher() {
+    for (int i = 0; i < PACKET_TYPE_COUNT; i++) {
+        handlers[i] = nullptr;
+    }
+}
+
+void PacketDispatcher::Register(PacketType type, PacketHandler handler) {
+    if (type > 0 && type < PACKET_TYPE_COUNT) {
+        handlers[type] = handler;
+    }
+}
+
+bool PacketDispatcher::Dispatch(void* context, const uint8_t* data, size_t size) const {
+    PacketHandler handler = handlers[PeekPacketType(data, size)];
+    if (handler == nullptr) {
+        return false;
+    }
+    handler(context, data, size);
+    return true;
+}
+
+// FrameReader methods
+FrameReader::FrameReader(size_t capacity)
+    : buffer(capacity < FRAME_HEADER_BYTES + FRAME_MAX_PAYLOAD ? FRAME_HEADER_BYTES + FRAME_MAX_PAYLOAD : capacity) {
+    Reset();
+}
+
+void FrameReader::Reset() {
+    start = 0;
+    end = 0;
+    corrupt = false;
+    framesRead = 0;
+}
+
+uint8_t* FrameReader::Space() {
+    // Only move the unparsed tail when a whole frame might no longer fit
+    // behind it; it is at most one partial frame, so the copy is small
+    if (buffer.size() - end < (size_t)(FRAME_HEADER_BYTES + FRAME_MAX_PAYLOAD) && start > 0) {
+        memmove(buffer.data(), buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    return buffer.data() + end;
+}
+
+size_t FrameReader::SpaceSize() {
+    Space();
+    return buffer.size() - end;
+}
+
+void FrameReader::Commit(size_t bytes) {
+    end += bytes;
+}
+
+bool FrameReader::Append(const uint8_t* data, size_t size) {
+    if (SpaceSize() < size) {
+        return false;
+    }
+    memcpy(Space(), data, size);
+    Commit(size);
+    return true;
+}
+
+int FrameReader::Receive(NetSocket socket) {
+    size_t space = SpaceSize();
+    int received = ReceiveStream(socket, Space(), (int)space);
+    if (received > 0) {
+        Commit(received);
+    }
+    return received;
+}
+
+bool FrameReader::NextFrame(const uint8_t*& payload, size_t& size) {
+    if (corrupt || end - start < (size_t)FRAME_HEADER_BYTES) {
+        return false;
+    }
+    const uint8_t* header = buffer.data() + start;
+    size_t length = header[0] | (header[1] << 8);
+    if (length == 0 || length > (size_t)FRAME_MAX_PAYLOAD) {
+        corrupt = true;
+        return false;
+    }
+    if (end - start < FRAME_HEADER_BYTES + length) {
+        return false;
+    }
+
+    payload = header + FRAME_HEADER_BYTES;
+    size = length;
+    start += FRAME_HEADER_BYTES + length;
+    if (start == end) {
+        start = 0;
+        end = 0;
+    }
+    framesRead++;
+    return true;
+}
+
+int FrameReader::DispatchFrames(const PacketDispatcher& dispatcher, void* context) {
+    // Frames stay in place until the next write, so each is dispatched
+    // straight from the receive buffer
+    int frames = 0;
+    const uint8_t* payload;
+    size_t size;
+    while (NextFrame(payload, size)) {
+        dispatcher.Dispatch(context, payload, size);
+        frames++;
+    }
+    return frames;
+}
+
+// FrameWriter methods
+FrameWriter::FrameWriter(size_t sendLimit) : start(0), limit(sendLimit) {
+}
+
+void FrameWriter::Reset() {
+    buffer.clear();
+    start = 0;
+}
+
+bool FrameWriter::Append(const uint8_t* payload, size_t size) {
+    if (size == 0 || size > (size_t)FRAME_MAX_PAYLOAD) {
+        return false;
+    }
+    if (PendingSize() + FRAME_HEADER_BYTES + size > limit) {
+        return false;
+    }
+
+    // Reclaim the sent prefix before growing
+    if (start > 0 && start >= buffer.size() / 2) {
+        buffer.erase(buffer.begin(), buffer.begin() + start);
+        start = 0;
+    }
+    uint8_t header[FRAME_HEADER_BYTES] = { (uint8_t)(size & 0xFF), (uint8_t)(size >> 8) };
+    buffer.insert(buffer.end(), header, header + FRAME_HEADER_BYTES);
+    buffer.insert(buffer.end(), payload, payload + size);
+    return true;
+}
+
+bool FrameWriter::Flush(NetSocket socket) {
+    while (PendingSize() > 0) {
+        int sent = SendStream(socket, Pending(), (int)PendingSize());
+        if (sent < 0) {
+            return false;
+        }
+        if (sent == 0) {
+            break;
+        }
+        Consume(sent);
+    }
+    return true;
+}
+
+void FrameWriter::Consume(size_t bytes) {
+    start += bytes;
+    if (start >= buffer.size()) {
+        buffer.clear();
+        start = 0;
+    }
+}
@@ -0,0 +1,128 @@
+#ifndef FRAMING_H
+#define FRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitstream.h"
+#include "net_socket.h"
+#include "packets.h"
+
+// Message framing for stream (TCP) connections.
+// A stream has no message boundaries: one recv() may return half a packet
+// or a dozen of them. Every packet therefore travels as a frame, a 16-bit
+// little-endian payload length followed by the packet's wire encoding:
+//
+//   length     2 bytes, 1..FRAME_MAX_PAYLOAD
+//   payload    the encoded packet, type tag first
+//
+// FrameReader buffers whatever arrives per connection and hands out every
+// complete frame at once, keeping partial frames for the next read, so a
+// single recv() can deliver many packets and a split packet never
+// desynchronizes the stream. FrameWriter queues outgoing frames and sends
+// as much as the socket takes. PacketDispatcher routes payloads to a
+// handler per PacketType.
+const int FRAME_HEADER_BYTES = 2;
+const int FRAME_MAX_PAYLOAD = WIRE_MAX_PACKET_BYTES;
+const int FRAME_RECEIVE_BUFFER = 64 * 1024;        // Receive buffer per connection
+const int FRAME_SEND_LIMIT = 256 * 1024;           // Unsent bytes before a peer counts as stalled
+const int PACKET_TYPE_COUNT = 1 << WIRE_TYPE_BITS;
+
+// Called with one complete packet, type tag included
+typedef void (*PacketHandler)(void* context, const uint8_t* data, size_t size);
+
+// Table of handlers indexed by PacketType
+class PacketDispatcher {
+public:
+    PacketDispatcher();
+
+    void Register(PacketType type, PacketHandler handler);
+
+    // Call the handler for the packet's type; false if it has none
+    bool Dispatch(void* context, const uint8_t* data, size_t size) const;
+
+private:
+    PacketHandler handlers[PACKET_TYPE_COUNT];
+};
+
+// Receive side of one stream connection
+class FrameReader {
+public:
+    explicit FrameReader(size_t capacity = FRAME_RECEIVE_BUFFER);
+
+    void Reset();
+
+    // Free space to receive into; buffered bytes are moved to the front
+    // first when that is needed to fit a whole frame
+    uint8_t* Space();
+    size_t SpaceSize();
+
+    // Record that bytes were written into Space()
+    void Commit(size_t bytes);
+
+    // Append received bytes; false if they do not fit
+    bool Append(const uint8_t* data, size_t size);
+
+    // One recv() into the free space: bytes received, 0 if nothing was
+    // waiting, or -1 if the connection closed or failed
+    int Receive(NetSocket socket);
+
+    // Next complete frame, valid until the buffer is next written; false if
+    // none is complete yet or the stream is corrupt
+    bool NextFrame(const uint8_t*& payload, size_t& size);
+
+    // Dispatch every complete frame buffered; returns the number dispatched
+    // (including those without a handler)
+    int DispatchFrames(const PacketDispatcher& dispatcher, void* context);
+
+    // A frame header was out of range; the connection must be dropped
+    bool Corrupt() const { return corrupt; }
+
+    size_t Buffered() const { return end - start; }
+    uint64_t FramesRead() const { return framesRead; }
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t start;           // First unparsed byte
+    size_t end;             // One past the last received byte
+    bool corrupt;
+    uint64_t framesRead;
+};
+
+// Send side of one stream connection
+class FrameWriter {
+public:
+    explicit FrameWriter(size_t limit = FRAME_SEND_LIMIT);
+
+    void Reset();
+
+    // Queue one frame; false if the payload is empty or too large, or the
+    // peer is not keeping up and the queue would pass the limit
+    bool Append(const uint8_t* payload, size_t size);
+
+    // Encode a packet and queue it
+    template <typename Packet>
+    bool AppendPacket(const Packet& packet) {
+        BitWriter writer(FRAME_MAX_PAYLOAD);
+        WritePacket(writer, packet);
+        return Append(writer.Data(), writer.Size());
+    }
+
+    // Send queued bytes until the socket would block; false if the
+    // connection failed
+    bool Flush(NetSocket socket);
+
+    // Bytes queued but not yet sent
+    const uint8_t* Pending() const { return buffer.data() + start; }
+    size_t PendingSize() const { return buffer.size() - start; }
+
+    // Drop bytes that were sent some other way
+    void Consume(size_t bytes);
+
+private:
+    std::vector<uint8_t> buffer;
+    size_t start;           // First unsent byte
+    size_t limit;
+};
+
+#endif // FRAMING_H
@@ -1,11 +1,16 @@
 #include "game.h"
+#include "profiler.h"
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
+#include <cstring>
 #include <ctime>
-#define M_PI 3.14159265358979323846
 
 // Tank methods
 void Tank::Update() {
+    // Remember where we were for render interpolation
+    prevX = x;
+    prevY = y;
+    
     // Update position based on velocity
     x += velocityX;
     y += velocityY;
@@ -18,12 +23,14 @@ void Tank::Update() {
     if (cooldown > 0) {
         cooldown--;
     }
-    
+}
+
+void Tank::ClampToBounds(int worldWidth, int worldHeight) {
     // Boundary checking
     if (x < 0) x = 0;
     if (y < 0) y = 0;
-    if (x > WINDOW_WIDTH - TANK_WIDTH) x = WINDOW_WIDTH - TANK_WIDTH;
-    if (y > WINDOW_HEIGHT - TANK_HEIGHT) y = WINDOW_HEIGHT - TANK_HEIGHT;
+    if (x > worldWidth - TANK_WIDTH) x = (float)(worldWidth - TANK_WIDTH);
+    if (y > worldHeight - TANK_HEIGHT) y = (float)(worldHeight - TANK_HEIGHT);
 }
 
 void Tank::Move(float dx, float dy) {
@@ -54,7 +61,9 @@ Bullet Tank::Shoot() {
         
         return Bullet(bulletX, bulletY, velX, velY, playerID);
     }
-    return Bullet(0, 0, 0, 0, 0); // Return inactive bullet
+    Bullet none(0, 0, 0, 0, 0);
+    none.active = false; // Return inactive bullet
+    return none;
 }
 
 bool Tank::JustShot() {
@@ -64,7 +73,6 @@ bool Tank::JustShot() {
 // Bullet methods
 void Bullet::Update() {
     if (active) {
-        Move();
         lifetime--;
         if (lifetime <= 0) {
             active = false;
@@ -72,212 +80,183 @@ void Bullet::Update() {
     }
 }
 
-void Bullet::Move() {
-    // Store original position
-    float oldX = x;
-    float oldY = y;
-    
-    // Update position
-    x += velocityX;
-    y += velocityY;
-    
-    // Boundary checking - bounce off edges
-    if (x < 0) {
-        x = 0;
-        velocityX = -velocityX * 0.8f; // Reverse X velocity with some energy loss
-        bounceCount++;
-    }
-    if (y < 0) {
-        y = 0;
-        velocityY = -velocityY * 0.8f; // Reverse Y velocity with some energy loss
-        bounceCount++;
-    }
-    if (x > WINDOW_WIDTH - BULLET_WIDTH) {
-        x = WINDOW_WIDTH - BULLET_WIDTH;
-        velocityX = -velocityX * 0.8f; // Reverse X velocity with some energy loss
-        bounceCount++;
-    }
-    if (y > WINDOW_HEIGHT - BULLET_HEIGHT) {
-        y = WINDOW_HEIGHT - BULLET_HEIGHT;
-        velocityY = -velocityY * 0.8f; // Reverse Y velocity with some energy loss
-        bounceCount++;
+// GameStats methods
+void GameStats::Clear() {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        shotsFired[i] = 0;
     }
-    
-    // Check if bullet has exceeded bounce limit
-    if (bounceCount >= 4) {
-        active = false;
+    kills = 0;
+    firstKillTick = -1;
+    for (int i = 0; i <= MAX_BULLET_BOUNCES; i++) {
+        bulletsByBounces[i] = 0;
+    }
+}
+
+void GameStats::RetireBullet(const Bullet& bullet) {
+    int bounces = bullet.bounceCount;
+    if (bounces > MAX_BULLET_BOUNCES) {
+        bounces = MAX_BULLET_BOUNCES;
+    }
+    bulletsByBounces[bounces]++;
+}
+
+// BulletPool methods
+BulletPool::BulletPool(int capacity) : storage(capacity), count(0) {}
+
+bool BulletPool::Spawn(const Bullet& bullet) {
+    if (count >= (int)storage.size()) {
+        return false;
+    }
+    storage[count++] = bullet;
+    return true;
+}
+
+void BulletPool::Assign(const Bullet* source, int n) {
+    count = (n < (int)storage.size()) ? n : (int)storage.size();
+    std::copy(source, source + count, storage.begin());
+}
+
+void BulletPool::Remove(int index) {
+    count--;
+    if (index != count) {
+        storage[index] = storage[count];
     }
 }
 
 // GameState methods
-GameState::GameState() : gameRunning(true), gameOver(false), winner(-1) {
-    scores[0] = 0;
-    scores[1] = 0;
+template <typename ArenaT>
+BasicGameState<ArenaT>::BasicGameState(int players, int particleCapacity)
+    : maze(MAZE_WIDTH, MAZE_HEIGHT), mazeGenerator(GenerateBraidedMaze), mazeSeed(0), tick(0),
+      particles(particleCapacity), tankHash((float)WALL_SIZE), gameRunning(true), gameOver(false), winner(-1) {
+    playerCount = (players < 1) ? 1 : (players > MAX_PLAYERS ? MAX_PLAYERS : players);
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        scores[i] = 0;
+    }
     Initialize();
 }
 
-void GameState::Initialize() {
-    // Initialize tanks
-    tanks[0] = Tank(100, 100, 1); // Player 1
-    tanks[1] = Tank(600, 400, 2); // Player 2 (for testing)
-    
+template <typename ArenaT>
+void BasicGameState<ArenaT>::Initialize() {
+    Initialize((unsigned int)time(nullptr));
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::Initialize(unsigned int seed) {
     // Clear bullets
-    bullets.clear();
+    bullets.Clear();
     
     // Initialize scores
-    scores[0] = 0;
-    scores[1] = 0;
+    for (int i = 0; i < playerCount; i++) {
+        scores[i] = 0;
+    }
     
     // Reset game over state
     gameOver = false;
     winner = -1;
+    tick = 0;
+    stats.Clear();
     
-    // Initialize a random maze
-    srand((unsigned int)time(nullptr)); // Seed random number generator
+    // Generate the maze from the seed; every generator yields one connected
+    // open region, so all spawn cells can reach each other
+    mazeSeed = seed;
+    GenerateMaze(maze, seed, mazeGenerator);
+    CopyWalls();
     
-    for (int x = 0; x < MAZE_WIDTH; x++) {
-        for (int y = 0; y < MAZE_HEIGHT; y++) {
-            // Create borders
-            if (x == 0 || y == 0 || x == MAZE_WIDTH - 1 || y == MAZE_HEIGHT - 1) {
-                maze[x][y] = MazeCell(true);
-            }
-            // Create random internal walls (30% chance)
-            else if (rand() % 100 < 30) {
-                maze[x][y] = MazeCell(true);
-            }
-            else {
-                maze[x][y] = MazeCell(false);
-            }
-        }
+    // Initialize tanks once the maze is known
+    for (int i = 0; i < playerCount; i++) {
+        float spawnX, spawnY;
+        GetSpawnPosition(i, spawnX, spawnY);
+        tanks[i] = Tank(spawnX, spawnY, i + 1);
     }
+    RebuildTankHash();
 }
 
-void GameState::Update() {
+template <typename ArenaT>
+void BasicGameState<ArenaT>::Update() {
+    TROUBLE_PROFILE_SCOPE("GameState::Update");
+    
+    // The tick keeps counting after the match ends so peers and replays that
+    // key inputs by tick stay aligned
+    tick++;
     if (gameOver) {
         return;
     }
     
     // Update tanks
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < playerCount; i++) {
         if (tanks[i].alive) {
             tanks[i].Update();
+            tanks[i].ClampToBounds(ArenaT::WIDTH, ArenaT::HEIGHT);
         }
     }
     
-    // Update particles
-    for (int i = particles.size() - 1; i >= 0; i--) {
-        particles[i].Update();
-        if (!particles[i].active) {
-            particles.erase(particles.begin() + i);
-        }
+    // Resolve tank overlaps, then index final positions for the bullet pass
+    RebuildTankHash();
+    if (SeparateTanks()) {
+        RebuildTankHash();
     }
     
-    // Update bullets and check for collisions
-    for (int i = bullets.size() - 1; i >= 0; i--) {
-        bullets[i].Update();
+    // Update particles
+    particles.Update();
+    
+    // Update bullets and check for collisions. Removal swaps the last live
+    // bullet into slot i, so only advance i when the bullet survives.
+    int i = 0;
+    while (i < bullets.Count()) {
+        Bullet& bullet = bullets[i];
+        MoveBullet(bullet);
+        bullet.Update();
         
-        if (!bullets[i].active) {
-            bullets.erase(bullets.begin() + i);
+        if (!bullet.active) {
+            stats.RetireBullet(bullet);
+            bullets.Remove(i);
             continue;
         }
         
-        // Check collision with walls
-        if (CheckWallCollision(bullets[i].x, bullets[i].y)) {
-            // Instead of removing the bullet, make it bounce
-            // Calculate which side of the wall was hit
-            int gridX = (int)(bullets[i].x / WALL_SIZE);
-            int gridY = (int)(bullets[i].y / WALL_SIZE);
-            
-            // Determine bounce direction based on bullet approach
-            float centerX = gridX * WALL_SIZE + WALL_SIZE / 2.0f;
-            float centerY = gridY * WALL_SIZE + WALL_SIZE / 2.0f;
-            
-            // Simple bounce logic - reverse velocity component based on approach direction
-            if (bullets[i].velocityX > 0 && bullets[i].x < centerX) {
-                // Hit left side of wall
-                bullets[i].velocityX = -bullets[i].velocityX * 0.8f;
-                bullets[i].bounceCount++;
-            } else if (bullets[i].velocityX < 0 && bullets[i].x > centerX) {
-                // Hit right side of wall
-                bullets[i].velocityX = -bullets[i].velocityX * 0.8f;
-                bullets[i].bounceCount++;
-            } else if (bullets[i].velocityY > 0 && bullets[i].y < centerY) {
-                // Hit top side of wall
-                bullets[i].velocityY = -bullets[i].velocityY * 0.8f;
-                bullets[i].bounceCount++;
-            } else if (bullets[i].velocityY < 0 && bullets[i].y > centerY) {
-                // Hit bottom side of wall
-                bullets[i].velocityY = -bullets[i].velocityY * 0.8f;
-                bullets[i].bounceCount++;
-            }
-            
-            // Move bullet slightly away from wall to prevent sticking
-            if (bullets[i].velocityX > 0) {
-                bullets[i].x += 2.0f;
-            } else if (bullets[i].velocityX < 0) {
-                bullets[i].x -= 2.0f;
-            }
-            
-            if (bullets[i].velocityY > 0) {
-                bullets[i].y += 2.0f;
-            } else if (bullets[i].velocityY < 0) {
-                bullets[i].y -= 2.0f;
-            }
-            
-            // Add spark particles for wall hit
-            AddExplosion(bullets[i].x, bullets[i].y);
-            
-            // Check if bullet has exceeded bounce limit
-            if (bullets[i].bounceCount >= 4) {
-                AddExplosion(bullets[i].x, bullets[i].y); // Add explosion when bullet expires
-                bullets[i].active = false;
-                bullets.erase(bullets.begin() + i);
-                continue;
-            }
+        // Check collision with tanks near the bullet
+        int j = FindTankAt(bullet.x, bullet.y, bullet.ownerID - 1);
+        if (j < 0) {
+            i++;
+            continue;
         }
         
-        // Check collision with tanks
-        for (int j = 0; j < 2; j++) {
-            if (tanks[j].alive && j != (bullets[i].ownerID - 1)) {
-                if (bullets[i].x >= tanks[j].x && bullets[i].x <= tanks[j].x + TANK_WIDTH &&
-                    bullets[i].y >= tanks[j].y && bullets[i].y <= tanks[j].y + TANK_HEIGHT) {
-                    // Hit a tank
-                    tanks[j].alive = false;
-                    bullets[i].active = false;
-                    
-                    // Add explosion effect
-                    AddExplosion(tanks[j].x + TANK_WIDTH/2, tanks[j].y + TANK_HEIGHT/2);
-                    
-                    // Remove bullet
-                    bullets.erase(bullets.begin() + i);
-                    
-                    // Update score
-                    scores[bullets[i].ownerID - 1]++;
-                    
-                    // Check for game over
-                    int aliveCount = 0;
-                    int lastAlive = -1;
-                    for (int k = 0; k < 2; k++) {
-                        if (tanks[k].alive) {
-                            aliveCount++;
-                            lastAlive = k;
-                        }
-                    }
-                    
-                    if (aliveCount <= 1) {
-                        gameOver = true;
-                        winner = (lastAlive >= 0) ? (lastAlive + 1) : 0; // 0 means tie
-                    }
-                    
-                    break;
-                }
+        // Hit a tank
+        tanks[j].alive = false;
+        int ownerID = bullet.ownerID;
+        stats.kills++;
+        if (stats.firstKillTick < 0) {
+            stats.firstKillTick = (int32_t)tick;
+        }
+        
+        // Add explosion effect
+        AddExplosion(tanks[j].x + TANK_WIDTH/2, tanks[j].y + TANK_HEIGHT/2);
+        
+        // Remove bullet
+        stats.RetireBullet(bullet);
+        bullets.Remove(i);
+        
+        // Update score
+        scores[ownerID - 1]++;
+        
+        // Check for game over
+        int aliveCount = 0;
+        int lastAlive = -1;
+        for (int k = 0; k < playerCount; k++) {
+            if (tanks[k].alive) {
+                aliveCount++;
+                lastAlive = k;
             }
         }
+        
+        if (aliveCount <= 1) {
+            gameOver = true;
+            winner = (lastAlive >= 0) ? (lastAlive + 1) : 0; // 0 means tie
+        }
     }
     
-    // Respawn tanks if both are dead (for continuous gameplay)
+    // Respawn tanks if all are dead (for continuous gameplay)
     bool allDead = true;
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < playerCount; i++) {
         if (tanks[i].alive) {
             allDead = false;
             break;
@@ -285,99 +264,367 @@ void GameState::Update() {
     }
     
     if (allDead) {
-        // Respawn both tanks at random positions
-        tanks[0] = Tank(100, 100, 1);
-        tanks[1] = Tank(600, 400, 2);
+        for (int i = 0; i < playerCount; i++) {
+            float spawnX, spawnY;
+            GetSpawnPosition(i, spawnX, spawnY);
+            tanks[i] = Tank(spawnX, spawnY, i + 1);
+        }
+        RebuildTankHash();
     }
 }
 
-void GameState::HandleInput(bool keys[256]) {
-    // Player 1 controls (Arrow keys)
-    if (keys[VK_UP]) {
-        tanks[0].Move(0, -1);
+template <typename ArenaT>
+void BasicGameState<ArenaT>::HandleInput(bool keys[256]) {
+    ApplyInput(0, ButtonsFromKeys(keys, 0));
+    ApplyInput(1, ButtonsFromKeys(keys, 1));
+}
+
+template <typename ArenaT>
+uint8_t BasicGameState<ArenaT>::ButtonsFromKeys(const bool keys[256], int scheme) {
+    uint8_t buttons = 0;
+    if (scheme == 0) {
+        // Arrow keys and space
+        if (keys[KEY_UP]) buttons |= INPUT_UP;
+        if (keys[KEY_DOWN]) buttons |= INPUT_DOWN;
+        if (keys[KEY_LEFT]) buttons |= INPUT_LEFT;
+        if (keys[KEY_RIGHT]) buttons |= INPUT_RIGHT;
+        if (keys[KEY_SPACE]) buttons |= INPUT_FIRE;
+    } else {
+        // WASD and E
+        if (keys['W']) buttons |= INPUT_UP;
+        if (keys['S']) buttons |= INPUT_DOWN;
+        if (keys['A']) buttons |= INPUT_LEFT;
+        if (keys['D']) buttons |= INPUT_RIGHT;
+        if (keys['E']) buttons |= INPUT_FIRE;
+    }
+    return buttons;
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::ApplyInput(int player, uint8_t buttons) {
+    if (player < 0 || player >= playerCount) {
+        return;
+    }
+    
+    Tank& tank = tanks[player];
+    if (buttons & INPUT_UP) {
+        tank.Move(0, -1);
     }
-    if (keys[VK_DOWN]) {
-        tanks[0].Move(0, 1);
+    if (buttons & INPUT_DOWN) {
+        tank.Move(0, 1);
     }
-    if (keys[VK_LEFT]) {
-        tanks[0].Move(-1, 0);
+    if (buttons & INPUT_LEFT) {
+        tank.Move(-1, 0);
     }
-    if (keys[VK_RIGHT]) {
-        tanks[0].Move(1, 0);
+    if (buttons & INPUT_RIGHT) {
+        tank.Move(1, 0);
     }
-    if (keys[VK_SPACE]) {
-        Bullet bullet = tanks[0].Shoot();
-        if (bullet.active) {
-            bullets.push_back(bullet);
+    if (buttons & INPUT_FIRE) {
+        Bullet bullet = tank.Shoot();
+        if (bullet.active && bullets.Spawn(bullet)) {
+            stats.shotsFired[player]++;
             // Would play sound effect here if we had access to PlaySoundEffect
         }
     }
+}
+
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::CheckWallCollision(float x, float y) {
+    return IsWall((int)floorf(x / WALL_SIZE), (int)floorf(y / WALL_SIZE));
+}
+
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::IsWall(int cellX, int cellY) const {
+    // Same as Maze::IsWall, with the bounds and row stride known at compile time
+    if ((unsigned)cellX >= (unsigned)MAZE_WIDTH || (unsigned)cellY >= (unsigned)MAZE_HEIGHT) {
+        return true; // Out of bounds counts as a wall
+    }
+    int bit = cellY * MAZE_WIDTH + cellX;
+    return (walls[bit >> 6] >> (bit & 63)) & 1;
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::CopyWalls() {
+    // The maze is always MAZE_WIDTH x MAZE_HEIGHT, so it has exactly
+    // WALL_WORDS words, spare word included
+    memcpy(walls.data(), maze.Bits(), sizeof(walls));
+}
+
+// Wall bits of the three cells from a bit index on. Both words are always
+// read (walls keeps the maze's spare word at the end), and the double shift
+// keeps a shift of 0 from becoming a shift by 64.
+static inline uint64_t ThreeCells(const uint64_t* bits, int bit) {
+    int shift = bit & 63;
+    return ((bits[bit >> 6] >> shift) | (bits[(bit >> 6) + 1] << (63 - shift) << 1)) & 7;
+}
+
+template <typename ArenaT>
+inline bool BasicGameState<ArenaT>::SurroundingsOpen(int cellX, int cellY) const {
+    if (cellX < 1 || cellY < 1 || cellX >= MAZE_WIDTH - 1 || cellY >= MAZE_HEIGHT - 1) {
+        return false;
+    }
+    // The row above, the row itself without the middle cell, the row below
+    const uint64_t* bits = walls.data();
+    int bit = (cellY - 1) * MAZE_WIDTH + cellX - 1;
+    return (ThreeCells(bits, bit) | (ThreeCells(bits, bit + MAZE_WIDTH) & 5) |
+            ThreeCells(bits, bit + 2 * MAZE_WIDTH)) == 0;
+}
+
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::RaycastWalls(float x, float y, float dx, float dy, WallHit& hit) const {
+    int cellX = (int)floorf(x / WALL_SIZE);
+    int cellY = (int)floorf(y / WALL_SIZE);
+    
+    // Step direction, parametric distance to the next cell boundary and
+    // parametric size of one cell along each axis
+    int stepX = 0, stepY = 0;
+    float tMaxX = INFINITY, tMaxY = INFINITY;
+    float tDeltaX = INFINITY, tDeltaY = INFINITY;
+    
+    if (dx > 0) {
+        stepX = 1;
+        tMaxX = ((cellX + 1) * WALL_SIZE - x) / dx;
+        tDeltaX = WALL_SIZE / dx;
+    } else if (dx < 0) {
+        stepX = -1;
+        tMaxX = (cellX * WALL_SIZE - x) / dx;
+        tDeltaX = -WALL_SIZE / dx;
+    }
     
-    // Player 2 controls (WASD)
-    if (keys['W']) {
-        tanks[1].Move(0, -1);
+    if (dy > 0) {
+        stepY = 1;
+        tMaxY = ((cellY + 1) * WALL_SIZE - y) / dy;
+        tDeltaY = WALL_SIZE / dy;
+    } else if (dy < 0) {
+        stepY = -1;
+        tMaxY = (cellY * WALL_SIZE - y) / dy;
+        tDeltaY = -WALL_SIZE / dy;
     }
-    if (keys['S']) {
-        tanks[1].Move(0, 1);
+    
+    while (true) {
+        float t;
+        int normalX = 0, normalY = 0;
+        if (tMaxX < tMaxY) {
+            t = tMaxX;
+            cellX += stepX;
+            tMaxX += tDeltaX;
+            normalX = -stepX;
+        } else {
+            t = tMaxY;
+            cellY += stepY;
+            tMaxY += tDeltaY;
+            normalY = -stepY;
+        }
+        
+        // The segment ends before reaching the next cell
+        if (t > 1.0f) {
+            return false;
+        }
+        
+        if (IsWall(cellX, cellY)) {
+            hit.t = t;
+            hit.normalX = normalX;
+            hit.normalY = normalY;
+            hit.cellX = cellX;
+            hit.cellY = cellY;
+            return true;
+        }
     }
-    if (keys['A']) {
-        tanks[1].Move(-1, 0);
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::MoveBullet(Bullet& bullet) {
+    // Remember where we were for render interpolation
+    bullet.prevX = bullet.x;
+    bullet.prevY = bullet.y;
+    
+    int cellX = (int)floorf(bullet.x / WALL_SIZE);
+    int cellY = (int)floorf(bullet.y / WALL_SIZE);
+    
+    // A bullet fired from inside a wall has nowhere to go
+    if (IsWall(cellX, cellY)) {
+        AddExplosion(bullet.x, bullet.y);
+        bullet.active = false;
+        return;
     }
-    if (keys['D']) {
-        tanks[1].Move(1, 0);
+    
+    // Fast path: a step shorter than one cell can only reach the 8 cells
+    // around the current one, so if none of them is a wall skip the traversal
+    if (SurroundingsOpen(cellX, cellY) &&
+        fabsf(bullet.velocityX) < WALL_SIZE && fabsf(bullet.velocityY) < WALL_SIZE) {
+        bullet.x += bullet.velocityX;
+        bullet.y += bullet.velocityY;
+        return;
     }
-    if (keys['E']) {
-        Bullet bullet = tanks[1].Shoot();
-        if (bullet.active) {
-            bullets.push_back(bullet);
-            // Would play sound effect here if we had access to PlaySoundEffect
+    
+    // Fraction of this tick's travel still to cover; each bounce consumes
+    // part of it and the rest continues along the reflected velocity
+    float remaining = 1.0f;
+    while (remaining > 0.0f) {
+        float dx = bullet.velocityX * remaining;
+        float dy = bullet.velocityY * remaining;
+        
+        WallHit hit;
+        if (!RaycastWalls(bullet.x, bullet.y, dx, dy, hit)) {
+            bullet.x += dx;
+            bullet.y += dy;
+            return;
+        }
+        
+        // Stop on the wall face, just on the open side of it
+        bullet.x += dx * hit.t + hit.normalX * WALL_HIT_EPSILON;
+        bullet.y += dy * hit.t + hit.normalY * WALL_HIT_EPSILON;
+        
+        // Reflect the velocity component along the face normal with some energy loss
+        if (hit.normalX != 0) {
+            bullet.velocityX = -bullet.velocityX * 0.8f;
+        } else {
+            bullet.velocityY = -bullet.velocityY * 0.8f;
         }
+        bullet.bounceCount++;
+        
+        // Add spark particles for wall hit
+        AddExplosion(bullet.x, bullet.y);
+        
+        // Check if bullet has exceeded bounce limit
+        if (bullet.bounceCount >= MAX_BULLET_BOUNCES) {
+            AddExplosion(bullet.x, bullet.y); // Add explosion when bullet expires
+            bullet.active = false;
+            return;
+        }
+        
+        remaining *= 1.0f - hit.t;
     }
 }
 
-bool GameState::CheckWallCollision(float x, float y) {
-    int gridX = (int)(x / WALL_SIZE);
-    int gridY = (int)(y / WALL_SIZE);
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::CheckTankCollision(float x, float y, int ignoreTank) {
+    return FindTankAt(x, y, ignoreTank) >= 0;
+}
+
+template <typename ArenaT>
+int BasicGameState<ArenaT>::FindTankAt(float x, float y, int ignoreTank) const {
+    int found = -1;
+    tankHash.QueryPoint(x, y, [&](int i) {
+        const Tank& tank = tanks[i];
+        if (i != ignoreTank && tank.alive &&
+            x >= tank.x && x <= tank.x + TANK_WIDTH &&
+            y >= tank.y && y <= tank.y + TANK_HEIGHT) {
+            found = i;
+            return false;
+        }
+        return true;
+    });
+    return found;
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::GetSpawnPosition(int player, float& x, float& y) const {
+    // Walk the interior cells row by row and hand each player an open cell
+    // an equal stride apart, so spawns are spread evenly over the arena
+    const int interior = ArenaT::INTERIOR_CELLS;
+    int start = (int)(((long long)player * interior) / playerCount);
+    for (int n = 0; n < interior; n++) {
+        int index = (start + n) % interior;
+        int cellX = 1 + index % ArenaT::INTERIOR_WIDTH;
+        int cellY = 1 + index / ArenaT::INTERIOR_WIDTH;
+        if (!IsWall(cellX, cellY)) {
+            x = (float)(cellX * WALL_SIZE);
+            y = (float)(cellY * WALL_SIZE);
+            return;
+        }
+    }
     
-    if (gridX >= 0 && gridX < MAZE_WIDTH && gridY >= 0 && gridY < MAZE_HEIGHT) {
-        return maze[gridX][gridY].wall;
+    // Fully walled maze: fall back to the top-left interior cell
+    x = (float)WALL_SIZE;
+    y = (float)WALL_SIZE;
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::RebuildTankHash() {
+    tankHash.Clear();
+    for (int i = 0; i < playerCount; i++) {
+        if (tanks[i].alive) {
+            tankHash.Insert(i, tanks[i].x, tanks[i].y, tanks[i].x + TANK_WIDTH, tanks[i].y + TANK_HEIGHT);
+        }
     }
-    return true; // Treat out of bounds as walls
+    tankHash.Build();
 }
 
-bool GameState::CheckTankCollision(float x, float y, int ignoreTank) {
-    for (int i = 0; i < 2; i++) {
-        if (i != ignoreTank && tanks[i].alive) {
-            if (x >= tanks[i].x && x <= tanks[i].x + TANK_WIDTH &&
-                y >= tanks[i].y && y <= tanks[i].y + TANK_HEIGHT) {
-                return true;
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::SeparateTanks() {
+    bool moved = false;
+    for (int i = 0; i < playerCount; i++) {
+        if (!tanks[i].alive) {
+            continue;
+        }
+        
+        int x0 = tankHash.CellOf(tanks[i].x);
+        int y0 = tankHash.CellOf(tanks[i].y);
+        int x1 = tankHash.CellOf(tanks[i].x + TANK_WIDTH);
+        int y1 = tankHash.CellOf(tanks[i].y + TANK_HEIGHT);
+        for (int cy = y0; cy <= y1; cy++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                tankHash.QueryCell(cx, cy, [&](int j) {
+                    if (j <= i || !tanks[j].alive) {
+                        return true;
+                    }
+                    Tank& a = tanks[i];
+                    Tank& b = tanks[j];
+                    
+                    // Handle each pair once: only in the first cell of their overlap
+                    float left = (a.x > b.x) ? a.x : b.x;
+                    float top = (a.y > b.y) ? a.y : b.y;
+                    if (tankHash.CellOf(left) != cx || tankHash.CellOf(top) != cy) {
+                        return true;
+                    }
+                    
+                    float overlapX = ((a.x < b.x) ? a.x : b.x) + TANK_WIDTH - left;
+                    float overlapY = ((a.y < b.y) ? a.y : b.y) + TANK_HEIGHT - top;
+                    if (overlapX <= 0 || overlapY <= 0) {
+                        return true;
+                    }
+                    
+                    // Push both tanks apart along the axis of least penetration
+                    if (overlapX < overlapY) {
+                        float push = (a.x < b.x) ? -overlapX / 2 : overlapX / 2;
+                        a.x += push;
+                        b.x -= push;
+                    } else {
+                        float push = (a.y < b.y) ? -overlapY / 2 : overlapY / 2;
+                        a.y += push;
+                        b.y -= push;
+                    }
+                    a.ClampToBounds(ArenaT::WIDTH, ArenaT::HEIGHT);
+                    b.ClampToBounds(ArenaT::WIDTH, ArenaT::HEIGHT);
+                    moved = true;
+                    return true;
+                });
             }
         }
     }
-    return false;
+    return moved;
 }
 
-void GameState::Reset() {
+template <typename ArenaT>
+void BasicGameState<ArenaT>::Reset() {
     Initialize();
-    scores[0] = 0;
-    scores[1] = 0;
+    for (int i = 0; i < playerCount; i++) {
+        scores[i] = 0;
+    }
     gameOver = false;
     winner = -1;
-    particles.clear(); // Clear particles on reset
+    particles.Clear(); // Clear particles on reset
 }
 
-void GameState::AddExplosion(float x, float y) {
+template <typename ArenaT>
+void BasicGameState<ArenaT>::AddExplosion(float x, float y) {
     // Create several particles for explosion effect
-    for (int i = 0; i < 8; i++) {
-        float angle = (float)(i * M_PI * 2 / 8);
-        float speed = 2.0f + (rand() % 3);
-        float velX = cos(angle) * speed;
-        float velY = sin(angle) * speed;
-        particles.push_back(Particle(x, y, velX, velY));
-    }
+    particles.AddExplosion(x, y);
 }
 
-void GameState::Render(HDC hdc) {
-    // This method will be implemented in main.cpp where we have access to the bitmaps
-    // For now, we'll just leave it as a placeholder
-}
\ No newline at end of file
+// Arenas the simulation is compiled for; snapshot.cpp instantiates the
+// snapshot methods for the same list
+template struct BasicGameState<StandardArena>;
+template struct BasicGameState<LargeArena>;
+template struct BasicGameState<HugeArena>;
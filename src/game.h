@@ -1,8 +1,13 @@
 #ifndef GAME_H
 #define GAME_H
 
-#include <windows.h>
+#include <array>
+#include <cstdint>
 #include <vector>
+#include "maze.h"
+#include "maze_generator.h"
+#include "particles.h"
+#include "spatial_hash.h"
 
 // Constants
 const int WINDOW_WIDTH = 800;
@@ -15,29 +20,80 @@ const int WALL_SIZE = 32;
 const float TANK_SPEED = 2.0f;
 const float BULLET_SPEED = 5.0f;
 const int BULLET_LIFETIME = 100; // frames
+const int MAX_BULLET_BOUNCES = 4;  // A bullet is destroyed on this many wall bounces
+const int MAX_PLAYERS = 64;
+const float WALL_HIT_EPSILON = 0.01f; // Distance a bullet is kept off a wall face after a bounce
+
+// Per-player input buttons, packed into one byte per tick
+enum InputButton {
+    INPUT_UP    = 1 << 0,
+    INPUT_DOWN  = 1 << 1,
+    INPUT_LEFT  = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_FIRE  = 1 << 4
+};
+
+// Key codes used by HandleInput. These match the Win32 virtual-key values so
+// the client can pass its keyboard array straight through, but keep the
+// simulation free of <windows.h>.
+const int KEY_SPACE = 0x20;
+const int KEY_LEFT = 0x25;
+const int KEY_UP = 0x26;
+const int KEY_RIGHT = 0x27;
+const int KEY_DOWN = 0x28;
 
 // Forward declarations
 struct Tank;
 struct Bullet;
-struct GameState;
+struct GameSnapshot;
+
+// Arena dimensions fixed at compile time.
+// The maze size in cells and the world bounds tanks are clamped to are
+// template arguments, so everything derived from them (bounds checks, the
+// bitboard row stride, the size of the state's wall copy, per-cell strides,
+// the spawn walk) folds to constants inside BasicGameState. The standard
+// arena keeps the original 800x600 window as its bounds; other arenas
+// default to the maze's pixel size.
+template <int CellsX, int CellsY, int PixelsX = CellsX * WALL_SIZE, int PixelsY = CellsY * WALL_SIZE>
+struct Arena {
+    static constexpr int MAZE_WIDTH = CellsX;
+    static constexpr int MAZE_HEIGHT = CellsY;
+    static constexpr int WIDTH = PixelsX;                          // World bounds in pixels
+    static constexpr int HEIGHT = PixelsY;
+    static constexpr int INTERIOR_WIDTH = CellsX - 2;              // Cells inside the border
+    static constexpr int INTERIOR_CELLS = (CellsX - 2) * (CellsY - 2);
+    static constexpr int WALL_WORDS = (CellsX * CellsY + 63) / 64 + 1;   // Maze::Words() at this size
+
+    static_assert(CellsX >= 3 && CellsY >= 3, "Arena needs an interior inside its border");
+};
+
+// Arenas the simulation is compiled for (see the explicit instantiations at
+// the end of this file)
+typedef Arena<25, 19, WINDOW_WIDTH, WINDOW_HEIGHT> StandardArena;   // The original map
+typedef Arena<51, 39> LargeArena;                                    // 1632x1248
+typedef Arena<101, 77> HugeArena;                                    // 3232x2464
 
 // Tank structure
 struct Tank {
     float x, y;           // Position
+    float prevX, prevY;   // Position before the last tick (for render interpolation)
     float rotation;       // Rotation in radians
     float velocityX, velocityY; // Movement velocity
     bool alive;           // Is the tank alive?
     int cooldown;         // Shooting cooldown timer
-    int playerID;         // Player identifier (1 or 2)
+    int playerID;         // Player identifier (1-based)
     
     // Constructor
     Tank(float posX = 0, float posY = 0, int id = 1) 
-        : x(posX), y(posY), rotation(0), velocityX(0), velocityY(0), 
+        : x(posX), y(posY), prevX(posX), prevY(posY), rotation(0), velocityX(0), velocityY(0), 
           alive(true), cooldown(0), playerID(id) {}
     
-    // Update tank state
+    // Update tank state; the game state clamps the result to its arena
     void Update();
     
+    // Keep the tank inside a world of the given size
+    void ClampToBounds(int worldWidth, int worldHeight);
+    
     // Move tank
     void Move(float dx, float dy);
     
@@ -54,6 +110,7 @@ struct Tank {
 // Bullet structure
 struct Bullet {
     float x, y;           // Position
+    float prevX, prevY;   // Position before the last tick (for render interpolation)
     float velocityX, velocityY; // Movement velocity
     bool active;          // Is the bullet active?
     int lifetime;         // Remaining lifetime
@@ -62,89 +119,179 @@ struct Bullet {
     
     // Constructor
     Bullet(float posX = 0, float posY = 0, float velX = 0, float velY = 0, int owner = 1)
-        : x(posX), y(posY), velocityX(velX), velocityY(velY), 
+        : x(posX), y(posY), prevX(posX), prevY(posY), velocityX(velX), velocityY(velY), 
           active(true), lifetime(BULLET_LIFETIME), ownerID(owner), bounceCount(0) {}
     
-    // Update bullet state
+    // Age the bullet; movement is swept against the maze by GameState::MoveBullet
     void Update();
-    
-    // Move bullet
-    void Move();
 };
 
-// Simple particle structure for effects
-struct Particle {
-    float x, y;
-    float velocityX, velocityY;
-    int lifetime;
-    bool active;
-    
-    Particle(float posX = 0, float posY = 0, float velX = 0, float velY = 0)
-        : x(posX), y(posY), velocityX(velX), velocityY(velY), 
-          lifetime(20), active(true) {}
-    
-    void Update() {
-        if (active) {
-            x += velocityX;
-            y += velocityY;
-            velocityX *= 0.95f; // Slow down over time
-            velocityY *= 0.95f;
-            lifetime--;
-            if (lifetime <= 0) {
-                active = false;
-            }
-        }
-    }
+// Result of a swept query against the maze grid
+struct WallHit {
+    float t;              // Fraction of the segment travelled before the hit (0..1)
+    int normalX, normalY; // Face normal of the wall that was hit (axis-aligned)
+    int cellX, cellY;     // Wall cell that was entered
+};
+
+// Match counters kept by the simulation for analytics.
+// They are not part of snapshots, so after a rollback they also count the
+// re-simulated ticks; they are meant for linear runs such as headless
+// matches and replay playback.
+struct GameStats {
+    uint32_t shotsFired[MAX_PLAYERS];                   // Bullets spawned per player
+    uint32_t kills;                                     // Tanks destroyed
+    int32_t firstKillTick;                              // Tick of the first kill, -1 if none
+    uint32_t bulletsByBounces[MAX_BULLET_BOUNCES + 1];  // Retired bullets by bounces made
+    
+    GameStats() { Clear(); }
+    
+    void Clear();
+    
+    // Count a bullet leaving play
+    void RetireBullet(const Bullet& bullet);
 };
 
-// Maze cell structure
-struct MazeCell {
-    bool wall;            // Is this cell a wall?
+// Fixed-capacity bullet pool
+// Live bullets are kept densely packed at the front of a buffer allocated once
+// up front, so the update pass is a linear scan and spawning or removing a
+// bullet never touches the heap. Removal swaps the last live bullet into the
+// freed slot, which means iteration order is not preserved across removals.
+struct BulletPool {
+    static const int DEFAULT_CAPACITY = 4096;
     
     // Constructor
-    MazeCell(bool isWall = false) : wall(isWall) {}
+    explicit BulletPool(int capacity = DEFAULT_CAPACITY);
+    
+    // Add a bullet; returns false if the pool is full
+    bool Spawn(const Bullet& bullet);
+    
+    // Remove the bullet at index in O(1) by swapping in the last live bullet
+    void Remove(int index);
+    
+    // Remove all bullets
+    void Clear() { count = 0; }
+    
+    // Replace the contents with n bullets copied from source (truncated to capacity)
+    void Assign(const Bullet* source, int n);
+    
+    int Count() const { return count; }
+    int Capacity() const { return (int)storage.size(); }
+    bool Full() const { return count >= (int)storage.size(); }
+    
+    Bullet& operator[](int index) { return storage[index]; }
+    const Bullet& operator[](int index) const { return storage[index]; }
+    
+    Bullet* begin() { return storage.data(); }
+    Bullet* end() { return storage.data() + count; }
+    const Bullet* begin() const { return storage.data(); }
+    const Bullet* end() const { return storage.data() + count; }
+    
+private:
+    std::vector<Bullet> storage; // Allocated once, never resized
+    int count;                   // Number of live bullets
 };
 
-// Game state structure
-struct GameState {
-    static const int MAZE_WIDTH = 25;
-    static const int MAZE_HEIGHT = 19;
+// Game state structure, parameterized on its arena (see Arena)
+template <typename ArenaT>
+struct BasicGameState {
+    typedef ArenaT ArenaType;
+    static constexpr int MAZE_WIDTH = ArenaT::MAZE_WIDTH;
+    static constexpr int MAZE_HEIGHT = ArenaT::MAZE_HEIGHT;
     
-    MazeCell maze[MAZE_WIDTH][MAZE_HEIGHT]; // Maze layout
-    Tank tanks[2];                          // Two tanks (player 1 and 2)
-    std::vector<Bullet> bullets;            // Active bullets
-    std::vector<Particle> particles;        // Particle effects
+    Maze maze;                              // Maze layout (bit-packed)
+    std::array<uint64_t, ArenaT::WALL_WORDS> walls; // Copy of maze's wall bits read by the simulation
+    MazeGenerator mazeGenerator;            // Algorithm used by Initialize
+    uint32_t mazeSeed;                      // Seed the current maze was generated from
+    int playerCount;                        // Number of players in the match
+    uint32_t tick;                          // Ticks simulated since Initialize
+    Tank tanks[MAX_PLAYERS];                // Tanks, indexed by playerID - 1
+    BulletPool bullets;                     // Active bullets
+    ParticleSystem particles;               // Particle effects
+    SpatialHash tankHash;                   // Broadphase over alive tanks, rebuilt every tick
     bool gameRunning;                       // Is the game currently running?
-    int scores[2];                          // Scores for each player
+    int scores[MAX_PLAYERS];                // Scores for each player
     bool gameOver;                          // Is the game over?
     int winner;                             // Winner player ID (0 if tie, -1 if not finished)
+    GameStats stats;                        // Counters since Initialize
     
-    // Constructor
-    GameState();
+    // Constructor; particleCapacity 0 leaves out particles for states that
+    // are never rendered
+    explicit BasicGameState(int players = 2, int particleCapacity = ParticleSystem::DEFAULT_CAPACITY);
     
-    // Initialize the game state
+    // Initialize the game state with a time-based seed
     void Initialize();
     
+    // Initialize the game state with an explicit maze seed
+    void Initialize(unsigned int seed);
+    
     // Update the game state
     void Update();
     
-    // Render the game state
-    void Render(HDC hdc);
-    
-    // Handle input
+    // Handle local keyboard input for players 1 (arrows/space) and 2 (WASD/E)
     void HandleInput(bool keys[256]);
     
+    // InputButton flags for a key layout: 0 = arrows/space, 1 = WASD/E
+    static uint8_t ButtonsFromKeys(const bool keys[256], int scheme);
+    
+    // Apply one tick of InputButton flags to a player (0-based index)
+    void ApplyInput(int player, uint8_t buttons);
+    
     // Check collision between a bullet and walls
     bool CheckWallCollision(float x, float y);
     
+    // Is the given maze cell a wall? Cells outside the maze count as walls.
+    bool IsWall(int cellX, int cellY) const;
+    
+    // Walk the grid cells crossed by the segment from (x, y) to (x + dx, y + dy)
+    // (Amanatides-Woo traversal) and report the first wall cell entered
+    bool RaycastWalls(float x, float y, float dx, float dy, WallHit& hit) const;
+    
+    // Move a bullet for one tick, reflecting off every wall crossed on the way
+    void MoveBullet(Bullet& bullet);
+    
     // Check collision between a bullet and a tank
     bool CheckTankCollision(float x, float y, int ignoreTank);
     
+    // Index of the first alive tank (other than ignoreTank) containing the point, or -1
+    int FindTankAt(float x, float y, int ignoreTank) const;
+    
+    // Spawn position for a player, spread over the open cells of the maze
+    void GetSpawnPosition(int player, float& x, float& y) const;
+    
+    // Re-insert every alive tank into the broadphase
+    void RebuildTankHash();
+    
+    // Push apart overlapping tanks; returns true if any tank moved
+    bool SeparateTanks();
+    
+    // Copy the simulation state into a flat snapshot (see snapshot.h); false
+    // if there are more bullets than SNAPSHOT_MAX_BULLETS, which are left out
+    bool SaveSnapshot(GameSnapshot& snapshot) const;
+    
+    // Replace the simulation state with a snapshot's contents
+    void RestoreSnapshot(const GameSnapshot& snapshot);
+    
     // Reset the game
     void Reset();
     
     // Add explosion particles
     void AddExplosion(float x, float y);
+    
+private:
+    // Refresh walls from maze; call whenever the maze is regenerated
+    void CopyWalls();
+    
+    // Are all 8 cells around (cellX, cellY) open? Same as
+    // Maze::SurroundingsOpen with the row stride known at compile time.
+    bool SurroundingsOpen(int cellX, int cellY) const;
 };
 
+// The simulation as played on the standard map
+typedef BasicGameState<StandardArena> GameState;
+
+// Defined in game.cpp and snapshot.cpp for these arenas only
+extern template struct BasicGameState<StandardArena>;
+extern template struct BasicGameState<LargeArena>;
+extern template struct BasicGameState<HugeArena>;
+
 #endif // GAME_H
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "game_server.h"
+#include "profiler.h"
+#include <chrono>
+
+// GameServer methods
+GameServer::GameServer(int workerThreads, unsigned int seed)
+    : runtime(workerThreads), waitingRoom(-1), runningRooms(0), nextSeed(seed), writer(WIRE_MAX_PACKET_BYTES),
+      ticks(0), roundsStarted(0), oversizedSnapshots(0) {
+}
+
+bool GameServer::Start(uint16_t port) {
+    return io.Start(port);
+}
+
+void GameServer::Stop() {
+    io.Stop();
+    clients.clear();
+    for (int room = 0; room < (int)seats.size(); room++) {
+        if (seats[room].seated > 0) {
+            seats[room].seated = 0;
+            runtime.GetRoom(room).active = false;
+            freeRooms.push_back(room);
+        }
+    }
+    waitingRoom = -1;
+    runningRooms = 0;
+}
+
+void GameServer::Tick() {
+    TROUBLE_PROFILE_SCOPE("ServerTick");
+    auto start = std::chrono::steady_clock::now();
+
+    while (const ServerEvent* event = io.PeekEvent()) {
+        HandleEvent(*event);
+        io.PopEvent();
+    }
+
+    runtime.TickAll();
+
+    for (int room = 0; room < RoomCount(); room++) {
+        if (!runtime.GetRoom(room).active) {
+            continue;
+        }
+        if (runtime.GetRoom(room).state.gameOver) {
+            StartRound(room);
+        } else {
+            SendSnapshots(room);
+        }
+    }
+    io.Flush();
+
+    ticks++;
+    tickTime.Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
+void GameServer::HandleEvent(const ServerEvent& event) {
+    switch (event.type) {
+        case SERVER_CONNECTED: {
+            Client* client = new Client();
+            client->connection = event.connection;
+            client->room = -1;
+            client->player = 0;
+            clients[event.connection] = std::unique_ptr<Client>(client);
+            SeatClient(*client);
+            break;
+        }
+        case SERVER_DISCONNECTED:
+            RemoveClient(event.connection);
+            break;
+        case SERVER_LEAVE:
+            RemoveClient(event.connection);
+            io.Close(event.connection);
+            break;
+        case SERVER_INPUT: {
+            auto found = clients.find(event.connection);
+            if (found != clients.end() && found->second->room >= 0) {
+                runtime.GetRoom(found->second->room).inputs[found->second->player] = event.buttons;
+            }
+            break;
+        }
+        case SERVER_SNAPSHOT_ACK: {
+            auto found = clients.find(event.connection);
+            if (found != clients.end()) {
+                found->second->encoder.Acknowledge(event.sequence);
+            }
+            break;
+        }
+    }
+}
+
+void GameServer::SeatClient(Client& client) {
+    int room = waitingRoom;
+    if (room < 0) {
+        if (!freeRooms.empty()) {
+            room = freeRooms.back();
+            freeRooms.pop_back();
+        } else {
+            room = runtime.CreateRoom(SERVER_ROOM_PLAYERS, nextSeed++);
+            runtime.GetRoom(room).active = false;
+            seats.push_back(Seats());
+        }
+        seats[room].seated = 0;
+        waitingRoom = room;
+    }
+
+    Seats& seat = seats[room];
+    client.room = room;
+    client.player = seat.seated;
+    client.encoder.Reset();
+    seat.connections[seat.seated++] = client.connection;
+
+    JoinedPacket joined;
+    joined.room = (uint32_t)room;
+    joined.player = (uint8_t)client.player;
+    io.SendPacket(client.connection, joined);
+
+    if (seat.seated == SERVER_ROOM_PLAYERS) {
+        waitingRoom = -1;
+        runningRooms++;
+        StartRound(room);
+    }
+}
+
+void GameServer::RemoveClient(uint32_t connection) {
+    auto found = clients.find(connection);
+    if (found == clients.end()) {
+        return;
+    }
+    int room = found->second->room;
+    clients.erase(found);
+    if (room < 0) {
+        return;
+    }
+
+    // Everyone else in the room loses their match and waits for a new one
+    Seats& seat = seats[room];
+    std::vector<uint32_t> others;
+    for (int i = 0; i < seat.seated; i++) {
+        if (seat.connections[i] != connection) {
+            others.push_back(seat.connections[i]);
+        }
+    }
+    if (runtime.GetRoom(room).active) {
+        runningRooms--;
+    }
+    runtime.GetRoom(room).active = false;
+    seat.seated = 0;
+    if (waitingRoom == room) {
+        waitingRoom = -1;
+    }
+    freeRooms.push_back(room);
+
+    for (uint32_t other : others) {
+        Client& client = *clients[other];
+        io.SendPacket(other, DisconnectPacket());
+        SeatClient(client);
+    }
+}
+
+void GameServer::StartRound(int room) {
+    StartPacket start;
+    start.seed = nextSeed++;
+
+    Room& match = runtime.GetRoom(room);
+    match.state.Initialize(start.seed);
+    match.state.particles.Clear();
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        match.inputs[i] = 0;
+    }
+    match.active = true;
+    roundsStarted++;
+
+    const Seats& seat = seats[room];
+    for (int i = 0; i < seat.seated; i++) {
+        io.SendPacket(seat.connections[i], start);
+    }
+}
+
+void GameServer::SendSnapshots(int room) {
+    const GameState& state = runtime.GetRoom(room).state;
+    const Seats& seat = seats[room];
+    for (int i = 0; i < seat.seated; i++) {
+        Client& client = *clients[seat.connections[i]];
+
+        // Each client gets only the bullets its own view can show. The
+        // standard arena fits the view, so there nothing is culled.
+        const Tank& tank = state.tanks[client.player];
+        client.view.Follow(tank.x + TANK_WIDTH / 2.0f, tank.y + TANK_HEIGHT / 2.0f, GameState::ArenaType::WIDTH,
+                           GameState::ArenaType::HEIGHT);
+        BuildGameStatePacket(state, client.view, packet);
+        writer.Clear();
+        client.encoder.Encode(packet, writer);
+        if (!FitsOnWire(writer)) {
+            oversizedSnapshots++;
+            continue;
+        }
+        io.Send(client.connection, writer.Data(), writer.Size());
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef GAME_SERVER_H
+#define GAME_SERVER_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "bitstream.h"
+#include "camera.h"
+#include "latency_histogram.h"
+#include "packets.h"
+#include "room_runtime.h"
+#include "server_io.h"
+#include "snapshot_delta.h"
+
+const int SERVER_ROOM_PLAYERS = 2;
+
+// Authoritative dedicated server: matches TCP clients into 2-player rooms
+// and runs every room's GameState on a RoomRuntime.
+// Clients connect, get a JoinedPacket with their room and player slot, and
+// a StartPacket with the maze seed once the room is full (and again for
+// each new round). They send an InputPacket per tick and ack the delta
+// snapshots (see snapshot_delta.h) they receive after every tick; each
+// snapshot holds every tank but only the bullets the client's window-sized
+// view around its own tank can show. When one
+// player leaves, the other is told with a DisconnectPacket and seated in
+// the next room. Sockets are handled by ServerIo on its own thread; Tick()
+// runs on the caller's thread and never waits on the network.
+class GameServer {
+public:
+    // workerThreads = 0 uses one room worker per hardware thread
+    GameServer(int workerThreads, unsigned int seed);
+
+    bool Start(uint16_t port);
+    void Stop();
+    uint16_t Port() const { return io.Port(); }
+
+    // Take in client events, tick every running room once and send each
+    // client its snapshot
+    void Tick();
+
+    int ClientCount() const { return (int)clients.size(); }
+    int RoomCount() const { return runtime.RoomCount(); }
+    int RunningRooms() const { return runningRooms; }
+    uint64_t Ticks() const { return ticks; }
+    uint64_t RoundsStarted() const { return roundsStarted; }
+
+    // Snapshots not sent because they encoded larger than WIRE_MAX_PACKET_BYTES
+    uint64_t OversizedSnapshots() const { return oversizedSnapshots; }
+
+    // Duration of each whole Tick(): events, simulation and snapshots
+    const LatencyHistogram& TickTime() const { return tickTime; }
+    void ClearTickTime() { tickTime.Clear(); }
+
+    const ServerCounters& IoCounters() const { return io.Counters(); }
+
+private:
+    struct Client {
+        uint32_t connection;
+        int room;                       // -1 while unseated
+        int player;
+        SnapshotDeltaEncoder encoder;
+        Camera view;                    // Follows the client's tank; culls its snapshots
+    };
+
+    // Who sits in each room of the runtime
+    struct Seats {
+        uint32_t connections[SERVER_ROOM_PLAYERS];
+        int seated;
+    };
+
+    void HandleEvent(const ServerEvent& event);
+    void SeatClient(Client& client);
+    void RemoveClient(uint32_t connection);
+    void StartRound(int room);
+    void SendSnapshots(int room);
+
+    ServerIo io;
+    RoomRuntime runtime;
+    std::unordered_map<uint32_t, std::unique_ptr<Client>> clients;
+    std::vector<Seats> seats;
+    std::vector<int> freeRooms;         // Rooms nobody sits in
+    int waitingRoom;                    // Room with one player waiting, or -1
+    int runningRooms;
+    unsigned int nextSeed;
+
+    GameStatePacket packet;             // Scratch for SendSnapshots, rebuilt per client
+    BitWriter writer;
+
+    LatencyHistogram tickTime;
+    uint64_t ticks;
+    uint64_t roundsStarted;
+    uint64_t oversizedSnapshots;
+};
+
+#endif // GAME_SERVER_H
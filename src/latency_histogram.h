@@ -0,0 +1,104 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Fixed-size log-linear histogram of durations in nanoseconds.
+// Values below 16 ns get exact buckets; above that every power of two is
+// split into 4 sub-buckets, so any percentile is within ~25% of the true
+// value. Recording is a few integer ops and the whole thing is a flat array,
+// so one can be kept per room or per thread without allocation.
+class LatencyHistogram {
+public:
+    static const int MAX_EXPONENT = 40; // ~18 minutes
+    static const int BUCKET_COUNT = 16 + (MAX_EXPONENT - 3) * 4;
+
+    LatencyHistogram() { Clear(); }
+
+    void Clear() {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        maxValue = 0;
+    }
+
+    void Record(uint64_t ns) {
+        buckets[BucketOf(ns)]++;
+        count++;
+        if (ns > maxValue) {
+            maxValue = ns;
+        }
+    }
+
+    void Merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        if (other.maxValue > maxValue) {
+            maxValue = other.maxValue;
+        }
+    }
+
+    uint64_t Count() const { return count; }
+    uint64_t Max() const { return maxValue; }
+
+    // Approximate value at percentile p (0-100)
+    uint64_t Percentile(double p) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(p / 100.0 * (double)(count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t value = BucketMidpoint(i);
+                return value < maxValue ? value : maxValue;
+            }
+        }
+        return maxValue;
+    }
+
+private:
+    static int BucketOf(uint64_t ns) {
+        if (ns < 16) {
+            return (int)ns;
+        }
+        int exponent = 63 - CountLeadingZeros(ns);
+        if (exponent > MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+        int sub = (int)((ns >> (exponent - 2)) & 3);
+        return 16 + (exponent - 4) * 4 + sub;
+    }
+
+    static uint64_t BucketMidpoint(int index) {
+        if (index < 16) {
+            return (uint64_t)index;
+        }
+        int exponent = 4 + (index - 16) / 4;
+        int sub = (index - 16) % 4;
+        uint64_t width = (uint64_t)1 << (exponent - 2);
+        return ((uint64_t)1 << exponent) + sub * width + width / 2;
+    }
+
+    static int CountLeadingZeros(uint64_t value) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return 63 - (int)index;
+#else
+        return __builtin_clzll(value);
+#endif
+    }
+
+    uint64_t buckets[BUCKET_COUNT];
+    uint64_t count;
+    uint64_t maxValue;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -14,6 +14,7 @@
 #include <comdef.h>
 #endif
 #include <cmath>
+#include <ctime>
 #include <cstdio>
 #include <cwchar>
 #include <shellapi.h>
@@ -21,6 +22,10 @@
 #include "game.h"
 #include "network.h"
 #include "main.h"
+#include "fixed_timestep.h"
+#include "rollback.h"
+#include "profiler.h"
+#include "camera.h"
 
 #pragma comment(lib, "gdiplus.lib")
 #pragma comment(lib, "winmm.lib")
@@ -60,19 +65,24 @@ RECT g_joinButtonRect = { 300, 300, 500, 350 };
 bool g_mousePressed = false;
 
 // Networking variables
-SOCKET g_listenSocket = INVALID_SOCKET;
-SOCKET g_clientSocket = INVALID_SOCKET;
+bool g_peerConnected = false;                 // A peer address is known
 bool g_isHost = false;
 char g_hostIP[256] = {0};
 int g_port = 8888;
+bool g_showProfiler = false;                 // Draw the per-phase timing overlay (F3)
+bool g_networkMatch = false;                 // Playing a peer through g_rollback
+RollbackSession g_rollback(g_gameState, 0);  // Prediction and rollback for network play
+Camera g_camera;                             // View onto the arena, following the local tank
 
 // Sound variables
 bool g_soundEnabled = true;
 
 // Game loop timing
-const int TARGET_FPS = 30;
+const int TICK_RATE = 60;                  // Simulation ticks per second
+const int TARGET_FPS = 60;                 // Render frames per second
 const int FRAME_DELAY = 1000 / TARGET_FPS;
 bool g_gameRunning = true;
+float g_renderAlpha = 1.0f;                // Interpolation factor between the last two ticks
 
 // Function prototypes
 LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
@@ -84,10 +94,13 @@ void LoadGameResources();
 void UnloadGameResources();
 void RenderMenu(HDC hdc);
 void RenderGameState(HDC hdc);
+void RenderProfilerOverlay(HDC hdc);
 void HandleInput();
 bool BeginHosting();  // Renamed from StartHosting to avoid conflict
 void StartJoining();
 void UpdateNetwork();
+void StartNetworkMatch(uint32_t seed, int localPlayer);
+void AdvanceNetworkTick();
 void PlaySoundEffect(int soundId);
 
 // Entry point
@@ -156,9 +169,15 @@ int APIENTRY wWinMain(HINSTANCE hInstance,
     // Load game resources
     LoadGameResources();
 
-    // Main message loop with game loop
+    // Main message loop with fixed-timestep game loop. The simulation runs
+    // exactly TICK_RATE ticks per second from an accumulator; rendering runs
+    // at TARGET_FPS and interpolates between the last two ticks.
     MSG msg = {0};
-    DWORD lastTime = GetTickCount();
+    FixedTimestep timestep(TICK_RATE);
+    FixedTimestep::Clock::time_point lastRender = FixedTimestep::Clock::now();
+    
+    // Ask for 1 ms timer resolution so Sleep can wait until the next tick
+    timeBeginPeriod(1);
     
     while (g_gameRunning) {
         // Handle Windows messages
@@ -171,9 +190,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance,
             DispatchMessage(&msg);
         }
         
-        // Calculate delta time
-        DWORD currentTime = GetTickCount();
-        DWORD deltaTime = currentTime - lastTime;
+        // Number of simulation ticks due since the last pass
+        int ticks = timestep.Advance();
         
         // Update game state based on current state
         switch (g_currentState) {
@@ -187,21 +205,42 @@ int APIENTRY wWinMain(HINSTANCE hInstance,
                 // In a real implementation, we would handle joining logic here
                 break;
             case GAME_STATE:
-                HandleInput();
-                g_gameState.Update();
-                UpdateNetwork(); // Handle networking updates
-                InvalidateRect(g_hWnd, NULL, FALSE); // Trigger repaint
+                for (int i = 0; i < ticks; i++) {
+                    UpdateNetwork(); // Handle networking updates
+                    if (g_networkMatch) {
+                        // Wait for the peer rather than outrun the rollback window
+                        if (!g_rollback.CanAdvance()) {
+                            break;
+                        }
+                        AdvanceNetworkTick();
+                    } else {
+                        HandleInput();
+                        g_gameState.Update();
+                    }
+                }
                 break;
         }
         
-        // Update at target FPS
-        if (deltaTime >= FRAME_DELAY) {
-            lastTime = currentTime;
+        // Render at target FPS
+        FixedTimestep::Clock::time_point now = FixedTimestep::Clock::now();
+        double sinceRender = std::chrono::duration<double>(now - lastRender).count();
+        double untilFrame = FRAME_DELAY / 1000.0 - sinceRender;
+        if (g_currentState == GAME_STATE && untilFrame <= 0) {
+            lastRender = now;
+            g_renderAlpha = (float)timestep.Alpha();
+            InvalidateRect(g_hWnd, NULL, FALSE); // Trigger repaint
+            untilFrame = FRAME_DELAY / 1000.0;
         }
         
-        // Small delay to prevent excessive CPU usage
-        Sleep(1);
+        // Sleep until the next tick or frame is due instead of spinning
+        double untilNext = timestep.TimeUntilNextTick();
+        if (untilFrame < untilNext) {
+            untilNext = untilFrame;
+        }
+        Sleep(untilNext > 0.001 ? (DWORD)(untilNext * 1000.0) : 0);
     }
+    
+    timeEndPeriod(1);
 
     // Cleanup
     UnloadGameResources();
@@ -307,10 +346,18 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             g_keys[wParam] = true;
         }
         
-        // Handle restart key
-        if (wParam == 'R' && g_gameState.gameOver) {
+        // Handle restart key (local play only; a restart would desync a peer)
+        if (wParam == 'R' && g_gameState.gameOver && !g_networkMatch) {
             g_gameState.Reset();
         }
+        
+        // Profiler overlay and trace dump (no-ops unless the profiler is compiled in)
+        if (wParam == VK_F3 && ProfilerEnabled()) {
+            g_showProfiler = !g_showProfiler;
+        }
+        if (wParam == VK_F4) {
+            WriteProfilerTrace("trouble_trace.json");
+        }
         break;
     case WM_KEYUP:
         if (wParam >= 0 && wParam < 256) {
@@ -568,6 +615,8 @@ void RenderMenu(HDC hdc) {
 //  PURPOSE: Renders the current game state
 //
 void RenderGameState(HDC hdc) {
+    TROUBLE_PROFILE_SCOPE("RenderGameState");
+    
     // Create compatible DC for double buffering
     HDC memDC = CreateCompatibleDC(hdc);
     HBITMAP hBitmap = CreateCompatibleBitmap(hdc, WINDOW_WIDTH, WINDOW_HEIGHT);
@@ -579,51 +628,64 @@ void RenderGameState(HDC hdc) {
     FillRect(memDC, &backgroundRect, hBackgroundBrush);
     DeleteObject(hBackgroundBrush);
     
+    // Follow the local tank. The standard arena fits the window, so there the
+    // camera stays at the origin and nothing is culled.
+    const Tank& followed = g_gameState.tanks[g_networkMatch ? g_rollback.LocalPlayer() : 0];
+    g_camera.Follow(followed.x + TANK_WIDTH / 2.0f, followed.y + TANK_HEIGHT / 2.0f,
+                    GameState::ArenaType::WIDTH, GameState::ArenaType::HEIGHT);
+    
     // Draw maze with better visual styling
-    for (int x = 0; x < GameState::MAZE_WIDTH; x++) {
-        for (int y = 0; y < GameState::MAZE_HEIGHT; y++) {
-            if (g_gameState.maze[x][y].wall) {
-                if (g_hWallBitmap) {
-                    HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, g_hWallBitmap);
-                    BitBlt(memDC, x * WALL_SIZE, y * WALL_SIZE, WALL_SIZE, WALL_SIZE, memDC, 0, 0, SRCCOPY);
-                    SelectObject(memDC, oldBitmap);
-                } else {
-                    // Fallback: draw a textured rectangle
-                    RECT rect = { x * WALL_SIZE, y * WALL_SIZE, (x + 1) * WALL_SIZE, (y + 1) * WALL_SIZE };
-                    HBRUSH hBrush = CreateSolidBrush(RGB(100, 100, 100)); // Dark gray wall
-                    FillRect(memDC, &rect, hBrush);
-                    DeleteObject(hBrush);
-                    
-                    // Add border for better visibility
-                    HPEN hPen = CreatePen(PS_SOLID, 1, RGB(50, 50, 50));
-                    HPEN hOldPen = (HPEN)SelectObject(memDC, hPen);
-                    MoveToEx(memDC, x * WALL_SIZE, y * WALL_SIZE, NULL);
-                    LineTo(memDC, (x + 1) * WALL_SIZE, y * WALL_SIZE);
-                    LineTo(memDC, (x + 1) * WALL_SIZE, (y + 1) * WALL_SIZE);
-                    LineTo(memDC, x * WALL_SIZE, (y + 1) * WALL_SIZE);
-                    LineTo(memDC, x * WALL_SIZE, y * WALL_SIZE);
-                    SelectObject(memDC, hOldPen);
-                    DeleteObject(hPen);
-                }
-            }
+    // Walk the set bits of the visible part of each bit-packed maze row instead of testing every cell
+    ForEachVisibleWall(g_gameState.maze, g_camera, [&](int cellX, int cellY) {
+        int x = g_camera.ScreenX((float)(cellX * WALL_SIZE));
+        int y = g_camera.ScreenY((float)(cellY * WALL_SIZE));
+        if (g_hWallBitmap) {
+            HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, g_hWallBitmap);
+            BitBlt(memDC, x, y, WALL_SIZE, WALL_SIZE, memDC, 0, 0, SRCCOPY);
+            SelectObject(memDC, oldBitmap);
+        } else {
+            // Fallback: draw a textured rectangle
+            RECT rect = { x, y, x + WALL_SIZE, y + WALL_SIZE };
+            HBRUSH hBrush = CreateSolidBrush(RGB(100, 100, 100)); // Dark gray wall
+            FillRect(memDC, &rect, hBrush);
+            DeleteObject(hBrush);
+            
+            // Add border for better visibility
+            HPEN hPen = CreatePen(PS_SOLID, 1, RGB(50, 50, 50));
+            HPEN hOldPen = (HPEN)SelectObject(memDC, hPen);
+            MoveToEx(memDC, x, y, NULL);
+            LineTo(memDC, x + WALL_SIZE, y);
+            LineTo(memDC, x + WALL_SIZE, y + WALL_SIZE);
+            LineTo(memDC, x, y + WALL_SIZE);
+            LineTo(memDC, x, y);
+            SelectObject(memDC, hOldPen);
+            DeleteObject(hPen);
         }
-    }
+    });
     
     // Draw tanks with better positioning
     for (int i = 0; i < 2; i++) {
         if (g_gameState.tanks[i].alive) {
+            // Interpolate between the last two ticks
+            const Tank& tank = g_gameState.tanks[i];
+            float worldX = tank.prevX + (tank.x - tank.prevX) * g_renderAlpha;
+            float worldY = tank.prevY + (tank.y - tank.prevY) * g_renderAlpha;
+            if (!g_camera.Sees(worldX, worldY, worldX + TANK_WIDTH, worldY + TANK_HEIGHT)) {
+                continue;
+            }
+            int tankX = g_camera.ScreenX(worldX);
+            int tankY = g_camera.ScreenY(worldY);
             HBITMAP hTankBitmap = (i == 0) ? g_hTank1Bitmap : g_hTank2Bitmap;
             
             if (hTankBitmap) {
                 HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, hTankBitmap);
                 // Use StretchBlt for better scaling if needed
-                StretchBlt(memDC, (int)g_gameState.tanks[i].x, (int)g_gameState.tanks[i].y, 
+                StretchBlt(memDC, tankX, tankY, 
                           TANK_WIDTH, TANK_HEIGHT, memDC, 0, 0, TANK_WIDTH, TANK_HEIGHT, SRCCOPY);
                 SelectObject(memDC, oldBitmap);
             } else {
                 // Fallback: draw a colored rectangle with direction indicator
-                RECT rect = { (int)g_gameState.tanks[i].x, (int)g_gameState.tanks[i].y, 
-                              (int)g_gameState.tanks[i].x + TANK_WIDTH, (int)g_gameState.tanks[i].y + TANK_HEIGHT };
+                RECT rect = { tankX, tankY, tankX + TANK_WIDTH, tankY + TANK_HEIGHT };
                 HBRUSH hBrush = CreateSolidBrush((i == 0) ? RGB(0, 200, 0) : RGB(200, 0, 0)); // Darker colors
                 FillRect(memDC, &rect, hBrush);
                 DeleteObject(hBrush);
@@ -631,8 +693,8 @@ void RenderGameState(HDC hdc) {
                 // Draw direction indicator (simple line pointing in tank direction)
                 HPEN hPen = CreatePen(PS_SOLID, 2, RGB(255, 255, 255));
                 HPEN hOldPen = (HPEN)SelectObject(memDC, hPen);
-                int centerX = (int)g_gameState.tanks[i].x + TANK_WIDTH / 2;
-                int centerY = (int)g_gameState.tanks[i].y + TANK_HEIGHT / 2;
+                int centerX = tankX + TANK_WIDTH / 2;
+                int centerY = tankY + TANK_HEIGHT / 2;
                 int endX = centerX + (int)(cos(g_gameState.tanks[i].rotation) * (TANK_WIDTH / 2));
                 int endY = centerY + (int)(sin(g_gameState.tanks[i].rotation) * (TANK_HEIGHT / 2));
                 MoveToEx(memDC, centerX, centerY, NULL);
@@ -646,11 +708,19 @@ void RenderGameState(HDC hdc) {
     // Draw bullets with visual enhancements
     for (const Bullet& bullet : g_gameState.bullets) {
         if (bullet.active) {
+            // Interpolate between the last two ticks; the margin keeps trails visible
+            float worldX = bullet.prevX + (bullet.x - bullet.prevX) * g_renderAlpha;
+            float worldY = bullet.prevY + (bullet.y - bullet.prevY) * g_renderAlpha;
+            if (!g_camera.Sees(worldX, worldY, worldX + BULLET_WIDTH, worldY + BULLET_HEIGHT, 2 * BULLET_SPEED)) {
+                continue;
+            }
+            int bulletX = g_camera.ScreenX(worldX);
+            int bulletY = g_camera.ScreenY(worldY);
             HBITMAP hBulletBitmap = (bullet.ownerID == 1) ? g_hBullet1Bitmap : g_hBullet2Bitmap;
             
             if (hBulletBitmap) {
                 HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, hBulletBitmap);
-                BitBlt(memDC, (int)bullet.x, (int)bullet.y, 
+                BitBlt(memDC, bulletX, bulletY, 
                        BULLET_WIDTH, BULLET_HEIGHT, memDC, 0, 0, SRCCOPY);
                 SelectObject(memDC, oldBitmap);
             } else {
@@ -660,8 +730,8 @@ void RenderGameState(HDC hdc) {
                 HPEN hPen = CreatePen(PS_SOLID, 1, RGB(0, 0, 0));
                 HPEN hOldPen = (HPEN)SelectObject(memDC, hPen);
                 
-                Ellipse(memDC, (int)bullet.x, (int)bullet.y, 
-                        (int)bullet.x + BULLET_WIDTH, (int)bullet.y + BULLET_HEIGHT);
+                Ellipse(memDC, bulletX, bulletY, 
+                        bulletX + BULLET_WIDTH, bulletY + BULLET_HEIGHT);
                 
                 SelectObject(memDC, hOldBrush);
                 SelectObject(memDC, hOldPen);
@@ -674,9 +744,9 @@ void RenderGameState(HDC hdc) {
                 HPEN hTrailPen = CreatePen(PS_SOLID, 1, 
                     (bullet.ownerID == 1) ? RGB(100, 255, 100) : RGB(255, 100, 100));
                 HPEN hOldTrailPen = (HPEN)SelectObject(memDC, hTrailPen);
-                MoveToEx(memDC, (int)bullet.x + BULLET_WIDTH/2, (int)bullet.y + BULLET_HEIGHT/2, NULL);
-                LineTo(memDC, (int)bullet.x + BULLET_WIDTH/2 - bullet.velocityX*2, 
-                       (int)bullet.y + BULLET_HEIGHT/2 - bullet.velocityY*2);
+                MoveToEx(memDC, bulletX + BULLET_WIDTH/2, bulletY + BULLET_HEIGHT/2, NULL);
+                LineTo(memDC, bulletX + BULLET_WIDTH/2 - bullet.velocityX*2, 
+                       bulletY + BULLET_HEIGHT/2 - bullet.velocityY*2);
                 SelectObject(memDC, hOldTrailPen);
                 DeleteObject(hTrailPen);
             }
@@ -684,19 +754,24 @@ void RenderGameState(HDC hdc) {
     }
     
     // Draw particles (explosion effects)
-    for (const Particle& particle : g_gameState.particles) {
-        if (particle.active) {
-            HBRUSH hBrush = CreateSolidBrush(RGB(255, 255, 0)); // Yellow particles
-            HBRUSH hOldBrush = (HBRUSH)SelectObject(memDC, hBrush);
-            
+    const ParticleSystem& particles = g_gameState.particles;
+    if (particles.Count() > 0) {
+        HBRUSH hBrush = CreateSolidBrush(RGB(255, 255, 0)); // Yellow particles
+        HBRUSH hOldBrush = (HBRUSH)SelectObject(memDC, hBrush);
+        
+        for (int i = 0; i < particles.Count(); i++) {
             // Make particles smaller as they age
-            int size = 2 + (particle.lifetime / 3);
-            Ellipse(memDC, (int)particle.x - size/2, (int)particle.y - size/2,
-                    (int)particle.x + size/2, (int)particle.y + size/2);
-            
-            SelectObject(memDC, hOldBrush);
-            DeleteObject(hBrush);
+            int size = 2 + (particles.Lifetime(i) / 3);
+            if (!g_camera.Sees(particles.X(i), particles.Y(i), particles.X(i), particles.Y(i), (float)size)) {
+                continue;
+            }
+            int px = g_camera.ScreenX(particles.X(i));
+            int py = g_camera.ScreenY(particles.Y(i));
+            Ellipse(memDC, px - size/2, py - size/2, px + size/2, py + size/2);
         }
+        
+        SelectObject(memDC, hOldBrush);
+        DeleteObject(hBrush);
     }
     
     // Draw scores with better styling
@@ -770,6 +845,10 @@ void RenderGameState(HDC hdc) {
         DeleteObject(hOverlayBrush);
     }
     
+    if (g_showProfiler) {
+        RenderProfilerOverlay(memDC);
+    }
+    
     // Blit the double-buffered image to the screen
     BitBlt(hdc, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, memDC, 0, 0, SRCCOPY);
     
@@ -779,6 +858,35 @@ void RenderGameState(HDC hdc) {
     DeleteDC(memDC);
 }
 
+//
+//  FUNCTION: RenderProfilerOverlay(HDC)
+//
+//  PURPOSE: Draws rolling p50/p99 of every profiled phase over the last second
+//
+void RenderProfilerOverlay(HDC hdc) {
+    PhaseSummary phases[16];
+    int count = SummarizeProfilerPhases(1000000000ULL, phases, 16);
+    
+    // Stock font, so the overlay adds no GDI object churn of its own
+    HFONT hOldFont = (HFONT)SelectObject(hdc, GetStockObject(DEFAULT_GUI_FONT));
+    SetTextColor(hdc, RGB(0, 0, 0));
+    SetBkMode(hdc, OPAQUE);
+    SetBkColor(hdc, RGB(255, 255, 224));
+    
+    char line[128];
+    int y = 44;
+    for (int i = 0; i < count; i++) {
+        int length = snprintf(line, sizeof(line), "%-20s %6u/s  p50 %8.1f us  p99 %8.1f us",
+                              phases[i].name, phases[i].count,
+                              phases[i].p50Ns / 1000.0, phases[i].p99Ns / 1000.0);
+        TextOutA(hdc, 10, y, line, length);
+        y += 16;
+    }
+    
+    SetBkMode(hdc, TRANSPARENT);
+    SelectObject(hdc, hOldFont);
+}
+
 //
 //  FUNCTION: BeginHosting()
 //
@@ -794,6 +902,7 @@ bool BeginHosting() {
         // For now, we'll simulate waiting for a connection
         // In a real implementation, this would be handled in a separate thread
         g_isHost = true;
+        g_networkMatch = false; // Local play until a peer connects
         g_currentState = GAME_STATE;
         // Initialize game as host (player 1)
         g_gameState.tanks[0].playerID = 1;
@@ -821,6 +930,7 @@ void StartJoining() {
     // For now, we'll just simulate joining with localhost
     if (ConnectToHost("127.0.0.1")) {
         g_isHost = false;
+        g_networkMatch = false; // Starts when the host sends the seed
         g_currentState = GAME_STATE;
         // Initialize game as client (player 2)
         g_gameState.tanks[0].playerID = 1;
@@ -857,41 +967,91 @@ void PlaySoundEffect(int soundId) {
 //  PURPOSE: Handles networking updates
 //
 void UpdateNetwork() {
-    if (g_clientSocket != INVALID_SOCKET) {
-        if (g_isHost) {
-            // Host sends game state to client
-            if (!SendGameStatePacket(g_clientSocket, g_gameState)) {
-                // Handle disconnection
-                HandleDisconnection();
-                g_currentState = MENU_STATE;
-                InvalidateRect(g_hWnd, NULL, TRUE);
-                return;
-            }
-            
-            // Host also receives input from client
-            bool clientKeys[256] = { false };
-            if (ReceiveInputPacket(g_clientSocket, clientKeys)) {
-                // Apply client input to player 2 (client controls player 2)
-                // In a real implementation, we would update the client's tank directly
-                // For now, we'll just show how it would work
-            }
-        } else {
-            // Client sends input to host
-            if (!SendInputPacket(g_clientSocket, g_keys)) {
-                // Handle disconnection
+    TROUBLE_PROFILE_SCOPE("UpdateNetwork");
+    
+    // Host picks up a waiting peer and starts a match with it
+    if (g_isHost && !g_peerConnected) {
+        if (AcceptPeer()) {
+            uint32_t seed = (uint32_t)time(nullptr);
+            if (!SendStartPacket(seed)) {
                 HandleDisconnection();
                 g_currentState = MENU_STATE;
                 InvalidateRect(g_hWnd, NULL, TRUE);
                 return;
             }
-            
-            // Client receives game state from host
-            GameState receivedState;
-            if (ReceiveGameStatePacket(g_clientSocket, receivedState)) {
-                // Update local game state with received state
-                g_gameState = receivedState;
-            }
+            StartNetworkMatch(seed, 0);
         }
+        return;
+    }
+    
+    if (!g_peerConnected) {
+        return;
+    }
+    
+    // The peer said goodbye or has gone silent
+    PumpNetwork();
+    if (PeerDisconnected()) {
+        HandleDisconnection();
+        g_networkMatch = false;
+        g_currentState = MENU_STATE;
+        InvalidateRect(g_hWnd, NULL, TRUE);
+        return;
+    }
+    
+    // Client waits for the host to pick the maze seed; the network thread's
+    // keepalives let the host learn its address meanwhile
+    if (!g_networkMatch) {
+        uint32_t seed;
+        if (ReceiveStartPacket(seed)) {
+            StartNetworkMatch(seed, 1);
+        }
+        return;
+    }
+    
+    // Feed every input the peer has sent so far into the rollback session
+    int remotePlayer = 1 - g_rollback.LocalPlayer();
+    uint32_t tick;
+    uint8_t buttons;
+    while (ReceiveInputPacket(tick, buttons)) {
+        g_rollback.AddRemoteInput(remotePlayer, tick, buttons);
+    }
+}
+
+//
+//  FUNCTION: StartNetworkMatch(uint32_t, int)
+//
+//  PURPOSE: Starts both peers from the same seed and tick
+//
+void StartNetworkMatch(uint32_t seed, int localPlayer) {
+    g_gameState.Initialize(seed);
+    g_gameState.particles.Clear();
+    g_rollback.Reset(localPlayer);
+    g_networkMatch = true;
+}
+
+//
+//  FUNCTION: AdvanceNetworkTick()
+//
+//  PURPOSE: Sends the local input for this tick and simulates it at once,
+//           predicting the peer's input until it arrives
+//
+void AdvanceNetworkTick() {
+    int local = g_rollback.LocalPlayer();
+    
+    // Both peers drive their own tank with the arrow keys
+    uint8_t buttons = GameState::ButtonsFromKeys(g_keys, 0);
+    if (!SendInputPacket(g_gameState.tick, buttons)) {
+        HandleDisconnection();
+        g_networkMatch = false;
+        g_currentState = MENU_STATE;
+        InvalidateRect(g_hWnd, NULL, TRUE);
+        return;
+    }
+    
+    int prevCooldown = g_gameState.tanks[local].cooldown;
+    g_rollback.AdvanceTick(buttons);
+    if (prevCooldown == 0 && g_gameState.tanks[local].cooldown > 0) {
+        PlaySoundEffect(IDS_SHOOT_SOUND);
     }
 }
 
@@ -901,6 +1061,8 @@ void UpdateNetwork() {
 //  PURPOSE: Processes user input
 //
 void HandleInput() {
+    TROUBLE_PROFILE_SCOPE("HandleInput");
+    
     // Store previous cooldowns to detect when a tank shoots
     int prevCooldown1 = g_gameState.tanks[0].cooldown;
     int prevCooldown2 = g_gameState.tanks[1].cooldown;
@@ -21,9 +21,11 @@ extern HBITMAP g_hBullet2Bitmap;
 extern HBITMAP g_hWallBitmap;
 
 // Game loop timing
+extern const int TICK_RATE;
 extern const int TARGET_FPS;
 extern const int FRAME_DELAY;
 extern bool g_gameRunning;
+extern float g_renderAlpha;
 
 // Game state management
 enum GameStateEnum {
@@ -41,8 +43,7 @@ extern RECT g_joinButtonRect;
 extern bool g_mousePressed;
 
 // Networking variables
-extern SOCKET g_listenSocket;
-extern SOCKET g_clientSocket;
+extern bool g_peerConnected;
 extern bool g_isHost;
 extern char g_hostIP[256];
 extern int g_port;
@@ -0,0 +1,92 @@
+#include "maze.h"
+
+void Maze::Resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    size_t cells = (size_t)width * height;
+    bits.assign((cells + 63) / 64 + 1, 0);
+    edges.assign((cells + 1) / 2, 0);
+}
+
+void Maze::Fill(bool wall) {
+    if (!wall) {
+        bits.assign(bits.size(), 0);
+        return;
+    }
+
+    // Keep the bits past the last cell clear, including the spare word
+    size_t cells = (size_t)width * height;
+    size_t full = cells / 64;
+    for (size_t w = 0; w < bits.size(); w++) {
+        if (w < full) {
+            bits[w] = ~(uint64_t)0;
+        } else if (w == full && (cells & 63) != 0) {
+            bits[w] = ((uint64_t)1 << (cells & 63)) - 1;
+        } else {
+            bits[w] = 0;
+        }
+    }
+}
+
+void Maze::BuildNeighborMasks() {
+    // Work up to 64 cells at a time: read the runs above, at and below, and
+    // the run shifted one cell either way, so that bit i of each is the
+    // corresponding neighbor of cell x + i, then gather 4 bits per cell
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x += 64) {
+            int count = (width - x < 64) ? width - x : 64;
+            uint64_t run = RowBits(y, x, count);
+            uint64_t north = (y > 0) ? RowBits(y - 1, x, count) : ~(uint64_t)0;
+            uint64_t south = (y < height - 1) ? RowBits(y + 1, x, count) : ~(uint64_t)0;
+            uint64_t west = (run << 1) | (uint64_t)IsWall(x - 1, y);
+            uint64_t east = (run >> 1) | ((uint64_t)IsWall(x + count, y) << (count - 1));
+
+            size_t cell = (size_t)y * width + x;
+            for (int i = 0; i < count; i++, cell++) {
+                uint8_t mask = (uint8_t)(
+                    ((north >> i) & 1) << 0 |   // N
+                    ((east >> i) & 1) << 1 |    // E
+                    ((south >> i) & 1) << 2 |   // S
+                    ((west >> i) & 1) << 3);    // W
+                int shift = (int)(cell & 1) * 4;
+                edges[cell >> 1] = (uint8_t)((edges[cell >> 1] & ~(0xF << shift)) | (mask << shift));
+            }
+        }
+    }
+}
+
+bool Maze::RowSpanOpen(int y, int x0, int x1) const {
+    if (x0 > x1) {
+        int t = x0; x0 = x1; x1 = t;
+    }
+    if (y < 0 || y >= height || x0 < 0 || x1 >= width) {
+        return false;
+    }
+
+    // 64 cells at a time
+    for (int x = x0; x <= x1; x += 64) {
+        int count = (x1 - x + 1 < 64) ? x1 - x + 1 : 64;
+        if (RowBits(y, x, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Maze::ColumnSpanOpen(int x, int y0, int y1) const {
+    if (y0 > y1) {
+        int t = y0; y0 = y1; y1 = t;
+    }
+    if (x < 0 || x >= width || y0 < 0 || y1 >= height) {
+        return false;
+    }
+
+    // Consecutive cells of a column are width bits apart
+    size_t bit = (size_t)y0 * width + x;
+    for (int y = y0; y <= y1; y++, bit += width) {
+        if ((bits[bit >> 6] >> (bit & 63)) & 1) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,114 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Edge mask bits (set when the cell across that edge is a wall)
+enum MazeNeighbor {
+    NEIGHBOR_N = 1 << 0,
+    NEIGHBOR_E = 1 << 1,
+    NEIGHBOR_S = 1 << 2,
+    NEIGHBOR_W = 1 << 3,
+
+    NEIGHBOR_EDGES = NEIGHBOR_N | NEIGHBOR_E | NEIGHBOR_S | NEIGHBOR_W
+};
+
+// Index of the lowest set bit (word must be non-zero)
+inline int LowestSetBit(uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// Bit-packed maze: one bit per cell, row-major with rows packed back to
+// back, so cell (x, y) is bit y * width + x. A 25x19 arena is 475 bits, 8
+// words: one 64-byte cache line (101x77 is 122 words). One spare zero word
+// at the end lets any run of up to 64 cells be read with two word loads.
+// Alongside the bits, a 4-bit edge mask per cell (two cells per byte, 238
+// bytes at 25x19) is computed once by BuildNeighborMasks() after the layout
+// is final. Cells outside the maze always count as walls.
+class Maze {
+public:
+    Maze(int width = 0, int height = 0) { Resize(width, height); }
+
+    // Resize and clear to all-open
+    void Resize(int width, int height);
+
+    // Set every cell to wall or open
+    void Fill(bool wall);
+
+    int Width() const { return width; }
+    int Height() const { return height; }
+
+    bool IsWall(int x, int y) const {
+        if ((unsigned)x >= (unsigned)width || (unsigned)y >= (unsigned)height) {
+            return true;
+        }
+        size_t bit = (size_t)y * width + x;
+        return (bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    void SetWall(int x, int y, bool wall) {
+        size_t bit = (size_t)y * width + x;
+        uint64_t& word = bits[bit >> 6];
+        uint64_t mask = (uint64_t)1 << (bit & 63);
+        word = wall ? (word | mask) : (word & ~mask);
+    }
+
+    // Wall bits of count (1..64) cells of row y starting at x, all inside
+    // the maze: bit i is cell (x + i, y)
+    uint64_t RowBits(int y, int x, int count) const {
+        size_t bit = (size_t)y * width + x;
+        size_t word = bit >> 6;
+        int shift = (int)(bit & 63);
+        uint64_t run = bits[word] >> shift;
+        if (shift != 0) {
+            run |= bits[word + 1] << (64 - shift);
+        }
+        return count >= 64 ? run : run & (((uint64_t)1 << count) - 1);
+    }
+
+    // Raw storage for callers that know the dimensions at compile time:
+    // Words() words of wall bits, cell (x, y) at bit y * Width() + x
+    const uint64_t* Bits() const { return bits.data(); }
+    int Words() const { return (int)bits.size(); }
+
+    // Wall mask of the 4 cells sharing an edge with (x, y); see MazeNeighbor
+    uint8_t Neighbors(int x, int y) const {
+        size_t cell = (size_t)y * width + x;
+        return (uint8_t)((edges[cell >> 1] >> ((cell & 1) * 4)) & 0xF);
+    }
+
+    // Are all 8 cells around (x, y) open?
+    bool SurroundingsOpen(int x, int y) const {
+        if (x < 1 || y < 1 || x >= width - 1 || y >= height - 1) {
+            return false;
+        }
+        return (RowBits(y - 1, x - 1, 3) | (RowBits(y, x - 1, 3) & 5) | RowBits(y + 1, x - 1, 3)) == 0;
+    }
+
+    // Recompute every cell's edge mask; call after editing walls
+    void BuildNeighborMasks();
+
+    // Are all cells from x0 to x1 (inclusive) in row y open?
+    bool RowSpanOpen(int y, int x0, int x1) const;
+
+    // Are all cells from y0 to y1 (inclusive) in column x open?
+    bool ColumnSpanOpen(int x, int y0, int y1) const;
+
+private:
+    int width, height;
+    std::vector<uint64_t> bits;       // Packed wall bits plus one spare word
+    std::vector<uint8_t> edges;       // Per-cell edge masks, two per byte
+};
+
+#endif // MAZE_H
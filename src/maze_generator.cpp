@@ -0,0 +1,203 @@
+#include "maze_generator.h"
+#include <vector>
+
+// Chance that a dead end is opened up by the braided generator
+static const float BRAID_CHANCE = 0.75f;
+
+// Room-grid directions: N, E, S, W
+static const int kDirX[4] = { 0, 1, 0, -1 };
+static const int kDirY[4] = { -1, 0, 1, 0 };
+
+void GeneratePerfectMaze(Maze& maze, Rng& rng) {
+    maze.Fill(true);
+
+    // Rooms sit on odd coordinates inside the border
+    int roomsX = (maze.Width() - 1) / 2;
+    int roomsY = (maze.Height() - 1) / 2;
+    if (roomsX <= 0 || roomsY <= 0) {
+        return;
+    }
+
+    std::vector<uint32_t> stack;
+    stack.reserve(64);
+
+    int startX = (int)rng.NextBelow(roomsX);
+    int startY = (int)rng.NextBelow(roomsY);
+    maze.SetWall(startX * 2 + 1, startY * 2 + 1, false);
+    stack.push_back((uint32_t)(startY * roomsX + startX));
+
+    while (!stack.empty()) {
+        int roomX = (int)(stack.back() % roomsX);
+        int roomY = (int)(stack.back() / roomsX);
+
+        // Collect unvisited neighbor rooms (a room is visited once it is open)
+        int candidates[4];
+        int candidateCount = 0;
+        for (int d = 0; d < 4; d++) {
+            int nx = roomX + kDirX[d];
+            int ny = roomY + kDirY[d];
+            if (nx >= 0 && nx < roomsX && ny >= 0 && ny < roomsY &&
+                maze.IsWall(nx * 2 + 1, ny * 2 + 1)) {
+                candidates[candidateCount++] = d;
+            }
+        }
+
+        if (candidateCount == 0) {
+            stack.pop_back();
+            continue;
+        }
+
+        // Knock out the wall between the rooms and move on
+        int d = candidates[rng.NextBelow(candidateCount)];
+        int nx = roomX + kDirX[d];
+        int ny = roomY + kDirY[d];
+        maze.SetWall(roomX * 2 + 1 + kDirX[d], roomY * 2 + 1 + kDirY[d], false);
+        maze.SetWall(nx * 2 + 1, ny * 2 + 1, false);
+        stack.push_back((uint32_t)(ny * roomsX + nx));
+    }
+}
+
+// Number of open passages out of a room
+static int CountPassages(const Maze& maze, int cellX, int cellY) {
+    int passages = 0;
+    for (int d = 0; d < 4; d++) {
+        if (!maze.IsWall(cellX + kDirX[d], cellY + kDirY[d])) {
+            passages++;
+        }
+    }
+    return passages;
+}
+
+void GenerateBraidedMaze(Maze& maze, Rng& rng) {
+    GeneratePerfectMaze(maze, rng);
+
+    int roomsX = (maze.Width() - 1) / 2;
+    int roomsY = (maze.Height() - 1) / 2;
+    for (int roomY = 0; roomY < roomsY; roomY++) {
+        for (int roomX = 0; roomX < roomsX; roomX++) {
+            int cellX = roomX * 2 + 1;
+            int cellY = roomY * 2 + 1;
+            if (CountPassages(maze, cellX, cellY) != 1 || rng.NextFloat() >= BRAID_CHANCE) {
+                continue;
+            }
+
+            // Open a closed side, preferring one that also fixes a neighboring dead end
+            int candidates[4];
+            int candidateCount = 0;
+            int preferred[4];
+            int preferredCount = 0;
+            for (int d = 0; d < 4; d++) {
+                int nx = roomX + kDirX[d];
+                int ny = roomY + kDirY[d];
+                if (nx < 0 || nx >= roomsX || ny < 0 || ny >= roomsY ||
+                    !maze.IsWall(cellX + kDirX[d], cellY + kDirY[d])) {
+                    continue;
+                }
+                candidates[candidateCount++] = d;
+                if (CountPassages(maze, nx * 2 + 1, ny * 2 + 1) == 1) {
+                    preferred[preferredCount++] = d;
+                }
+            }
+
+            int d;
+            if (preferredCount > 0) {
+                d = preferred[rng.NextBelow(preferredCount)];
+            } else if (candidateCount > 0) {
+                d = candidates[rng.NextBelow(candidateCount)];
+            } else {
+                continue;
+            }
+            maze.SetWall(cellX + kDirX[d], cellY + kDirY[d], false);
+        }
+    }
+}
+
+// Label every open cell with its 4-connected component; returns the count
+static int LabelComponents(const Maze& maze, std::vector<int>& labels, std::vector<int>& firstCell) {
+    int width = maze.Width();
+    int height = maze.Height();
+    labels.assign((size_t)width * height, -1);
+    firstCell.clear();
+
+    std::vector<int> queue;
+    int componentCount = 0;
+    for (int start = 0; start < width * height; start++) {
+        if (labels[start] >= 0 || maze.IsWall(start % width, start / width)) {
+            continue;
+        }
+
+        int label = componentCount++;
+        firstCell.push_back(start);
+        labels[start] = label;
+        queue.clear();
+        queue.push_back(start);
+        for (size_t head = 0; head < queue.size(); head++) {
+            int x = queue[head] % width;
+            int y = queue[head] / width;
+            for (int d = 0; d < 4; d++) {
+                int nx = x + kDirX[d];
+                int ny = y + kDirY[d];
+                int index = ny * width + nx;
+                if (!maze.IsWall(nx, ny) && labels[index] < 0) {
+                    labels[index] = label;
+                    queue.push_back(index);
+                }
+            }
+        }
+    }
+    return componentCount;
+}
+
+void GenerateScatterMaze(Maze& maze, Rng& rng) {
+    int width = maze.Width();
+    int height = maze.Height();
+    if (width < 3 || height < 3) {
+        maze.Fill(true);
+        return;
+    }
+
+    // Solid border with 30% random internal walls
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            bool border = (x == 0 || y == 0 || x == width - 1 || y == height - 1);
+            maze.SetWall(x, y, border || rng.NextBelow(100) < 30);
+        }
+    }
+
+    std::vector<int> labels;
+    std::vector<int> firstCell;
+    int componentCount = LabelComponents(maze, labels, firstCell);
+    if (componentCount == 0) {
+        maze.SetWall(width / 2, height / 2, false);
+        return;
+    }
+
+    // Carve an L-shaped corridor from each pocket to the first region; the
+    // corridor stays inside the border because both ends are interior cells
+    int targetX = firstCell[0] % width;
+    int targetY = firstCell[0] / width;
+    for (int c = 1; c < componentCount; c++) {
+        int x = firstCell[c] % width;
+        int y = firstCell[c] / width;
+        while (x != targetX) {
+            x += (targetX > x) ? 1 : -1;
+            maze.SetWall(x, y, false);
+        }
+        while (y != targetY) {
+            y += (targetY > y) ? 1 : -1;
+            maze.SetWall(x, y, false);
+        }
+    }
+}
+
+void GenerateMaze(Maze& maze, uint64_t seed, MazeGenerator generator) {
+    Rng rng(seed);
+    generator(maze, rng);
+    maze.BuildNeighborMasks();
+}
+
+bool IsMazeConnected(const Maze& maze) {
+    std::vector<int> labels;
+    std::vector<int> firstCell;
+    return LabelComponents(maze, labels, firstCell) <= 1;
+}
@@ -0,0 +1,38 @@
+#ifndef MAZE_GENERATOR_H
+#define MAZE_GENERATOR_H
+
+#include <cstdint>
+#include "maze.h"
+#include "rng.h"
+
+// Maze generators.
+// A generator fills an already-sized Maze from an Rng. Every generator here
+// produces a single connected open region enclosed by a solid border, so any
+// open cell is reachable from any other, which is what spawn placement relies
+// on. Generators are plain functions, so new ones can be plugged in without
+// touching GameState.
+//
+// The perfect and braided generators lay rooms on odd coordinates with walls
+// between them; passages are carved by knocking out the wall cell between two
+// rooms.
+typedef void (*MazeGenerator)(Maze& maze, Rng& rng);
+
+// Perfect maze (exactly one path between any two rooms) by iterative
+// recursive backtracking
+void GeneratePerfectMaze(Maze& maze, Rng& rng);
+
+// Perfect maze with most dead ends opened into loops, which plays better for
+// tank fights since there is always another way around
+void GenerateBraidedMaze(Maze& maze, Rng& rng);
+
+// Scattered single-cell walls (the original look) with any pockets cut off
+// by the scatter reconnected to the main region
+void GenerateScatterMaze(Maze& maze, Rng& rng);
+
+// Generate with the given algorithm and seed, then rebuild neighbor masks
+void GenerateMaze(Maze& maze, uint64_t seed, MazeGenerator generator);
+
+// Are all open cells connected to each other? (4-neighborhood flood fill)
+bool IsMazeConnected(const Maze& maze);
+
+#endif // MAZE_GENERATOR_H
@@ -0,0 +1,201 @@
+#include "navigation.h"
+#include <cmath>
+
+// FlowField methods
+FlowField::FlowField()
+    : width(0), height(0), front(0), queueHead(0), targetX(-1), targetY(-1), pendingX(-1), pendingY(-1),
+      building(false), pending(false), ready(false) {
+    buffers[0].generation = 0;
+    buffers[1].generation = 0;
+}
+
+void FlowField::Reset(const Maze& maze) {
+    width = maze.Width();
+    height = maze.Height();
+    size_t cells = (size_t)width * height;
+    for (Buffer& buffer : buffers) {
+        buffer.stamp.assign(cells, 0);
+        buffer.distance.assign(cells, NAV_UNREACHABLE);
+        buffer.direction.assign(cells, 0);
+        buffer.generation = 0;
+    }
+    queue.clear();
+    queue.reserve(cells);
+    queueHead = 0;
+    front = 0;
+    targetX = -1;
+    targetY = -1;
+    building = false;
+    pending = false;
+    ready = false;
+}
+
+void FlowField::SetTarget(int cellX, int cellY) {
+    if (building) {
+        // Let the running rebuild finish, then start over from the latest target
+        pending = (cellX != targetX || cellY != targetY);
+        pendingX = cellX;
+        pendingY = cellY;
+        return;
+    }
+    if (ready && cellX == targetX && cellY == targetY) {
+        return;
+    }
+    StartBuild(cellX, cellY);
+}
+
+void FlowField::StartBuild(int cellX, int cellY) {
+    targetX = cellX;
+    targetY = cellY;
+
+    // Start over in the back buffer; queries keep using the front one
+    Buffer& back = buffers[1 - front];
+    if (++back.generation == 0) {
+        back.stamp.assign(back.stamp.size(), 0);
+        back.generation = 1;
+    }
+    queue.clear();
+    queueHead = 0;
+    building = true;
+
+    // The target itself may be inside a wall (tanks drive over walls); the
+    // search still spreads from it into the open cells around it
+    if ((unsigned)cellX < (unsigned)width && (unsigned)cellY < (unsigned)height) {
+        int index = cellY * width + cellX;
+        back.stamp[index] = back.generation;
+        back.distance[index] = 0;
+        back.direction[index] = 0;
+        queue.push_back(index);
+    }
+}
+
+int FlowField::Step(const Maze& maze, int budget) {
+    if (!building) {
+        return 0;
+    }
+
+    Buffer& back = buffers[1 - front];
+    const uint32_t generation = back.generation;
+
+    // Neighbor wall bits, index offsets and the button that leads from the
+    // neighbor back here. The maze's neighbor masks count cells outside the
+    // maze as walls, so no bounds checks are needed.
+    static const uint8_t wallBit[4] = { NEIGHBOR_N, NEIGHBOR_S, NEIGHBOR_W, NEIGHBOR_E };
+    static const uint8_t towardHere[4] = { INPUT_DOWN, INPUT_UP, INPUT_RIGHT, INPUT_LEFT };
+    const int offset[4] = { -width, width, -1, 1 };
+
+    int expanded = 0;
+    while (queueHead < queue.size() && expanded < budget) {
+        int index = queue[queueHead++];
+        uint8_t walls = maze.Neighbors(index % width, index / width);
+        uint32_t next = back.distance[index] + 1;
+
+        for (int d = 0; d < 4; d++) {
+            if (walls & wallBit[d]) {
+                continue;
+            }
+            int neighbor = index + offset[d];
+            if (back.stamp[neighbor] == generation) {
+                continue;
+            }
+            back.stamp[neighbor] = generation;
+            back.distance[neighbor] = next;
+            back.direction[neighbor] = towardHere[d];
+            queue.push_back(neighbor);
+        }
+        expanded++;
+    }
+
+    if (queueHead >= queue.size()) {
+        front = 1 - front;
+        building = false;
+        ready = true;
+        if (pending) {
+            pending = false;
+            StartBuild(pendingX, pendingY);
+        }
+    }
+    return expanded;
+}
+
+void FlowField::Build(const Maze& maze) {
+    while (building) {
+        Step(maze, 1 << 30);
+    }
+}
+
+uint8_t FlowField::DirectionAt(int cellX, int cellY) const {
+    if (!ready || (unsigned)cellX >= (unsigned)width || (unsigned)cellY >= (unsigned)height) {
+        return 0;
+    }
+    const Buffer& buffer = buffers[front];
+    int index = cellY * width + cellX;
+    return (buffer.stamp[index] == buffer.generation) ? buffer.direction[index] : 0;
+}
+
+uint32_t FlowField::DistanceAt(int cellX, int cellY) const {
+    if (!ready || (unsigned)cellX >= (unsigned)width || (unsigned)cellY >= (unsigned)height) {
+        return NAV_UNREACHABLE;
+    }
+    const Buffer& buffer = buffers[front];
+    int index = cellY * width + cellX;
+    return (buffer.stamp[index] == buffer.generation) ? buffer.distance[index] : NAV_UNREACHABLE;
+}
+
+// NavigationService methods
+NavigationService::NavigationService(int cellBudgetPerTick)
+    : maze(nullptr), cellBudget(cellBudgetPerTick < 1 ? 1 : cellBudgetPerTick), nextField(0) {}
+
+void NavigationService::Rebuild(const Maze& newMaze) {
+    maze = &newMaze;
+    keys.clear();
+    fields.clear();
+    nextField = 0;
+}
+
+int NavigationService::FieldFor(int targetKey) {
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == targetKey) {
+            return (int)i;
+        }
+    }
+    keys.push_back(targetKey);
+    fields.push_back(FlowField());
+    if (maze) {
+        fields.back().Reset(*maze);
+    }
+    return (int)fields.size() - 1;
+}
+
+void NavigationService::MoveTarget(int field, float x, float y) {
+    fields[field].SetTarget((int)floorf(x / WALL_SIZE), (int)floorf(y / WALL_SIZE));
+}
+
+void NavigationService::TrackTanks(const GameState& state) {
+    for (size_t i = 0; i < fields.size(); i++) {
+        int player = keys[i];
+        if (player >= 0 && player < state.playerCount && state.tanks[player].alive) {
+            const Tank& tank = state.tanks[player];
+            MoveTarget((int)i, tank.x + TANK_WIDTH / 2.0f, tank.y + TANK_HEIGHT / 2.0f);
+        }
+    }
+}
+
+void NavigationService::Update() {
+    if (!maze || fields.empty()) {
+        return;
+    }
+
+    // Share the budget round-robin, starting one field later each tick
+    int budget = cellBudget;
+    int count = (int)fields.size();
+    for (int n = 0; n < count && budget > 0; n++) {
+        FlowField& field = fields[(nextField + n) % count];
+        budget -= field.Step(*maze, budget);
+    }
+    nextField = (nextField + 1) % count;
+}
+
+uint8_t NavigationService::Steer(int field, float x, float y) const {
+    return fields[field].DirectionAt((int)floorf(x / WALL_SIZE), (int)floorf(y / WALL_SIZE));
+}
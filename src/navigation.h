@@ -0,0 +1,113 @@
+#ifndef NAVIGATION_H
+#define NAVIGATION_H
+
+#include <cstdint>
+#include <vector>
+#include "game.h"
+#include "maze.h"
+
+const uint32_t NAV_UNREACHABLE = 0xFFFFFFFFu;
+
+// Breadth-first distance field toward one target cell.
+// Every open cell stores its distance to the target and the InputButton
+// direction of its next step, so a steering query is a single lookup. The
+// field is double-buffered: moving the target starts a rebuild in the back
+// buffer that Step() advances a bounded number of cells at a time, while
+// queries keep reading the last finished field until the rebuild completes
+// and the buffers swap. Per-tick cost is therefore capped however large the
+// maze is. A target that moves again mid-rebuild is queued and picked up as
+// soon as the running rebuild lands, so a fast target on a huge maze still
+// gets a steady stream of slightly stale fields rather than none. Cells are
+// visited through generation stamps, so a rebuild never clears the arrays.
+class FlowField {
+public:
+    FlowField();
+
+    // Size to the maze and forget any field
+    void Reset(const Maze& maze);
+
+    // Aim at a cell; starts (or queues) a rebuild if the target changed
+    void SetTarget(int cellX, int cellY);
+
+    // Expand up to budget cells of the pending rebuild; returns cells expanded
+    int Step(const Maze& maze, int budget);
+
+    // Finish any pending rebuild now
+    void Build(const Maze& maze);
+
+    // Is a rebuild in progress?
+    bool Building() const { return building; }
+
+    // Has a field been completed at least once?
+    bool Ready() const { return ready; }
+
+    // InputButton direction toward the target (0 at the target, unreachable or not ready)
+    uint8_t DirectionAt(int cellX, int cellY) const;
+
+    // Steps from the cell to the target, or NAV_UNREACHABLE
+    uint32_t DistanceAt(int cellX, int cellY) const;
+
+    int TargetX() const { return targetX; }
+    int TargetY() const { return targetY; }
+
+private:
+    void StartBuild(int cellX, int cellY);
+
+    struct Buffer {
+        std::vector<uint32_t> stamp;       // Generation that last reached the cell
+        std::vector<uint32_t> distance;
+        std::vector<uint8_t> direction;
+        uint32_t generation;
+    };
+
+    int width, height;
+    Buffer buffers[2];
+    int front;                    // Buffer answering queries
+    std::vector<int> queue;       // BFS frontier of the back buffer
+    size_t queueHead;
+    int targetX, targetY;         // Target of the rebuild, or of the front buffer
+    int pendingX, pendingY;       // Target to rebuild for next
+    bool building;
+    bool pending;
+    bool ready;
+};
+
+// Shared flow fields for bots.
+// Bots chasing the same target share one field keyed by the target (for
+// example a player index), so the cost of tracking a target is paid once
+// however many bots chase it. Update() spends a fixed cell budget per tick
+// across all fields that are rebuilding.
+class NavigationService {
+public:
+    explicit NavigationService(int cellBudgetPerTick = 8192);
+
+    // Adopt a new maze (call after GameState::Initialize); drops every field
+    void Rebuild(const Maze& maze);
+
+    // Index of the field for a target key, created on first use
+    int FieldFor(int targetKey);
+
+    // Move a field's target to the cell containing the world point
+    void MoveTarget(int field, float x, float y);
+
+    // Point every field keyed by a player index at that player's tank
+    void TrackTanks(const GameState& state);
+
+    // Advance pending rebuilds within the per-tick budget
+    void Update();
+
+    // Movement buttons steering a tank centered at (x, y) along a field
+    uint8_t Steer(int field, float x, float y) const;
+
+    const FlowField& Field(int field) const { return fields[field]; }
+    int FieldCount() const { return (int)fields.size(); }
+
+private:
+    const Maze* maze;
+    int cellBudget;
+    int nextField;                  // Round-robin start so no field starves
+    std::vector<int> keys;          // Target key of each field
+    std::vector<FlowField> fields;
+};
+
+#endif // NAVIGATION_H
@@ -0,0 +1,227 @@
+#include "net_poller.h"
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cstdint>
+#elif defined(_WIN32)
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+#if defined(__linux__)
+
+static uint32_t ToEpoll(int flags) {
+    uint32_t events = 0;
+    if (flags & NET_POLL_READ) {
+        events |= EPOLLIN;
+    }
+    if (flags & NET_POLL_WRITE) {
+        events |= EPOLLOUT;
+    }
+    return events;
+}
+
+NetPoller::NetPoller() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd >= 0 && wakeFd >= 0) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+}
+
+NetPoller::~NetPoller() {
+    if (wakeFd >= 0) {
+        close(wakeFd);
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+bool NetPoller::Valid() const {
+    return epollFd >= 0 && wakeFd >= 0;
+}
+
+bool NetPoller::Add(NetSocket socket, int flags, void* user) {
+    epoll_event event = {};
+    event.events = ToEpoll(flags);
+    event.data.fd = socket;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) != 0) {
+        return false;
+    }
+    if ((size_t)socket >= users.size()) {
+        users.resize(socket + 1, nullptr);
+    }
+    users[socket] = user;
+    return true;
+}
+
+bool NetPoller::Modify(NetSocket socket, int flags, void* user) {
+    epoll_event event = {};
+    event.events = ToEpoll(flags);
+    event.data.fd = socket;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, socket, &event) != 0) {
+        return false;
+    }
+    users[socket] = user;
+    return true;
+}
+
+void NetPoller::Remove(NetSocket socket) {
+    epoll_event event = {};
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, &event);
+    if ((size_t)socket < users.size()) {
+        users[socket] = nullptr;
+    }
+}
+
+int NetPoller::Wait(NetPollEvent* events, int maxEvents, int timeoutMs) {
+    const int BATCH = 256;
+    epoll_event ready[BATCH];
+    int count = epoll_wait(epollFd, ready, maxEvents < BATCH ? maxEvents : BATCH, timeoutMs);
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        int fd = ready[i].data.fd;
+        if (fd == wakeFd) {
+            uint64_t value;
+            ssize_t drained = read(wakeFd, &value, sizeof(value));
+            (void)drained;
+            continue;
+        }
+        int flags = 0;
+        if (ready[i].events & EPOLLIN) {
+            flags |= NET_POLL_READ;
+        }
+        if (ready[i].events & EPOLLOUT) {
+            flags |= NET_POLL_WRITE;
+        }
+        if (ready[i].events & (EPOLLERR | EPOLLHUP)) {
+            flags |= NET_POLL_CLOSED;
+        }
+        events[found].socket = fd;
+        events[found].user = users[fd];
+        events[found].flags = flags;
+        found++;
+    }
+    return found;
+}
+
+void NetPoller::Wake() {
+    uint64_t one = 1;
+    ssize_t written = write(wakeFd, &one, sizeof(one));
+    (void)written;      // A full counter is already a pending wakeup
+}
+
+#else
+
+#if defined(_WIN32)
+typedef WSAPOLLFD PollEntry;
+static int PollSockets(PollEntry* entries, size_t count, int timeoutMs) {
+    return WSAPoll(entries, (ULONG)count, timeoutMs);
+}
+#else
+typedef pollfd PollEntry;
+static int PollSockets(PollEntry* entries, size_t count, int timeoutMs) {
+    return poll(entries, (nfds_t)count, timeoutMs);
+}
+#endif
+
+NetPoller::NetPoller() {
+    wakeSocket = OpenUdpSocket(0);
+    wakeAddress = NetAddress::Loopback(LocalPort(wakeSocket));
+}
+
+NetPoller::~NetPoller() {
+    CloseSocket(wakeSocket);
+}
+
+bool NetPoller::Valid() const {
+    return wakeSocket != NET_INVALID_SOCKET;
+}
+
+bool NetPoller::Add(NetSocket socket, int flags, void* user) {
+    for (const Watch& watch : watches) {
+        if (watch.socket == socket) {
+            return false;
+        }
+    }
+    watches.push_back(Watch{ socket, flags, user });
+    return true;
+}
+
+bool NetPoller::Modify(NetSocket socket, int flags, void* user) {
+    for (Watch& watch : watches) {
+        if (watch.socket == socket) {
+            watch.flags = flags;
+            watch.user = user;
+            return true;
+        }
+    }
+    return false;
+}
+
+void NetPoller::Remove(NetSocket socket) {
+    for (size_t i = 0; i < watches.size(); i++) {
+        if (watches[i].socket == socket) {
+            watches.erase(watches.begin() + i);
+            return;
+        }
+    }
+}
+
+int NetPoller::Wait(NetPollEvent* events, int maxEvents, int timeoutMs) {
+    // The wakeup socket goes first, then every watch in order
+    std::vector<PollEntry> entries(watches.size() + 1);
+    entries[0].fd = wakeSocket;
+    entries[0].events = POLLIN;
+    for (size_t i = 0; i < watches.size(); i++) {
+        entries[i + 1].fd = watches[i].socket;
+        entries[i + 1].events = (short)(((watches[i].flags & NET_POLL_READ) ? POLLIN : 0) |
+                                        ((watches[i].flags & NET_POLL_WRITE) ? POLLOUT : 0));
+    }
+    if (PollSockets(entries.data(), entries.size(), timeoutMs) <= 0) {
+        return 0;
+    }
+
+    if (entries[0].revents != 0) {
+        char drain[16];
+        NetAddress from;
+        while (ReceiveDatagram(wakeSocket, from, drain, sizeof(drain)) >= 0) {
+        }
+    }
+    int found = 0;
+    for (size_t i = 1; i < entries.size() && found < maxEvents; i++) {
+        short revents = entries[i].revents;
+        if (revents == 0) {
+            continue;
+        }
+        int flags = 0;
+        if (revents & POLLIN) {
+            flags |= NET_POLL_READ;
+        }
+        if (revents & POLLOUT) {
+            flags |= NET_POLL_WRITE;
+        }
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            flags |= NET_POLL_CLOSED;
+        }
+        events[found].socket = watches[i - 1].socket;
+        events[found].user = watches[i - 1].user;
+        events[found].flags = flags;
+        found++;
+    }
+    return found;
+}
+
+void NetPoller::Wake() {
+    char one = 1;
+    SendDatagram(wakeSocket, wakeAddress, &one, 1);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef NET_POLLER_H
+#define NET_POLLER_H
+
+#include <vector>
+#include "net_socket.h"
+
+// Readiness flags for NetPoller
+enum NetPollFlags {
+    NET_POLL_READ = 1,
+    NET_POLL_WRITE = 2,
+    NET_POLL_CLOSED = 4      // Error or hangup; reading reports the details
+};
+
+// One ready socket from NetPoller::Wait
+struct NetPollEvent {
+    NetSocket socket;
+    void* user;             // Value given to Add()
+    int flags;              // NetPollFlags that are ready
+};
+
+// Waits until any of a set of sockets is ready, for an I/O thread.
+// The backend is epoll on Linux, WSAPoll on Windows and poll() elsewhere.
+// Add, Modify, Remove and Wait belong to the thread that runs the poller;
+// Wake() is the one call other threads may make, and it ends the current
+// (or next) Wait early without any socket being ready.
+class NetPoller {
+public:
+    NetPoller();
+    ~NetPoller();
+
+    NetPoller(const NetPoller&) = delete;
+    NetPoller& operator=(const NetPoller&) = delete;
+
+    // False if the backend or the wakeup channel could not be created
+    bool Valid() const;
+
+    // Watch a socket for the NetPollFlags in flags
+    bool Add(NetSocket socket, int flags, void* user);
+    bool Modify(NetSocket socket, int flags, void* user);
+    void Remove(NetSocket socket);
+
+    // Wait up to timeoutMs (-1 waits forever) and fill in the ready
+    // sockets; returns how many, 0 on timeout or wakeup
+    int Wait(NetPollEvent* events, int maxEvents, int timeoutMs);
+
+    // Interrupt Wait from any thread; never blocks
+    void Wake();
+
+private:
+#if defined(__linux__)
+    int epollFd;
+    int wakeFd;             // eventfd
+    std::vector<void*> users;   // User value of each watched socket, by fd
+#else
+    struct Watch {
+        NetSocket socket;
+        int flags;
+        void* user;
+    };
+    std::vector<Watch> watches;
+    NetSocket wakeSocket;   // Loopback UDP socket that Wake() sends to
+    NetAddress wakeAddress;
+#endif
+};
+
+#endif // NET_POLLER_H
@@ -0,0 +1,210 @@
+#include "net_socket.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static sockaddr_in ToSockaddr(const NetAddress& address) {
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(address.ip);
+    addr.sin_port = htons(address.port);
+    return addr;
+}
+
+static bool SetNonBlocking(NetSocket socket) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Did the last call fail only because it would have blocked?
+static bool WouldBlock() {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    // A send on a connection still being set up fails with WSAENOTCONN
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS || error == WSAENOTCONN;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+static void SetNoDelay(NetSocket socket) {
+    int enable = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&enable, sizeof(enable));
+}
+
+bool ParseNetAddress(const char* text, uint16_t port, NetAddress& address) {
+    unsigned int a, b, c, d;
+    char tail;
+    if (sscanf(text, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+        return false;
+    }
+    address = NetAddress((a << 24) | (b << 16) | (c << 8) | d, port);
+    return true;
+}
+
+bool NetStartup() {
+#ifdef _WIN32
+    WSADATA wsaData;
+    return WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#else
+    return true;
+#endif
+}
+
+void NetCleanup() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+NetSocket OpenUdpSocket(uint16_t port) {
+    NetSocket sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    sockaddr_in addr = ToSockaddr(NetAddress(0, port));   // INADDR_ANY
+    if (bind(sock, (const sockaddr*)&addr, sizeof(addr)) != 0 || !SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        return NET_INVALID_SOCKET;
+    }
+
+#ifdef _WIN32
+    // Stop an ICMP port-unreachable from a vanished peer failing later reads
+    BOOL reportReset = FALSE;
+    DWORD returned = 0;
+    WSAIoctl(sock, _WSAIOW(IOC_VENDOR, 12), &reportReset, sizeof(reportReset), NULL, 0, &returned, NULL, NULL);
+#endif
+    return sock;
+}
+
+uint16_t LocalPort(NetSocket socket) {
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    if (getsockname(socket, (sockaddr*)&addr, &length) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+bool SendDatagram(NetSocket socket, const NetAddress& to, const void* data, int size) {
+    sockaddr_in addr = ToSockaddr(to);
+    int sent = (int)sendto(socket, (const char*)data, size, 0, (const sockaddr*)&addr, sizeof(addr));
+    return sent == size;
+}
+
+int ReceiveDatagram(NetSocket socket, NetAddress& from, void* buffer, int capacity) {
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    int received = (int)recvfrom(socket, (char*)buffer, capacity, 0, (sockaddr*)&addr, &length);
+    if (received < 0) {
+        return -1;
+    }
+    from = NetAddress(ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port));
+    return received;
+}
+
+NetSocket OpenTcpListener(uint16_t port, int backlog) {
+    NetSocket sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+
+    // Restarting a server must not wait for old connections to time out
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    sockaddr_in addr = ToSockaddr(NetAddress(0, port));
+    if (bind(sock, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(sock, backlog) != 0 ||
+        !SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+NetSocket AcceptStream(NetSocket listener, NetAddress& from) {
+    sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    NetSocket sock = accept(listener, (sockaddr*)&addr, &length);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+    if (!SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        return NET_INVALID_SOCKET;
+    }
+    SetNoDelay(sock);
+    from = NetAddress(ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port));
+    return sock;
+}
+
+NetSocket ConnectStream(const NetAddress& to) {
+    NetSocket sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == NET_INVALID_SOCKET) {
+        return NET_INVALID_SOCKET;
+    }
+    if (!SetNonBlocking(sock)) {
+        CloseSocket(sock);
+        return NET_INVALID_SOCKET;
+    }
+    SetNoDelay(sock);
+
+    sockaddr_in addr = ToSockaddr(to);
+    if (connect(sock, (const sockaddr*)&addr, sizeof(addr)) != 0 && !WouldBlock()) {
+        CloseSocket(sock);
+        return NET_INVALID_SOCKET;
+    }
+    return sock;
+}
+
+int SendStream(NetSocket socket, const void* data, int size) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;     // A closed peer is an error, not SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    int sent = (int)send(socket, (const char*)data, size, flags);
+    if (sent < 0) {
+        return WouldBlock() ? 0 : -1;
+    }
+    return sent;
+}
+
+int ReceiveStream(NetSocket socket, void* buffer, int capacity) {
+    int received = (int)recv(socket, (char*)buffer, capacity, 0);
+    if (received == 0) {
+        return -1;
+    }
+    if (received < 0) {
+        return WouldBlock() ? 0 : -1;
+    }
+    return received;
+}
+
+void CloseSocket(NetSocket socket) {
+    if (socket == NET_INVALID_SOCKET) {
+        return;
+    }
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
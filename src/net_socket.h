@@ -0,0 +1,75 @@
+#ifndef NET_SOCKET_H
+#define NET_SOCKET_H
+
+#include <cstdint>
+
+// Thin portable layer over BSD sockets and Winsock, so the transport, the
+// headless tools and the Win32 client share one code path. Every socket it
+// opens is non-blocking.
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET NetSocket;
+const NetSocket NET_INVALID_SOCKET = INVALID_SOCKET;
+#else
+typedef int NetSocket;
+const NetSocket NET_INVALID_SOCKET = -1;
+#endif
+
+// IPv4 endpoint in host byte order
+struct NetAddress {
+    uint32_t ip;
+    uint16_t port;
+
+    NetAddress() : ip(0), port(0) {}
+    NetAddress(uint32_t ipAddress, uint16_t portNumber) : ip(ipAddress), port(portNumber) {}
+
+    bool operator==(const NetAddress& other) const { return ip == other.ip && port == other.port; }
+    bool operator!=(const NetAddress& other) const { return !(*this == other); }
+
+    // 127.0.0.1 on the given port
+    static NetAddress Loopback(uint16_t port) { return NetAddress(0x7F000001u, port); }
+};
+
+// Parse a dotted IPv4 address; false if it is malformed
+bool ParseNetAddress(const char* text, uint16_t port, NetAddress& address);
+
+// Process-wide socket setup and teardown (Winsock needs them; no-ops elsewhere)
+bool NetStartup();
+void NetCleanup();
+
+// UDP socket bound to the port on all interfaces (0 picks a free port), or
+// NET_INVALID_SOCKET
+NetSocket OpenUdpSocket(uint16_t port);
+
+// Port a socket is bound to, or 0
+uint16_t LocalPort(NetSocket socket);
+
+// Send one datagram; false if it was not sent whole
+bool SendDatagram(NetSocket socket, const NetAddress& to, const void* data, int size);
+
+// Receive one datagram into buffer: its size, or -1 if none is waiting
+// (or the socket failed)
+int ReceiveDatagram(NetSocket socket, NetAddress& from, void* buffer, int capacity);
+
+// TCP socket listening on the port on all interfaces, or NET_INVALID_SOCKET
+NetSocket OpenTcpListener(uint16_t port, int backlog);
+
+// Accept one waiting connection (with Nagle disabled), or NET_INVALID_SOCKET
+// if none is waiting
+NetSocket AcceptStream(NetSocket listener, NetAddress& from);
+
+// Start connecting to the address; the connection may still be in progress
+// when this returns, and sends before it completes just report no progress
+NetSocket ConnectStream(const NetAddress& to);
+
+// Send what the socket will take: bytes sent, 0 if it would block, or -1 if
+// the connection failed
+int SendStream(NetSocket socket, const void* data, int size);
+
+// Receive what is waiting: bytes received, 0 if nothing is waiting, or -1 if
+// the peer closed the connection or it failed
+int ReceiveStream(NetSocket socket, void* buffer, int capacity);
+
+void CloseSocket(NetSocket socket);
+
+#endif // NET_SOCKET_H
@@ -0,0 +1,256 @@
+#include "net_thread.h"
+#include <chrono>
+#include <cstring>
+
+static double NetworkTime() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// NetworkThread methods
+NetworkThread::NetworkThread()
+    : socket(NET_INVALID_SOCKET), hasPeer(false), peerLeft(false), lastSendTime(0), running(false),
+      stopping(false), commands(new SpscQueue<NetCommand, NET_QUEUE_SIZE>()),
+      events(new SpscQueue<NetEvent, NET_QUEUE_SIZE>()), datagramsSent(0), datagramsReceived(0),
+      commandsDropped(0), eventsDropped(0), roundTripUs(0) {
+}
+
+NetworkThread::~NetworkThread() {
+    Stop();
+}
+
+bool NetworkThread::StartHost(uint16_t port) {
+    return Start(OpenUdpSocket(port), true, NetAddress());
+}
+
+bool NetworkThread::StartClient(const NetAddress& host) {
+    return Start(OpenUdpSocket(0), false, host);
+}
+
+bool NetworkThread::Start(NetSocket udpSocket, bool hosting, const NetAddress& peerAddress) {
+    Stop();
+    if (udpSocket == NET_INVALID_SOCKET) {
+        return false;
+    }
+    if (!poller.Valid() || !poller.Add(udpSocket, NET_POLL_READ, nullptr)) {
+        CloseSocket(udpSocket);
+        return false;
+    }
+
+    // Commands are only queued while a thread runs and it drains them
+    // before exiting, so only stale events can be left over
+    while (events->Front() != nullptr) {
+        events->Pop();
+    }
+    unsentInputs.clear();
+    socket = udpSocket;
+    peer = peerAddress;
+    hasPeer = !hosting;
+    peerLeft = false;
+    connection.Reset(NetworkTime());
+    lastSendTime = 0;
+    datagramsSent.store(0);
+    datagramsReceived.store(0);
+    commandsDropped.store(0);
+    eventsDropped.store(0);
+    roundTripUs.store(0);
+    stopping.store(false);
+    running = true;
+    thread = std::thread(&NetworkThread::ThreadMain, this);
+    return true;
+}
+
+void NetworkThread::Stop() {
+    if (!running) {
+        return;
+    }
+    QueueUnsentInputs();
+    stopping.store(true);
+    poller.Wake();
+    thread.join();
+
+    poller.Remove(socket);
+    CloseSocket(socket);
+    socket = NET_INVALID_SOCKET;
+    running = false;
+}
+
+bool NetworkThread::QueueCommand(NetCommandType type, uint32_t tick, uint8_t buttons, const uint8_t* data,
+                                 size_t size) {
+    // Without a thread nothing would ever consume the command
+    NetCommand* command = running && size <= (size_t)NET_MESSAGE_MAX ? commands->Back() : nullptr;
+    if (command == nullptr) {
+        commandsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    command->type = (uint8_t)type;
+    command->tick = tick;
+    command->buttons = buttons;
+    command->size = (uint16_t)size;
+    if (size > 0) {
+        memcpy(command->data, data, size);
+    }
+    commands->Push();
+    return true;
+}
+
+bool NetworkThread::SendInput(uint32_t tick, uint8_t buttons) {
+    if (!running || unsentInputs.size() >= (size_t)UDP_INPUT_WINDOW) {
+        commandsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    InputPacket input;
+    input.tick = tick;
+    input.buttons = buttons;
+    unsentInputs.push_back(input);
+    QueueUnsentInputs();
+    return true;
+}
+
+void NetworkThread::QueueUnsentInputs() {
+    while (!unsentInputs.empty()) {
+        NetCommand* command = commands->Back();
+        if (command == nullptr) {
+            return;
+        }
+        command->type = NET_SEND_INPUT;
+        command->tick = unsentInputs.front().tick;
+        command->buttons = unsentInputs.front().buttons;
+        command->size = 0;
+        commands->Push();
+        unsentInputs.pop_front();
+    }
+}
+
+bool NetworkThread::SendLatest(const uint8_t* data, size_t size) {
+    return QueueCommand(NET_SEND_LATEST, 0, 0, data, size);
+}
+
+bool NetworkThread::SendReliable(const uint8_t* data, size_t size) {
+    return QueueCommand(NET_SEND_RELIABLE, 0, 0, data, size);
+}
+
+void NetworkThread::Flush() {
+    if (running) {
+        QueueUnsentInputs();
+        poller.Wake();
+    }
+}
+
+bool NetworkThread::QueueEvent(NetEventType type, uint32_t tick, uint8_t buttons, const uint8_t* data,
+                               size_t size) {
+    NetEvent* event = size <= (size_t)NET_MESSAGE_MAX ? events->Back() : nullptr;
+    if (event == nullptr) {
+        eventsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    event->type = (uint8_t)type;
+    event->tick = tick;
+    event->buttons = buttons;
+    event->size = (uint16_t)size;
+    if (size > 0) {
+        memcpy(event->data, data, size);
+    }
+    events->Push();
+    return true;
+}
+
+void NetworkThread::ThreadMain() {
+    NetPollEvent ready[4];
+    while (!stopping.load()) {
+        // Sleep until a datagram, a flush, or the next keepalive
+        double wait = lastSendTime + NET_KEEPALIVE_INTERVAL - NetworkTime();
+        int timeoutMs = hasPeer ? (wait > 0 ? (int)(wait * 1000.0) + 1 : 0) : 100;
+        poller.Wait(ready, 4, timeoutMs);
+
+        double now = NetworkTime();
+        ReadDatagrams(now);
+        bool queued = ApplyCommands();
+        if (hasPeer && (queued || now - lastSendTime >= NET_KEEPALIVE_INTERVAL)) {
+            SendNext(now);
+        }
+
+        if (hasPeer && !peerLeft && connection.SilentFor(now) > NET_PEER_TIMEOUT) {
+            peerLeft = QueueEvent(NET_PEER_LEFT, 0, 0, nullptr, 0);
+        }
+    }
+
+    // Whatever was queued last (typically a goodbye) gets a few datagrams,
+    // since nobody will be around to resend it
+    if (ApplyCommands() && hasPeer) {
+        for (int i = 0; i < 3; i++) {
+            SendNext(NetworkTime());
+        }
+    }
+}
+
+bool NetworkThread::ApplyCommands() {
+    bool any = false;
+    while (NetCommand* command = commands->Front()) {
+        switch (command->type) {
+            case NET_SEND_INPUT:
+                // The peer could never get every tick, so treat it as gone
+                if (!connection.QueueInput(command->tick, command->buttons) && !peerLeft) {
+                    peerLeft = QueueEvent(NET_PEER_LEFT, 0, 0, nullptr, 0);
+                }
+                break;
+            case NET_SEND_LATEST:
+                connection.SendLatest(command->data, command->size);
+                break;
+            case NET_SEND_RELIABLE:
+                if (!connection.SendReliable(command->data, command->size)) {
+                    commandsDropped.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+        }
+        commands->Pop();
+        any = true;
+    }
+    return any;
+}
+
+void NetworkThread::ReadDatagrams(double now) {
+    uint8_t buffer[UDP_MAX_DATAGRAM];
+    NetAddress from;
+    int size;
+    while ((size = ReceiveDatagram(socket, from, buffer, sizeof(buffer))) >= 0) {
+        if (hasPeer && from != peer) {
+            continue;
+        }
+        if (!connection.ReadDatagram(buffer, size, now)) {
+            continue;
+        }
+        // A host takes the first valid datagram's sender as its peer
+        if (!hasPeer) {
+            peer = from;
+            hasPeer = true;
+            QueueEvent(NET_PEER_JOINED, 0, 0, nullptr, 0);
+        }
+        datagramsReceived.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Inputs and reliable messages wait in the connection while the event
+    // queue is full; only a latest message may be dropped
+    uint32_t tick;
+    uint8_t buttons;
+    while (events->Back() != nullptr && connection.PopInput(tick, buttons)) {
+        QueueEvent(NET_INPUT, tick, buttons, nullptr, 0);
+    }
+    std::vector<uint8_t> message;
+    if (connection.TakeLatest(message)) {
+        QueueEvent(NET_LATEST, 0, 0, message.data(), message.size());
+    }
+    while (events->Back() != nullptr && connection.PopReliable(message)) {
+        QueueEvent(NET_RELIABLE, 0, 0, message.data(), message.size());
+    }
+    roundTripUs.store((uint32_t)(connection.RoundTripTime() * 1e6), std::memory_order_relaxed);
+}
+
+void NetworkThread::SendNext(double now) {
+    BitWriter writer(UDP_MAX_DATAGRAM);
+    connection.WriteDatagram(writer, now);
+    if (SendDatagram(socket, peer, writer.Data(), (int)writer.Size())) {
+        datagramsSent.fetch_add(1, std::memory_order_relaxed);
+    }
+    lastSendTime = now;
+}
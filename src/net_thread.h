@@ -0,0 +1,142 @@
+#ifndef NET_THREAD_H
+#define NET_THREAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include "net_poller.h"
+#include "net_socket.h"
+#include "packets.h"
+#include "spsc_queue.h"
+#include "udp_transport.h"
+
+const int NET_QUEUE_SIZE = 256;              // Commands or events in flight each way
+const int NET_MESSAGE_MAX = WIRE_MAX_PACKET_BYTES;
+const double NET_KEEPALIVE_INTERVAL = 0.05;  // Seconds between datagrams when idle
+const double NET_PEER_TIMEOUT = 5.0;         // Seconds of silence before the peer is gone
+
+// Simulation -> I/O thread
+enum NetCommandType {
+    NET_SEND_INPUT,         // tick and buttons
+    NET_SEND_LATEST,        // data: unreliable latest-wins message
+    NET_SEND_RELIABLE       // data: reliable ordered message
+};
+
+struct NetCommand {
+    uint8_t type;
+    uint8_t buttons;
+    uint16_t size;
+    uint32_t tick;
+    uint8_t data[NET_MESSAGE_MAX];
+};
+
+// I/O thread -> simulation
+enum NetEventType {
+    NET_PEER_JOINED,        // Host only: the first datagram from a peer arrived
+    NET_PEER_LEFT,          // Peer went silent for NET_PEER_TIMEOUT
+    NET_INPUT,              // tick and buttons, in tick order
+    NET_LATEST,             // data: newest unreliable message
+    NET_RELIABLE            // data: next reliable message in order
+};
+
+struct NetEvent {
+    uint8_t type;
+    uint8_t buttons;
+    uint16_t size;
+    uint32_t tick;
+    uint8_t data[NET_MESSAGE_MAX];
+};
+
+// Runs one UDP peer connection (see udp_transport.h) on its own thread.
+// The thread owns the socket and the UdpConnection and sleeps in a
+// NetPoller until a datagram arrives, the simulation flushes, or a
+// keepalive is due. The simulation only talks to it through two bounded
+// lock-free SPSC queues, so ticking never waits on a socket. A full command
+// queue drops a latest or reliable message and counts it instead of
+// blocking, but inputs wait on the simulation side and go out in tick order
+// once there is room, since the peer needs every tick; while the event
+// queue is full, received inputs and reliable messages stay in the
+// connection until there is room. One thread may call the simulation side
+// of the API; Start and Stop also belong to it.
+class NetworkThread {
+public:
+    NetworkThread();
+    ~NetworkThread();
+
+    // Open a UDP socket and start the thread. A host waits for the first
+    // datagram to pick its peer; a client starts sending to the host at once.
+    bool StartHost(uint16_t port);
+    bool StartClient(const NetAddress& host);
+
+    // Send what is queued, then close the socket and join the thread
+    void Stop();
+
+    bool Running() const { return running; }
+
+    // Port the socket is bound to, or 0 when not running
+    uint16_t Port() const { return running ? LocalPort(socket) : 0; }
+
+    // Queue outgoing traffic; false if the queue is full or the message is
+    // too large. Nothing is sent until Flush(). An input that finds the queue
+    // full waits, as do all later ones, and is retried on the next SendInput
+    // or Flush; SendInput is false only without a thread or once
+    // UDP_INPUT_WINDOW inputs are waiting, and the match is then over.
+    bool SendInput(uint32_t tick, uint8_t buttons);
+    bool SendLatest(const uint8_t* data, size_t size);
+    bool SendReliable(const uint8_t* data, size_t size);
+
+    // Have the I/O thread put everything queued into a datagram now
+    void Flush();
+
+    // Oldest event from the I/O thread, or null; stays valid until
+    // PopEvent()
+    const NetEvent* PeekEvent() { return events->Front(); }
+    void PopEvent() { events->Pop(); }
+
+    // Counters since the last Start, readable from any thread
+    uint64_t DatagramsSent() const { return datagramsSent.load(std::memory_order_relaxed); }
+    uint64_t DatagramsReceived() const { return datagramsReceived.load(std::memory_order_relaxed); }
+    uint64_t CommandsDropped() const { return commandsDropped.load(std::memory_order_relaxed); }
+    size_t InputsWaiting() const { return unsentInputs.size(); }   // Simulation side only
+    uint64_t EventsDropped() const { return eventsDropped.load(std::memory_order_relaxed); }
+    double RoundTripTime() const { return roundTripUs.load(std::memory_order_relaxed) / 1e6; }
+
+private:
+    bool Start(NetSocket socket, bool hosting, const NetAddress& peer);
+    bool QueueCommand(NetCommandType type, uint32_t tick, uint8_t buttons, const uint8_t* data, size_t size);
+    void QueueUnsentInputs();
+    bool QueueEvent(NetEventType type, uint32_t tick, uint8_t buttons, const uint8_t* data, size_t size);
+
+    // I/O thread
+    void ThreadMain();
+    bool ApplyCommands();
+    void ReadDatagrams(double now);
+    void SendNext(double now);
+
+    // Set before the thread starts, then owned by it
+    NetSocket socket;
+    NetAddress peer;
+    bool hasPeer;
+    bool peerLeft;
+    UdpConnection connection;
+    double lastSendTime;
+    NetPoller poller;
+    std::thread thread;
+    bool running;                       // Simulation side
+    std::deque<InputPacket> unsentInputs;  // Simulation side: waiting for room in the command queue
+    std::atomic<bool> stopping;
+
+    std::unique_ptr<SpscQueue<NetCommand, NET_QUEUE_SIZE>> commands;
+    std::unique_ptr<SpscQueue<NetEvent, NET_QUEUE_SIZE>> events;
+
+    std::atomic<uint64_t> datagramsSent;
+    std::atomic<uint64_t> datagramsReceived;
+    std::atomic<uint64_t> commandsDropped;
+    std::atomic<uint64_t> eventsDropped;
+    std::atomic<uint32_t> roundTripUs;
+};
+
+#endif // NET_THREAD_H
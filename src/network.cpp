@@ -1,178 +1,115 @@
 #include "network.h"
 #include "main.h"
-#include <iostream>
-#include <cstring>
+#include "framing.h"
+#include "net_thread.h"
+#include <deque>
 
 // External references to global variables in main.cpp
-extern SOCKET g_listenSocket;
-extern SOCKET g_clientSocket;
+extern bool g_peerConnected;
 extern int g_port;
 extern bool g_isHost;
 extern GameState g_gameState;
-extern bool g_isHost;
-extern GameState g_gameState;
 
-bool InitializeNetwork() {
-    WSADATA wsaData;
-    int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-    if (result != 0) {
-        return false;
+static NetworkThread g_networkThread;    // Owns the socket and the connection
+static bool g_peerJoined = false;        // Host: a peer appeared, not yet reported by AcceptPeer
+static bool g_peerLeft = false;          // Disconnect received or peer timed out
+static bool g_startReceived = false;     // Start packet waiting for ReceiveStartPacket
+static uint32_t g_startSeed = 0;
+
+// Events taken off the network thread's queue, waiting for their Receive call
+static std::deque<InputPacket> g_inputs;
+
+// Encode a packet and queue it on the reliable channel
+template <typename Packet>
+static bool SendReliablePacket(const Packet& packet) {
+    BitWriter writer(UDP_RELIABLE_MAX_SIZE);
+    WritePacket(writer, packet);
+    return g_networkThread.SendReliable(writer.Data(), writer.Size());
+}
+
+static void OnStartPacket(void*, const uint8_t* data, size_t size) {
+    BitReader reader(data, size);
+    StartPacket packet;
+    if (ReadPacket(reader, packet)) {
+        g_startSeed = packet.seed;
+        g_startReceived = true;
     }
-    return true;
+}
+
+static void OnDisconnectPacket(void*, const uint8_t*, size_t) {
+    g_peerLeft = true;
+}
+
+static PacketDispatcher MakeReliableDispatcher() {
+    PacketDispatcher dispatcher;
+    dispatcher.Register(PACKET_START, OnStartPacket);
+    dispatcher.Register(PACKET_DISCONNECT, OnDisconnectPacket);
+    return dispatcher;
+}
+
+static const PacketDispatcher g_reliableDispatcher = MakeReliableDispatcher();
+
+bool InitializeNetwork() {
+    return NetStartup();
 }
 
 void CleanupNetwork() {
-    if (g_listenSocket != INVALID_SOCKET) {
-        closesocket(g_listenSocket);
-        g_listenSocket = INVALID_SOCKET;
-    }
-    
-    if (g_clientSocket != INVALID_SOCKET) {
-        closesocket(g_clientSocket);
-        g_clientSocket = INVALID_SOCKET;
-    }
-    
-    WSACleanup();
+    Disconnect();
+    NetCleanup();
 }
 
 bool StartHosting() {
-    // Close any existing sockets
-    if (g_listenSocket != INVALID_SOCKET) {
-        closesocket(g_listenSocket);
-        g_listenSocket = INVALID_SOCKET;
-    }
-    
-    if (g_clientSocket != INVALID_SOCKET) {
-        closesocket(g_clientSocket);
-        g_clientSocket = INVALID_SOCKET;
-    }
-    
-    g_listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (g_listenSocket == INVALID_SOCKET) {
-        return false;
-    }
-    
-    // Set socket options for reuse address
-    int opt = 1;
-    setsockopt(g_listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&opt, sizeof(opt));
-    
-    sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(g_port);
-    
-    if (bind(g_listenSocket, (SOCKADDR*)&serverAddr, sizeof(serverAddr)) == SOCKET_ERROR) {
-        closesocket(g_listenSocket);
-        g_listenSocket = INVALID_SOCKET;
-        return false;
-    }
-    
-    if (listen(g_listenSocket, 1) == SOCKET_ERROR) {
-        closesocket(g_listenSocket);
-        g_listenSocket = INVALID_SOCKET;
-        return false;
-    }
-    
-    // Set the socket to non-blocking mode for better UI responsiveness
-    u_long mode = 1;
-    ioctlsocket(g_listenSocket, FIONBIO, &mode);
-    
-    return true;
+    // Close any existing socket
+    Disconnect();
+
+    return g_networkThread.StartHost((uint16_t)g_port);
 }
 
 bool ConnectToHost(const char* ip) {
-    // Close any existing sockets
-    if (g_clientSocket != INVALID_SOCKET) {
-        closesocket(g_clientSocket);
-        g_clientSocket = INVALID_SOCKET;
-    }
-    
-    g_clientSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (g_clientSocket == INVALID_SOCKET) {
+    // Close any existing socket
+    Disconnect();
+
+    NetAddress host;
+    if (!ParseNetAddress(ip, (uint16_t)g_port, host)) {
         return false;
     }
-    
-    sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = inet_addr(ip);
-    serverAddr.sin_port = htons(g_port);
-    
-    // Set the socket to non-blocking mode for timeout handling
-    u_long mode = 1;
-    ioctlsocket(g_clientSocket, FIONBIO, &mode);
-    
-    int result = connect(g_clientSocket, (SOCKADDR*)&serverAddr, sizeof(serverAddr));
-    
-    // Handle non-blocking connect
-    if (result == SOCKET_ERROR) {
-        int error = WSAGetLastError();
-        if (error != WSAEWOULDBLOCK) {
-            closesocket(g_clientSocket);
-            g_clientSocket = INVALID_SOCKET;
-            return false;
-        }
-        
-        // Wait for connection with timeout
-        fd_set writeSet, errorSet;
-        FD_ZERO(&writeSet);
-        FD_ZERO(&errorSet);
-        FD_SET(g_clientSocket, &writeSet);
-        FD_SET(g_clientSocket, &errorSet);
-        
-        timeval timeout;
-        timeout.tv_sec = 5;  // 5 second timeout
-        timeout.tv_usec = 0;
-        
-        result = select(0, NULL, &writeSet, &errorSet, &timeout);
-        if (result <= 0 || FD_ISSET(g_clientSocket, &errorSet)) {
-            closesocket(g_clientSocket);
-            g_clientSocket = INVALID_SOCKET;
-            return false;
-        }
+    // There is no handshake to wait for: the network thread starts sending
+    // at once, the host learns our address from the first datagram that
+    // arrives, and it answers with the start packet
+    if (!g_networkThread.StartClient(host)) {
+        return false;
     }
-    
-    // Set socket back to blocking mode
-    mode = 0;
-    ioctlsocket(g_clientSocket, FIONBIO, &mode);
-    
+    g_peerConnected = true;
+
     g_isHost = false;
     return true;
 }
 
-void Disconnect() {
-    if (g_clientSocket != INVALID_SOCKET) {
-        closesocket(g_clientSocket);
-        g_clientSocket = INVALID_SOCKET;
-    }
-    
-    if (g_listenSocket != INVALID_SOCKET) {
-        closesocket(g_listenSocket);
-        g_listenSocket = INVALID_SOCKET;
+bool AcceptPeer() {
+    PumpNetwork();
+    if (!g_peerJoined) {
+        return false;
     }
+    g_peerJoined = false;
+    return true;
 }
 
-bool SendPacket(SOCKET socket, const void* data, int size) {
-    int sent = send(socket, (const char*)data, size, 0);
-    return sent == size;
-}
-
-bool ReceivePacket(SOCKET socket, void* data, int size) {
-    int received = recv(socket, (char*)data, size, 0);
-    // Check for disconnection
-    if (received == 0) {
-        // Connection closed by peer
-        return false;
-    }
-    if (received == SOCKET_ERROR) {
-        int error = WSAGetLastError();
-        if (error != WSAEWOULDBLOCK) {
-            // Actual error occurred
-            return false;
+void Disconnect() {
+    if (g_networkThread.Running()) {
+        // The network thread sends whatever is queued a few more times
+        // before it exits
+        if (g_peerConnected && !g_peerLeft) {
+            DisconnectPacket packet;
+            SendReliablePacket(packet);
         }
-        // Would block, no data available yet
-        return false;
+        g_networkThread.Stop();
     }
-    return received == size;
+
+    g_peerConnected = false;
+    g_peerJoined = false;
+    g_peerLeft = false;
+    g_startReceived = false;
+    g_inputs.clear();
 }
 
 void HandleDisconnection() {
@@ -181,63 +118,94 @@ void HandleDisconnection() {
     // and return to the menu state
 }
 
-bool SendInputPacket(SOCKET socket, const bool* keys) {
-    InputPacket packet;
-    for (int i = 0; i < 256; i++) {
-        packet.keys[i] = keys[i];
+void PumpNetwork() {
+    while (const NetEvent* event = g_networkThread.PeekEvent()) {
+        switch (event->type) {
+            case NET_PEER_JOINED:
+                g_peerConnected = true;
+                g_peerJoined = true;
+                break;
+            case NET_PEER_LEFT:
+                g_peerLeft = true;
+                break;
+            case NET_INPUT: {
+                InputPacket input;
+                input.tick = event->tick;
+                input.buttons = event->buttons;
+                g_inputs.push_back(input);
+                break;
+            }
+            case NET_LATEST:
+                // A peer match sends no unreliable state
+                break;
+            case NET_RELIABLE:
+                g_reliableDispatcher.Dispatch(nullptr, event->data, event->size);
+                break;
+        }
+        g_networkThread.PopEvent();
     }
-    return SendPacket(socket, &packet, sizeof(packet));
 }
 
-bool SendGameStatePacket(SOCKET socket, const GameState& gameState) {
-    GameStatePacket packet;
-    
-    // Copy tank data
-    for (int i = 0; i < 2; i++) {
-        packet.tanks[i] = gameState.tanks[i];
+void FlushNetwork() {
+    g_networkThread.Flush();
+}
+
+bool PeerDisconnected() {
+    return g_peerLeft;
+}
+
+bool SendInputPacket(uint32_t tick, uint8_t buttons) {
+    if (!g_peerConnected || g_peerLeft) {
+        return false;
     }
-    
-    // Copy bullet data
-    packet.bulletCount = (int)gameState.bullets.size();
-    for (int i = 0; i < packet.bulletCount && i < 50; i++) {
-        packet.bullets[i] = gameState.bullets[i];
+    // A full queue only delays this tick: the thread keeps it and later
+    // ones in order until there is room
+    if (!g_networkThread.SendInput(tick, buttons)) {
+        return false;
     }
-    
-    return SendPacket(socket, &packet, sizeof(packet));
+    FlushNetwork();
+    return true;
 }
 
-bool SendBulletPacket(SOCKET socket, const Bullet& bullet) {
+bool SendStartPacket(uint32_t seed) {
+    StartPacket packet;
+    packet.seed = seed;
+    if (!g_peerConnected || !SendReliablePacket(packet)) {
+        return false;
+    }
+    FlushNetwork();
+    return true;
+}
+
+bool SendBulletPacket(const Bullet& bullet) {
     BulletPacket packet;
     packet.bullet = bullet;
-    return SendPacket(socket, &packet, sizeof(packet));
+    if (!g_peerConnected || !SendReliablePacket(packet)) {
+        return false;
+    }
+    FlushNetwork();
+    return true;
 }
 
-bool ReceiveInputPacket(SOCKET socket, bool* keys) {
-    InputPacket packet;
-    if (ReceivePacket(socket, &packet, sizeof(packet))) {
-        for (int i = 0; i < 256; i++) {
-            keys[i] = packet.keys[i];
+bool ReceiveInputPacket(uint32_t& tick, uint8_t& buttons) {
+    if (g_inputs.empty()) {
+        PumpNetwork();
+        if (g_inputs.empty()) {
+            return false;
         }
-        return true;
     }
-    return false;
+    tick = g_inputs.front().tick;
+    buttons = g_inputs.front().buttons;
+    g_inputs.pop_front();
+    return true;
 }
 
-bool ReceiveGameStatePacket(SOCKET socket, GameState& gameState) {
-    GameStatePacket packet;
-    if (ReceivePacket(socket, &packet, sizeof(packet))) {
-        // Copy tank data
-        for (int i = 0; i < 2; i++) {
-            gameState.tanks[i] = packet.tanks[i];
-        }
-        
-        // Copy bullet data
-        gameState.bullets.clear();
-        for (int i = 0; i < packet.bulletCount && i < 50; i++) {
-            gameState.bullets.push_back(packet.bullets[i]);
-        }
-        
-        return true;
+bool ReceiveStartPacket(uint32_t& seed) {
+    PumpNetwork();
+    if (!g_startReceived) {
+        return false;
     }
-    return false;
-}
\ No newline at end of file
+    seed = g_startSeed;
+    g_startReceived = false;
+    return true;
+}
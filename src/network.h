@@ -3,65 +3,33 @@
 
 #include <winsock2.h>
 #include "game.h"
-
-// Network packet types
-enum PacketType {
-    PACKET_INPUT = 1,
-    PACKET_GAME_STATE,
-    PACKET_BULLET,
-    PACKET_DISCONNECT
-};
-
-// Input packet structure
-struct InputPacket {
-    PacketType type;
-    bool keys[256];
-    
-    InputPacket() : type(PACKET_INPUT) {
-        for (int i = 0; i < 256; i++) {
-            keys[i] = false;
-        }
-    }
-};
-
-// Game state packet structure
-struct GameStatePacket {
-    PacketType type;
-    Tank tanks[2];
-    int bulletCount;
-    Bullet bullets[50]; // Maximum 50 bullets
-    
-    GameStatePacket() : type(PACKET_GAME_STATE), bulletCount(0) {}
-};
-
-// Bullet creation packet structure
-struct BulletPacket {
-    PacketType type;
-    Bullet bullet;
-    
-    BulletPacket() : type(PACKET_BULLET) {}
-};
-
-// Disconnect packet structure
-struct DisconnectPacket {
-    PacketType type;
-    
-    DisconnectPacket() : type(PACKET_DISCONNECT) {}
-};
+#include "net_socket.h"
+#include "packets.h"
+
+// Peer-to-peer match traffic over one UDP socket (see udp_transport.h):
+// inputs ride in every datagram until acked, and match start and disconnect
+// go over the reliable ordered channel. Both peers simulate the match from
+// the exchanged inputs (see rollback.h), so no game state is sent; delta
+// snapshots are for dedicated server clients (see game_server.h). The
+// socket lives on a NetworkThread (see net_thread.h); these functions only
+// move messages through its queues, so none of them make a socket call or
+// block the game loop.
 
 // Function prototypes
 bool InitializeNetwork();
 void CleanupNetwork();
 bool StartHosting();
 bool ConnectToHost(const char* ip);
+bool AcceptPeer();
 void Disconnect();
 void HandleDisconnection();
-bool SendPacket(SOCKET socket, const void* data, int size);
-bool ReceivePacket(SOCKET socket, void* data, int size);
-bool SendInputPacket(SOCKET socket, const bool* keys);
-bool SendGameStatePacket(SOCKET socket, const GameState& gameState);
-bool SendBulletPacket(SOCKET socket, const Bullet& bullet);
-bool ReceiveInputPacket(SOCKET socket, bool* keys);
-bool ReceiveGameStatePacket(SOCKET socket, GameState& gameState);
-
-#endif // NETWORK_H
\ No newline at end of file
+void PumpNetwork();         // Take in every event the network thread has queued
+void FlushNetwork();        // Have the network thread send everything queued now
+bool PeerDisconnected();    // The peer said goodbye or went silent
+bool SendInputPacket(uint32_t tick, uint8_t buttons);
+bool SendStartPacket(uint32_t seed);
+bool SendBulletPacket(const Bullet& bullet);
+bool ReceiveInputPacket(uint32_t& tick, uint8_t& buttons);
+bool ReceiveStartPacket(uint32_t& seed);
+
+#endif // NETWORK_H
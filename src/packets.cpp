@@ -0,0 +1,322 @@
+#include "packets.h"
+#include "camera.h"
+#include <cmath>
+
+void BuildGameStatePacket(const GameState& gameState, GameStatePacket& packet) {
+    packet.tanks.assign(gameState.tanks, gameState.tanks + gameState.playerCount);
+    packet.bullets.assign(gameState.bullets.begin(), gameState.bullets.end());
+}
+
+void BuildGameStatePacket(const GameState& gameState, const Camera& view, GameStatePacket& packet) {
+    packet.tanks.assign(gameState.tanks, gameState.tanks + gameState.playerCount);
+    
+    // A bullet just outside the view can enter it before the next packet
+    packet.bullets.clear();
+    for (const Bullet& bullet : gameState.bullets) {
+        if (view.Sees(bullet.x, bullet.y, bullet.x + BULLET_WIDTH, bullet.y + BULLET_HEIGHT, 2 * BULLET_SPEED)) {
+            packet.bullets.push_back(bullet);
+        }
+    }
+}
+
+void ApplyGameStatePacket(const GameStatePacket& packet, GameState& gameState) {
+    // The sender's player count is authoritative
+    int count = (int)packet.tanks.size() < MAX_PLAYERS ? (int)packet.tanks.size() : MAX_PLAYERS;
+    gameState.playerCount = count;
+    for (int i = 0; i < count; i++) {
+        gameState.tanks[i] = packet.tanks[i];
+    }
+    
+    gameState.bullets.Assign(packet.bullets.data(), (int)packet.bullets.size());
+}
+
+// Quantization
+static const float TWO_PI = 6.28318530718f;
+
+// Width of one bullet written in full
+static const int WIRE_BULLET_BITS = 2 * WIRE_POSITION_BITS + 2 * WIRE_VELOCITY_BITS + WIRE_LIFETIME_BITS +
+                                    WIRE_PLAYER_BITS + WIRE_BOUNCE_BITS;
+
+static uint16_t QuantizePosition(float value) {
+    return (uint16_t)Quantize(value, 0.0f, WIRE_POSITION_MAX, WIRE_POSITION_BITS);
+}
+
+static float DequantizePosition(uint16_t value) {
+    return Dequantize(value, 0.0f, WIRE_POSITION_MAX, WIRE_POSITION_BITS);
+}
+
+static uint16_t QuantizeVelocity(float value) {
+    return (uint16_t)Quantize(value, -WIRE_VELOCITY_MAX, WIRE_VELOCITY_MAX, WIRE_VELOCITY_BITS);
+}
+
+static float DequantizeVelocity(uint16_t value) {
+    return Dequantize(value, -WIRE_VELOCITY_MAX, WIRE_VELOCITY_MAX, WIRE_VELOCITY_BITS);
+}
+
+// Small non-negative counter clamped into bits
+static uint8_t QuantizeSmall(int value, int bits) {
+    int max = (1 << bits) - 1;
+    return (uint8_t)(value < 0 ? 0 : (value > max ? max : value));
+}
+
+static void QuantizeTank(const Tank& tank, WireTank& wire) {
+    wire.x = QuantizePosition(tank.x);
+    wire.y = QuantizePosition(tank.y);
+    wire.velocityX = QuantizeVelocity(tank.velocityX);
+    wire.velocityY = QuantizeVelocity(tank.velocityY);
+
+    // Rotation accumulates freely; only its direction matters
+    float rotation = fmodf(tank.rotation, TWO_PI);
+    if (rotation < 0) {
+        rotation += TWO_PI;
+    }
+    uint32_t step = (uint32_t)(rotation / TWO_PI * (1 << WIRE_ROTATION_BITS) + 0.5f);
+    wire.rotation = (uint16_t)(step & ((1u << WIRE_ROTATION_BITS) - 1));
+
+    wire.alive = tank.alive ? 1 : 0;
+    wire.cooldown = QuantizeSmall(tank.cooldown, WIRE_COOLDOWN_BITS);
+    wire.player = QuantizeSmall(tank.playerID - 1, WIRE_PLAYER_BITS);
+}
+
+static void DequantizeTank(const WireTank& wire, Tank& tank) {
+    tank.x = DequantizePosition(wire.x);
+    tank.y = DequantizePosition(wire.y);
+    tank.velocityX = DequantizeVelocity(wire.velocityX);
+    tank.velocityY = DequantizeVelocity(wire.velocityY);
+    tank.rotation = wire.rotation * (TWO_PI / (1 << WIRE_ROTATION_BITS));
+    tank.alive = wire.alive != 0;
+    tank.cooldown = wire.cooldown;
+    tank.playerID = wire.player + 1;
+
+    // The last tick moved the tank by its velocity before friction
+    tank.prevX = tank.x - tank.velocityX / 0.9f;
+    tank.prevY = tank.y - tank.velocityY / 0.9f;
+}
+
+static void QuantizeBullet(const Bullet& bullet, WireBullet& wire) {
+    wire.x = QuantizePosition(bullet.x);
+    wire.y = QuantizePosition(bullet.y);
+    wire.velocityX = QuantizeVelocity(bullet.velocityX);
+    wire.velocityY = QuantizeVelocity(bullet.velocityY);
+    wire.lifetime = QuantizeSmall(bullet.lifetime, WIRE_LIFETIME_BITS);
+    wire.owner = QuantizeSmall(bullet.ownerID - 1, WIRE_PLAYER_BITS);
+    wire.bounces = QuantizeSmall(bullet.bounceCount, WIRE_BOUNCE_BITS);
+}
+
+static void DequantizeBullet(const WireBullet& wire, Bullet& bullet) {
+    bullet.x = DequantizePosition(wire.x);
+    bullet.y = DequantizePosition(wire.y);
+    bullet.velocityX = DequantizeVelocity(wire.velocityX);
+    bullet.velocityY = DequantizeVelocity(wire.velocityY);
+    bullet.lifetime = wire.lifetime;
+    bullet.ownerID = wire.owner + 1;
+    bullet.bounceCount = wire.bounces;
+    bullet.active = true;
+    bullet.prevX = bullet.x - bullet.velocityX;
+    bullet.prevY = bullet.y - bullet.velocityY;
+}
+
+void QuantizeGameState(const GameStatePacket& packet, WireGameState& wire) {
+    wire.tanks.resize(packet.tanks.size());
+    for (size_t i = 0; i < packet.tanks.size(); i++) {
+        QuantizeTank(packet.tanks[i], wire.tanks[i]);
+    }
+    wire.bullets.resize(packet.bullets.size());
+    for (size_t i = 0; i < packet.bullets.size(); i++) {
+        QuantizeBullet(packet.bullets[i], wire.bullets[i]);
+    }
+}
+
+void DequantizeGameState(const WireGameState& wire, GameStatePacket& packet) {
+    packet.tanks.resize(wire.tanks.size());
+    for (size_t i = 0; i < wire.tanks.size(); i++) {
+        DequantizeTank(wire.tanks[i], packet.tanks[i]);
+    }
+    packet.bullets.resize(wire.bullets.size());
+    for (size_t i = 0; i < wire.bullets.size(); i++) {
+        DequantizeBullet(wire.bullets[i], packet.bullets[i]);
+    }
+}
+
+// Entity encoding
+void WriteWireTank(BitWriter& writer, const WireTank& tank) {
+    writer.WriteBits(tank.x, WIRE_POSITION_BITS);
+    writer.WriteBits(tank.y, WIRE_POSITION_BITS);
+    writer.WriteBits(tank.velocityX, WIRE_VELOCITY_BITS);
+    writer.WriteBits(tank.velocityY, WIRE_VELOCITY_BITS);
+    writer.WriteBits(tank.rotation, WIRE_ROTATION_BITS);
+    writer.WriteBits(tank.alive, 1);
+    writer.WriteBits(tank.cooldown, WIRE_COOLDOWN_BITS);
+    writer.WriteBits(tank.player, WIRE_PLAYER_BITS);
+}
+
+void ReadWireTank(BitReader& reader, WireTank& tank) {
+    tank.x = (uint16_t)reader.ReadBits(WIRE_POSITION_BITS);
+    tank.y = (uint16_t)reader.ReadBits(WIRE_POSITION_BITS);
+    tank.velocityX = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    tank.velocityY = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    tank.rotation = (uint16_t)reader.ReadBits(WIRE_ROTATION_BITS);
+    tank.alive = (uint8_t)reader.ReadBits(1);
+    tank.cooldown = (uint8_t)reader.ReadBits(WIRE_COOLDOWN_BITS);
+    tank.player = (uint8_t)reader.ReadBits(WIRE_PLAYER_BITS);
+}
+
+void WriteWireBullet(BitWriter& writer, const WireBullet& bullet) {
+    writer.WriteBits(bullet.x, WIRE_POSITION_BITS);
+    writer.WriteBits(bullet.y, WIRE_POSITION_BITS);
+    writer.WriteBits(bullet.velocityX, WIRE_VELOCITY_BITS);
+    writer.WriteBits(bullet.velocityY, WIRE_VELOCITY_BITS);
+    writer.WriteBits(bullet.lifetime, WIRE_LIFETIME_BITS);
+    writer.WriteBits(bullet.owner, WIRE_PLAYER_BITS);
+    writer.WriteBits(bullet.bounces, WIRE_BOUNCE_BITS);
+}
+
+void ReadWireBullet(BitReader& reader, WireBullet& bullet) {
+    bullet.x = (uint16_t)reader.ReadBits(WIRE_POSITION_BITS);
+    bullet.y = (uint16_t)reader.ReadBits(WIRE_POSITION_BITS);
+    bullet.velocityX = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    bullet.velocityY = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    bullet.lifetime = (uint8_t)reader.ReadBits(WIRE_LIFETIME_BITS);
+    bullet.owner = (uint8_t)reader.ReadBits(WIRE_PLAYER_BITS);
+    bullet.bounces = (uint8_t)reader.ReadBits(WIRE_BOUNCE_BITS);
+}
+
+// Consume the type tag; false if it is not the expected one
+static bool ReadType(BitReader& reader, PacketType type) {
+    return reader.ReadBits(WIRE_TYPE_BITS) == (uint32_t)type && !reader.Overflowed();
+}
+
+// Packet encoding
+void WritePacket(BitWriter& writer, const InputPacket& packet) {
+    writer.WriteBits(PACKET_INPUT, WIRE_TYPE_BITS);
+    writer.WriteBits(packet.tick, 32);
+    writer.WriteBits(packet.buttons, 5);
+}
+
+void WritePacket(BitWriter& writer, const StartPacket& packet) {
+    writer.WriteBits(PACKET_START, WIRE_TYPE_BITS);
+    writer.WriteBits(packet.seed, 32);
+}
+
+void WritePacket(BitWriter& writer, const GameStatePacket& packet) {
+    writer.WriteBits(PACKET_GAME_STATE, WIRE_TYPE_BITS);
+    writer.WriteVarUint((uint32_t)packet.tanks.size());
+    for (const Tank& tank : packet.tanks) {
+        WireTank wire;
+        QuantizeTank(tank, wire);
+        WriteWireTank(writer, wire);
+    }
+    writer.WriteVarUint((uint32_t)packet.bullets.size());
+    for (const Bullet& bullet : packet.bullets) {
+        WireBullet wire;
+        QuantizeBullet(bullet, wire);
+        WriteWireBullet(writer, wire);
+    }
+}
+
+void WritePacket(BitWriter& writer, const BulletPacket& packet) {
+    WireBullet wire;
+    QuantizeBullet(packet.bullet, wire);
+    writer.WriteBits(PACKET_BULLET, WIRE_TYPE_BITS);
+    WriteWireBullet(writer, wire);
+}
+
+void WritePacket(BitWriter& writer, const SnapshotAckPacket& packet) {
+    writer.WriteBits(PACKET_SNAPSHOT_ACK, WIRE_TYPE_BITS);
+    writer.WriteBits(packet.sequence, 16);
+}
+
+void WritePacket(BitWriter& writer, const JoinedPacket& packet) {
+    writer.WriteBits(PACKET_JOINED, WIRE_TYPE_BITS);
+    writer.WriteVarUint(packet.room);
+    writer.WriteBits(packet.player, WIRE_PLAYER_BITS);
+}
+
+void WritePacket(BitWriter& writer, const DisconnectPacket&) {
+    writer.WriteBits(PACKET_DISCONNECT, WIRE_TYPE_BITS);
+}
+
+int PeekPacketType(const uint8_t* data, size_t size) {
+    return (size > 0) ? (data[0] & ((1 << WIRE_TYPE_BITS) - 1)) : 0;
+}
+
+// Packet decoding
+bool ReadPacket(BitReader& reader, InputPacket& packet) {
+    if (!ReadType(reader, PACKET_INPUT)) {
+        return false;
+    }
+    packet.tick = reader.ReadBits(32);
+    packet.buttons = (uint8_t)reader.ReadBits(5);
+    return !reader.Overflowed();
+}
+
+bool ReadPacket(BitReader& reader, StartPacket& packet) {
+    if (!ReadType(reader, PACKET_START)) {
+        return false;
+    }
+    packet.seed = reader.ReadBits(32);
+    return !reader.Overflowed();
+}
+
+bool ReadPacket(BitReader& reader, GameStatePacket& packet) {
+    if (!ReadType(reader, PACKET_GAME_STATE)) {
+        return false;
+    }
+    // Lists are checked against what is left to read before anything grows
+    uint32_t tankCount = reader.ReadVarUint();
+    if (tankCount > (uint32_t)MAX_PLAYERS || reader.Overflowed()) {
+        return false;
+    }
+    packet.tanks.resize(tankCount);
+    for (Tank& tank : packet.tanks) {
+        WireTank wire;
+        ReadWireTank(reader, wire);
+        DequantizeTank(wire, tank);
+    }
+    uint32_t bulletCount = reader.ReadVarUint();
+    if (bulletCount > (uint32_t)WIRE_MAX_BULLETS || reader.Overflowed() ||
+        bulletCount * (size_t)WIRE_BULLET_BITS > reader.BitsLeft()) {
+        return false;
+    }
+    packet.bullets.resize(bulletCount);
+    for (Bullet& bullet : packet.bullets) {
+        WireBullet wire;
+        ReadWireBullet(reader, wire);
+        DequantizeBullet(wire, bullet);
+    }
+    return !reader.Overflowed();
+}
+
+bool ReadPacket(BitReader& reader, BulletPacket& packet) {
+    if (!ReadType(reader, PACKET_BULLET)) {
+        return false;
+    }
+    WireBullet wire;
+    ReadWireBullet(reader, wire);
+    if (reader.Overflowed()) {
+        return false;
+    }
+    DequantizeBullet(wire, packet.bullet);
+    return true;
+}
+
+bool ReadPacket(BitReader& reader, SnapshotAckPacket& packet) {
+    if (!ReadType(reader, PACKET_SNAPSHOT_ACK)) {
+        return false;
+    }
+    packet.sequence = (uint16_t)reader.ReadBits(16);
+    return !reader.Overflowed();
+}
+
+bool ReadPacket(BitReader& reader, JoinedPacket& packet) {
+    if (!ReadType(reader, PACKET_JOINED)) {
+        return false;
+    }
+    packet.room = reader.ReadVarUint();
+    packet.player = (uint8_t)reader.ReadBits(WIRE_PLAYER_BITS);
+    return !reader.Overflowed() && packet.player < MAX_PLAYERS;
+}
+
+bool ReadPacket(BitReader& reader, DisconnectPacket&) {
+    return ReadType(reader, PACKET_DISCONNECT);
+}
@@ -0,0 +1,178 @@
+#ifndef PACKETS_H
+#define PACKETS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bitstream.h"
+#include "game.h"
+
+struct Camera;
+
+// Packets exchanged by the client, the server and the headless tools.
+// The structs are in-memory messages only; on the wire every packet is a
+// 4-bit PacketType tag followed by its fields bit-packed with BitWriter,
+// with positions, velocities and angles quantized (see the WIRE_ constants)
+// and entity lists prefixed by their length. The encoding is independent of
+// struct layout, padding and byte order.
+
+// Wire quantization: positions cover arenas up to 4096 px in 1/16 px steps,
+// velocities +-32 px per tick in 1/256 px steps
+const float WIRE_POSITION_MAX = 4096.0f;
+const int WIRE_POSITION_BITS = 16;
+const float WIRE_VELOCITY_MAX = 32.0f;
+const int WIRE_VELOCITY_BITS = 14;
+const int WIRE_ROTATION_BITS = 12;
+const int WIRE_COOLDOWN_BITS = 5;
+const int WIRE_LIFETIME_BITS = 7;
+const int WIRE_BOUNCE_BITS = 3;
+const int WIRE_PLAYER_BITS = 6;         // Player IDs are 1-based and at most MAX_PLAYERS
+const int WIRE_TYPE_BITS = 4;
+const int WIRE_MAX_PACKET_BYTES = 1024;  // Upper bound of any encoded packet
+const int WIRE_MAX_BULLETS = BulletPool::DEFAULT_CAPACITY;  // Longest bullet list a decoder accepts
+
+// Is 16-bit sequence number a newer than b, allowing for wraparound?
+inline bool SequenceNewer(uint16_t a, uint16_t b) {
+    return (int16_t)(uint16_t)(a - b) > 0;
+}
+
+// Network packet types
+enum PacketType {
+    PACKET_INPUT = 1,
+    PACKET_GAME_STATE,
+    PACKET_BULLET,
+    PACKET_DISCONNECT,
+    PACKET_START,
+    PACKET_SNAPSHOT,        // Delta-compressed game state (see snapshot_delta.h)
+    PACKET_SNAPSHOT_ACK,
+    PACKET_JOINED           // Dedicated server placed the client in a room
+};
+
+// Input packet structure: one player's InputButton flags for one tick
+struct InputPacket {
+    uint32_t tick;
+    uint8_t buttons;
+    
+    InputPacket() : tick(0), buttons(0) {}
+};
+
+// Match start packet structure: the host picks the maze seed for both peers
+struct StartPacket {
+    uint32_t seed;
+    
+    StartPacket() : seed(0) {}
+};
+
+// Game state packet structure: one tank per player, in player order, and
+// every live bullet. A reused packet keeps its capacity, so building one
+// every tick does not allocate.
+struct GameStatePacket {
+    std::vector<Tank> tanks;
+    std::vector<Bullet> bullets;
+};
+
+// Bullet creation packet structure
+struct BulletPacket {
+    Bullet bullet;
+};
+
+// Disconnect packet structure
+struct DisconnectPacket {
+};
+
+// Acknowledges the newest snapshot a client has decoded, so the server can
+// use it as the baseline for later deltas
+struct SnapshotAckPacket {
+    uint16_t sequence;
+    
+    SnapshotAckPacket() : sequence(0) {}
+};
+
+// Tells a client of a dedicated server which room and player slot it got;
+// a StartPacket follows once the room is full
+struct JoinedPacket {
+    uint32_t room;
+    uint8_t player;         // 0-based player index in the room
+    
+    JoinedPacket() : room(0), player(0) {}
+};
+
+// Quantized game state: exactly the values the wire carries. Delta encoding
+// compares these rather than floats, so quantization noise never counts as
+// a change and both ends reconstruct bit-identical baselines.
+struct WireTank {
+    uint16_t x, y;
+    uint16_t velocityX, velocityY;
+    uint16_t rotation;
+    uint8_t alive;
+    uint8_t cooldown;
+    uint8_t player;         // playerID - 1
+};
+
+struct WireBullet {
+    uint16_t x, y;
+    uint16_t velocityX, velocityY;
+    uint8_t lifetime;
+    uint8_t owner;          // ownerID - 1
+    uint8_t bounces;
+};
+
+struct WireGameState {
+    std::vector<WireTank> tanks;
+    std::vector<WireBullet> bullets;
+};
+
+// Fill a game state packet with the state's playerCount tanks and all of
+// its bullets
+void BuildGameStatePacket(const GameState& gameState, GameStatePacket& packet);
+
+// Same, for one client's view: only bullets the camera could show this tick
+// are included
+void BuildGameStatePacket(const GameState& gameState, const Camera& view, GameStatePacket& packet);
+
+// Overwrite the state's tanks, player count and bullets with a received
+// packet's contents
+void ApplyGameStatePacket(const GameStatePacket& packet, GameState& gameState);
+
+// Convert between a game state packet and its quantized wire values
+void QuantizeGameState(const GameStatePacket& packet, WireGameState& wire);
+void DequantizeGameState(const WireGameState& wire, GameStatePacket& packet);
+
+// Every field of one quantized entity at its full width
+void WriteWireTank(BitWriter& writer, const WireTank& tank);
+void ReadWireTank(BitReader& reader, WireTank& tank);
+void WriteWireBullet(BitWriter& writer, const WireBullet& bullet);
+void ReadWireBullet(BitReader& reader, WireBullet& bullet);
+
+// Append a packet's wire encoding, type tag first. Entity lists are always
+// written whole; a game state with more tanks and bullets than fit in
+// WIRE_MAX_PACKET_BYTES encodes larger than that, and every transport
+// refuses it, so callers check the size (see FitsOnWire).
+void WritePacket(BitWriter& writer, const InputPacket& packet);
+void WritePacket(BitWriter& writer, const StartPacket& packet);
+void WritePacket(BitWriter& writer, const GameStatePacket& packet);
+void WritePacket(BitWriter& writer, const BulletPacket& packet);
+void WritePacket(BitWriter& writer, const DisconnectPacket& packet);
+void WritePacket(BitWriter& writer, const SnapshotAckPacket& packet);
+void WritePacket(BitWriter& writer, const JoinedPacket& packet);
+
+// Can the encoded packet be sent as one frame or datagram?
+inline bool FitsOnWire(const BitWriter& writer) {
+    return writer.Size() <= (size_t)WIRE_MAX_PACKET_BYTES;
+}
+
+// Type tag of an encoded packet, or 0 if there is none
+int PeekPacketType(const uint8_t* data, size_t size);
+
+// Parse a packet; returns false if the type tag does not match or the data
+// is truncated or out of range. Previous positions are not sent; they are
+// rebuilt from the velocities so render interpolation keeps working.
+bool ReadPacket(BitReader& reader, InputPacket& packet);
+bool ReadPacket(BitReader& reader, StartPacket& packet);
+bool ReadPacket(BitReader& reader, GameStatePacket& packet);
+bool ReadPacket(BitReader& reader, BulletPacket& packet);
+bool ReadPacket(BitReader& reader, DisconnectPacket& packet);
+bool ReadPacket(BitReader& reader, SnapshotAckPacket& packet);
+bool ReadPacket(BitReader& reader, JoinedPacket& packet);
+
+#endif // PACKETS_H
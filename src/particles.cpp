@@ -0,0 +1,133 @@
+#include "particles.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLES_SSE2 1
+#endif
+
+// Unit vectors for the 8 explosion directions (0, 45, ..., 315 degrees)
+static const float kDiag = 0.70710678f;
+static const float kBurstDirX[8] = { 1.0f, kDiag, 0.0f, -kDiag, -1.0f, -kDiag, 0.0f, kDiag };
+static const float kBurstDirY[8] = { 0.0f, kDiag, 1.0f, kDiag, 0.0f, -kDiag, -1.0f, -kDiag };
+
+ParticleSystem::ParticleSystem(int capacity) : head(0), count(0), rngState(0x9E3779B9u) {
+    if (capacity <= 0) {
+        mask = -1;
+        return;
+    }
+    int size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    x.resize(size);
+    y.resize(size);
+    vx.resize(size);
+    vy.resize(size);
+    lifetime.resize(size);
+}
+
+void ParticleSystem::Spawn(float posX, float posY, float velX, float velY) {
+    if (mask < 0) {
+        return;
+    }
+    if (count > mask) {
+        // Ring is full: drop the oldest particle
+        head = (head + 1) & mask;
+        count--;
+    }
+    int slot = (head + count) & mask;
+    x[slot] = posX;
+    y[slot] = posY;
+    vx[slot] = velX;
+    vy[slot] = velY;
+    lifetime[slot] = PARTICLE_LIFETIME;
+    count++;
+}
+
+void ParticleSystem::AddExplosion(float posX, float posY) {
+    if (mask < 0) {
+        return;
+    }
+    for (int i = 0; i < 8; i++) {
+        float speed = 2.0f + (float)(NextRandom() % 3);
+        Spawn(posX, posY, kBurstDirX[i] * speed, kBurstDirY[i] * speed);
+    }
+}
+
+void ParticleSystem::Update() {
+    if (count == 0) {
+        return;
+    }
+
+    // The live range may wrap around the end of the ring
+    int firstLength = count;
+    if (head + firstLength > mask + 1) {
+        firstLength = mask + 1 - head;
+    }
+    UpdateRange(head, firstLength);
+    if (firstLength < count) {
+        UpdateRange(0, count - firstLength);
+    }
+
+    // Particles expire in spawn order, so dead ones are always at the head
+    while (count > 0 && lifetime[head] <= 0) {
+        head = (head + 1) & mask;
+        count--;
+    }
+}
+
+void ParticleSystem::UpdateRange(int start, int length) {
+    float* px = x.data() + start;
+    float* py = y.data() + start;
+    float* pvx = vx.data() + start;
+    float* pvy = vy.data() + start;
+    int32_t* plife = lifetime.data() + start;
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256 damping = _mm256_set1_ps(PARTICLE_DAMPING);
+    const __m256i one = _mm256_set1_epi32(1);
+    for (; i + 8 <= length; i += 8) {
+        __m256 velX = _mm256_loadu_ps(pvx + i);
+        __m256 velY = _mm256_loadu_ps(pvy + i);
+        _mm256_storeu_ps(px + i, _mm256_add_ps(_mm256_loadu_ps(px + i), velX));
+        _mm256_storeu_ps(py + i, _mm256_add_ps(_mm256_loadu_ps(py + i), velY));
+        _mm256_storeu_ps(pvx + i, _mm256_mul_ps(velX, damping));
+        _mm256_storeu_ps(pvy + i, _mm256_mul_ps(velY, damping));
+        __m256i life = _mm256_loadu_si256((const __m256i*)(plife + i));
+        _mm256_storeu_si256((__m256i*)(plife + i), _mm256_sub_epi32(life, one));
+    }
+#elif defined(PARTICLES_SSE2)
+    const __m128 damping = _mm_set1_ps(PARTICLE_DAMPING);
+    const __m128i one = _mm_set1_epi32(1);
+    for (; i + 4 <= length; i += 4) {
+        __m128 velX = _mm_loadu_ps(pvx + i);
+        __m128 velY = _mm_loadu_ps(pvy + i);
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), velX));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), velY));
+        _mm_storeu_ps(pvx + i, _mm_mul_ps(velX, damping));
+        _mm_storeu_ps(pvy + i, _mm_mul_ps(velY, damping));
+        __m128i life = _mm_loadu_si128((const __m128i*)(plife + i));
+        _mm_storeu_si128((__m128i*)(plife + i), _mm_sub_epi32(life, one));
+    }
+#endif
+
+    // Scalar fallback and tail
+    for (; i < length; i++) {
+        px[i] += pvx[i];
+        py[i] += pvy[i];
+        pvx[i] *= PARTICLE_DAMPING;
+        pvy[i] *= PARTICLE_DAMPING;
+        plife[i]--;
+    }
+}
+
+uint32_t ParticleSystem::NextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
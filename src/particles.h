@@ -0,0 +1,61 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <cstdint>
+#include <vector>
+
+const int PARTICLE_LIFETIME = 20;      // frames
+const float PARTICLE_DAMPING = 0.95f;  // Velocity multiplier per frame
+
+// Structure-of-arrays particle system backed by a ring buffer.
+// Every particle is spawned with the same lifetime, so particles always expire
+// in the order they were created: the live set is the contiguous ring range
+// [head, head + count) and dead particles are retired from the head without
+// any compaction. Integration runs as SSE2/AVX2 kernels when available with a
+// scalar fallback. When the ring is full the oldest particles are overwritten.
+// A system built with capacity 0 allocates nothing and ignores spawns, for
+// states nobody renders.
+class ParticleSystem {
+public:
+    static const int DEFAULT_CAPACITY = 8192;
+
+    // Constructor; capacity is rounded up to a power of two
+    explicit ParticleSystem(int capacity = DEFAULT_CAPACITY);
+
+    // Spawn a single particle
+    void Spawn(float x, float y, float velX, float velY);
+
+    // Spawn an 8-direction burst using the precomputed direction table
+    void AddExplosion(float x, float y);
+
+    // Integrate, damp and age every live particle, then retire dead ones
+    void Update();
+
+    // Remove all particles
+    void Clear() { head = 0; count = 0; }
+
+    int Count() const { return count; }
+    int Capacity() const { return mask + 1; }
+
+    // Accessors by logical index (0 = oldest live particle)
+    float X(int i) const { return x[(head + i) & mask]; }
+    float Y(int i) const { return y[(head + i) & mask]; }
+    int Lifetime(int i) const { return lifetime[(head + i) & mask]; }
+
+private:
+    // Update a contiguous run of slots
+    void UpdateRange(int start, int length);
+
+    // Next value from the burst-speed generator
+    uint32_t NextRandom();
+
+    std::vector<float> x, y;          // Positions
+    std::vector<float> vx, vy;        // Velocities
+    std::vector<int32_t> lifetime;    // Remaining lifetime in frames
+    int mask;                         // Capacity - 1 (-1 without a ring)
+    int head;                         // Slot of the oldest live particle
+    int count;                        // Number of live particles
+    uint32_t rngState;                // xorshift32 state for burst speeds
+};
+
+#endif // PARTICLES_H
@@ -0,0 +1,182 @@
+#include "profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+static const std::chrono::steady_clock::time_point g_profilerEpoch = std::chrono::steady_clock::now();
+
+uint64_t ProfilerNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - g_profilerEpoch).count();
+}
+
+#if defined(TROUBLE_ENABLE_PROFILER)
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Events recorded by one thread.
+// started counts writes begun and published counts writes finished; a
+// reader copies up to published and then keeps only entries newer than
+// started - CAPACITY, which the writer cannot have touched during the copy.
+struct ProfilerRing {
+    static const int CAPACITY = 1 << 14;     // Power of two
+
+    struct Event {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> duration;
+    };
+
+    int threadIndex;
+    std::atomic<uint64_t> started;
+    std::atomic<uint64_t> published;
+    Event events[CAPACITY];
+
+    explicit ProfilerRing(int index) : threadIndex(index), started(0), published(0) {}
+};
+
+// Plain copy of an event taken out of a ring
+struct ProfilerEventCopy {
+    const char* name;
+    uint64_t start;
+    uint64_t duration;
+    int threadIndex;
+};
+
+static std::mutex g_ringMutex;
+static std::vector<std::unique_ptr<ProfilerRing>> g_rings;   // Kept after their threads exit
+static thread_local ProfilerRing* t_ring = nullptr;
+
+static ProfilerRing* ThreadRing() {
+    if (!t_ring) {
+        std::lock_guard<std::mutex> lock(g_ringMutex);
+        g_rings.push_back(std::unique_ptr<ProfilerRing>(new ProfilerRing((int)g_rings.size())));
+        t_ring = g_rings.back().get();
+    }
+    return t_ring;
+}
+
+bool ProfilerEnabled() {
+    return true;
+}
+
+void ProfilerRecord(const char* name, uint64_t startNs, uint64_t durationNs) {
+    ProfilerRing* ring = ThreadRing();
+    uint64_t index = ring->started.load(std::memory_order_relaxed);
+    ring->started.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ProfilerRing::Event& event = ring->events[index & (ProfilerRing::CAPACITY - 1)];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(startNs, std::memory_order_relaxed);
+    event.duration.store(durationNs, std::memory_order_relaxed);
+
+    ring->published.store(index + 1, std::memory_order_release);
+}
+
+// Append the consistent events of every ring that started at or after sinceNs
+static void CopyEvents(uint64_t sinceNs, std::vector<ProfilerEventCopy>& out) {
+    std::lock_guard<std::mutex> lock(g_ringMutex);
+    for (const auto& ring : g_rings) {
+        uint64_t end = ring->published.load(std::memory_order_acquire);
+        uint64_t begin = (end > (uint64_t)ProfilerRing::CAPACITY) ? end - ProfilerRing::CAPACITY : 0;
+
+        size_t first = out.size();
+        for (uint64_t i = begin; i < end; i++) {
+            const ProfilerRing::Event& event = ring->events[i & (ProfilerRing::CAPACITY - 1)];
+            ProfilerEventCopy copy;
+            copy.name = event.name.load(std::memory_order_relaxed);
+            copy.start = event.start.load(std::memory_order_relaxed);
+            copy.duration = event.duration.load(std::memory_order_relaxed);
+            copy.threadIndex = ring->threadIndex;
+            out.push_back(copy);
+        }
+
+        // Drop entries the writer may have overwritten while we copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t started = ring->started.load(std::memory_order_relaxed);
+        uint64_t safe = (started > (uint64_t)ProfilerRing::CAPACITY) ? started - ProfilerRing::CAPACITY : 0;
+        size_t keep = first;
+        for (uint64_t i = begin; i < end; i++) {
+            const ProfilerEventCopy& copy = out[first + (size_t)(i - begin)];
+            if (i >= safe && copy.start >= sinceNs) {
+                out[keep++] = copy;
+            }
+        }
+        out.resize(keep);
+    }
+}
+
+bool WriteProfilerTrace(const char* path) {
+    std::vector<ProfilerEventCopy> events;
+    CopyEvents(0, events);
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    for (size_t i = 0; i < events.size(); i++) {
+        const ProfilerEventCopy& event = events[i];
+        fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                event.name, event.threadIndex, event.start / 1000.0, event.duration / 1000.0,
+                (i + 1 < events.size()) ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    return fclose(file) == 0;
+}
+
+int SummarizeProfilerPhases(uint64_t windowNs, PhaseSummary* out, int maxPhases) {
+    uint64_t now = ProfilerNowNs();
+    std::vector<ProfilerEventCopy> events;
+    CopyEvents(now > windowNs ? now - windowNs : 0, events);
+
+    // Group by phase name in order of first appearance
+    std::vector<const char*> names;
+    std::vector<std::vector<uint64_t>> durations;
+    for (const ProfilerEventCopy& event : events) {
+        size_t phase = 0;
+        while (phase < names.size() && strcmp(names[phase], event.name) != 0) {
+            phase++;
+        }
+        if (phase == names.size()) {
+            names.push_back(event.name);
+            durations.push_back(std::vector<uint64_t>());
+        }
+        durations[phase].push_back(event.duration);
+    }
+
+    int count = 0;
+    for (size_t phase = 0; phase < names.size() && count < maxPhases; phase++) {
+        std::vector<uint64_t>& samples = durations[phase];
+        std::sort(samples.begin(), samples.end());
+        PhaseSummary& summary = out[count++];
+        summary.name = names[phase];
+        summary.count = (uint32_t)samples.size();
+        summary.p50Ns = samples[(samples.size() - 1) * 50 / 100];
+        summary.p99Ns = samples[(samples.size() - 1) * 99 / 100];
+    }
+    return count;
+}
+
+#else
+
+bool ProfilerEnabled() {
+    return false;
+}
+
+void ProfilerRecord(const char*, uint64_t, uint64_t) {}
+
+bool WriteProfilerTrace(const char*) {
+    return false;
+}
+
+int SummarizeProfilerPhases(uint64_t, PhaseSummary*, int) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+// Scoped frame profiler.
+// TROUBLE_PROFILE_SCOPE("Name") times the enclosing scope and records it in
+// a ring buffer owned by the calling thread. Only that thread writes its
+// ring, so recording is a clock read and three relaxed stores with no locks
+// or allocation; readers copy a ring and then re-check its head to discard
+// entries overwritten while they were copying. Recent events can be dumped
+// as Chrome trace JSON (chrome://tracing, Perfetto) or summarized as rolling
+// per-phase percentiles for an overlay.
+//
+// The profiler is only compiled in with TROUBLE_ENABLE_PROFILER (CMake option
+// of the same name). Without it the macro expands to nothing, so profiled
+// code is identical to unprofiled code.
+#if defined(TROUBLE_ENABLE_PROFILER)
+#define TROUBLE_PROFILE_CONCAT_INNER(a, b) a##b
+#define TROUBLE_PROFILE_CONCAT(a, b) TROUBLE_PROFILE_CONCAT_INNER(a, b)
+#define TROUBLE_PROFILE_SCOPE(name) ProfileScope TROUBLE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define TROUBLE_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+// Rolling duration percentiles of one phase
+struct PhaseSummary {
+    const char* name;
+    uint32_t count;       // Events inside the window
+    uint64_t p50Ns;
+    uint64_t p99Ns;
+};
+
+// Is profiling compiled in?
+bool ProfilerEnabled();
+
+// Nanoseconds since the profiler started
+uint64_t ProfilerNowNs();
+
+// Record a finished event on the calling thread's ring; name must be a
+// string with static storage duration
+void ProfilerRecord(const char* name, uint64_t startNs, uint64_t durationNs);
+
+// Write every buffered event as Chrome trace JSON; returns false on I/O
+// failure or when profiling is compiled out
+bool WriteProfilerTrace(const char* path);
+
+// Percentiles per phase over events that started in the last windowNs, in
+// order of first appearance; returns the number of phases written
+int SummarizeProfilerPhases(uint64_t windowNs, PhaseSummary* out, int maxPhases);
+
+#if defined(TROUBLE_ENABLE_PROFILER)
+// Times its own lifetime
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), start(ProfilerNowNs()) {}
+    ~ProfileScope() { ProfilerRecord(name, start, ProfilerNowNs() - start); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+#endif
+
+#endif // PROFILER_H
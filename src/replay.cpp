@@ -0,0 +1,450 @@
+#include "replay.h"
+#include <cstdio>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const size_t REPLAY_HEADER_SIZE = 32;
+static const size_t REPLAY_TRAILER_SIZE = 12;
+static const size_t KEYFRAME_HEADER_SIZE = 16;
+
+static void PutU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back((uint8_t)v);
+    out.push_back((uint8_t)(v >> 8));
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((uint8_t)(v >> (i * 8)));
+    }
+}
+
+static void PutU64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        out.push_back((uint8_t)(v >> (i * 8)));
+    }
+}
+
+static void PutF32(std::vector<uint8_t>& out, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    PutU32(out, bits);
+}
+
+static void PutBytes(std::vector<uint8_t>& out, const void* bytes, size_t n) {
+    const uint8_t* p = (const uint8_t*)bytes;
+    out.insert(out.end(), p, p + n);
+}
+
+static uint16_t GetU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t GetU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t GetU64(const uint8_t* p) {
+    return (uint64_t)GetU32(p) | ((uint64_t)GetU32(p + 4) << 32);
+}
+
+static float GetF32(const uint8_t* p) {
+    uint32_t bits = GetU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+// Keyframe entity records, REPLAY_TANK_BYTES and REPLAY_BULLET_BYTES long
+static void PutTank(std::vector<uint8_t>& out, const Tank& tank) {
+    PutF32(out, tank.x);
+    PutF32(out, tank.y);
+    PutF32(out, tank.prevX);
+    PutF32(out, tank.prevY);
+    PutF32(out, tank.rotation);
+    PutF32(out, tank.velocityX);
+    PutF32(out, tank.velocityY);
+    out.push_back(tank.alive ? 1 : 0);
+    PutU32(out, (uint32_t)tank.cooldown);
+    PutU32(out, (uint32_t)tank.playerID);
+}
+
+static const uint8_t* GetTank(const uint8_t* p, Tank& tank) {
+    tank.x = GetF32(p);
+    tank.y = GetF32(p + 4);
+    tank.prevX = GetF32(p + 8);
+    tank.prevY = GetF32(p + 12);
+    tank.rotation = GetF32(p + 16);
+    tank.velocityX = GetF32(p + 20);
+    tank.velocityY = GetF32(p + 24);
+    tank.alive = p[28] != 0;
+    tank.cooldown = (int)GetU32(p + 29);
+    tank.playerID = (int)GetU32(p + 33);
+    return p + REPLAY_TANK_BYTES;
+}
+
+static void PutBullet(std::vector<uint8_t>& out, const Bullet& bullet) {
+    PutF32(out, bullet.x);
+    PutF32(out, bullet.y);
+    PutF32(out, bullet.prevX);
+    PutF32(out, bullet.prevY);
+    PutF32(out, bullet.velocityX);
+    PutF32(out, bullet.velocityY);
+    out.push_back(bullet.active ? 1 : 0);
+    PutU32(out, (uint32_t)bullet.lifetime);
+    PutU32(out, (uint32_t)bullet.ownerID);
+    PutU32(out, (uint32_t)bullet.bounceCount);
+}
+
+static const uint8_t* GetBullet(const uint8_t* p, Bullet& bullet) {
+    bullet.x = GetF32(p);
+    bullet.y = GetF32(p + 4);
+    bullet.prevX = GetF32(p + 8);
+    bullet.prevY = GetF32(p + 12);
+    bullet.velocityX = GetF32(p + 16);
+    bullet.velocityY = GetF32(p + 20);
+    bullet.active = p[24] != 0;
+    bullet.lifetime = (int)GetU32(p + 25);
+    bullet.ownerID = (int)GetU32(p + 29);
+    bullet.bounceCount = (int)GetU32(p + 33);
+    return p + REPLAY_BULLET_BYTES;
+}
+
+// ReplayWriter methods
+ReplayWriter::ReplayWriter(int keyframeInterval)
+    : keyframeInterval(keyframeInterval < 1 ? 1 : keyframeInterval), playerCount(0),
+      mazeSeed(0), startTick(0), tickCount(0) {}
+
+void ReplayWriter::Begin(const GameState& state) {
+    playerCount = state.playerCount;
+    mazeSeed = state.mazeSeed;
+    startTick = state.tick;
+    tickCount = 0;
+    inputBits.clear();
+    keyframes.clear();
+    keyframeOffsets.clear();
+}
+
+void ReplayWriter::RecordTick(const GameState& state, const uint8_t* buttons) {
+    if (tickCount % (uint32_t)keyframeInterval == 0) {
+        AddKeyframe(state);
+    }
+
+    // Append playerCount fields of REPLAY_INPUT_BITS bits each
+    uint64_t bit = (uint64_t)tickCount * playerCount * REPLAY_INPUT_BITS;
+    for (int p = 0; p < playerCount; p++) {
+        uint32_t value = buttons[p] & ((1u << REPLAY_INPUT_BITS) - 1);
+        for (int b = 0; b < REPLAY_INPUT_BITS; b++, bit++) {
+            if ((bit >> 3) >= inputBits.size()) {
+                inputBits.push_back(0);
+            }
+            if (value & (1u << b)) {
+                inputBits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+            }
+        }
+    }
+    tickCount++;
+}
+
+void ReplayWriter::AddKeyframe(const GameState& state) {
+    keyframeOffsets.push_back(keyframes.size());
+
+    // The fields a GameSnapshot holds, written straight from the state
+    PutU32(keyframes, state.tick);
+    PutU32(keyframes, (uint32_t)state.bullets.Count());
+    PutU32(keyframes, (uint32_t)state.winner);
+    keyframes.push_back(state.gameOver ? 1 : 0);
+    keyframes.push_back(state.gameRunning ? 1 : 0);
+    PutU16(keyframes, 0);
+    for (int p = 0; p < playerCount; p++) {
+        PutU32(keyframes, (uint32_t)state.scores[p]);
+    }
+    for (int p = 0; p < playerCount; p++) {
+        PutTank(keyframes, state.tanks[p]);
+    }
+    for (const Bullet& bullet : state.bullets) {
+        PutBullet(keyframes, bullet);
+    }
+}
+
+void ReplayWriter::Serialize(std::vector<uint8_t>& out) const {
+    out.clear();
+    PutU32(out, REPLAY_MAGIC);
+    PutU16(out, REPLAY_VERSION);
+    PutU16(out, (uint16_t)playerCount);
+    PutU32(out, mazeSeed);
+    PutU32(out, startTick);
+    PutU32(out, tickCount);
+    PutU32(out, (uint32_t)keyframeInterval);
+    PutU16(out, (uint16_t)REPLAY_TANK_BYTES);
+    PutU16(out, (uint16_t)REPLAY_BULLET_BYTES);
+    PutU32(out, 0); // Reserved
+
+    // Inputs, padded so the packed stream always has whole bytes to read
+    size_t inputBytes = ((uint64_t)tickCount * playerCount * REPLAY_INPUT_BITS + 7) / 8;
+    PutBytes(out, inputBits.data(), inputBytes);
+
+    uint64_t keyframeBase = out.size();
+    PutBytes(out, keyframes.data(), keyframes.size());
+
+    uint64_t indexOffset = out.size();
+    PutU32(out, (uint32_t)keyframeOffsets.size());
+    for (uint64_t offset : keyframeOffsets) {
+        PutU64(out, keyframeBase + offset);
+    }
+
+    PutU64(out, indexOffset);
+    PutU32(out, REPLAY_INDEX_MAGIC);
+}
+
+size_t ReplayWriter::EncodedSize() const {
+    size_t inputBytes = ((uint64_t)tickCount * playerCount * REPLAY_INPUT_BITS + 7) / 8;
+    return REPLAY_HEADER_SIZE + inputBytes + keyframes.size() + 4 + keyframeOffsets.size() * 8 +
+           REPLAY_TRAILER_SIZE;
+}
+
+bool ReplayWriter::Save(const char* path) const {
+    std::vector<uint8_t> bytes;
+    Serialize(bytes);
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    ok = (fclose(file) == 0) && ok;
+    return ok;
+}
+
+// ReplayReader methods
+ReplayReader::ReplayReader()
+    : data(nullptr), size(0), mapping(nullptr), mappedSize(0), playerCount(0), mazeSeed(0),
+      startTick(0), tickCount(0), keyframeInterval(1), inputBits(nullptr), index(nullptr),
+      keyframeCount(0) {}
+
+ReplayReader::~ReplayReader() {
+    Close();
+}
+
+bool ReplayReader::Open(const char* path) {
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!fileMapping) {
+        return false;
+    }
+    // The view keeps the mapping alive after its handle is closed
+    void* view = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(fileMapping);
+    if (!view) {
+        return false;
+    }
+    mapping = view;
+    mappedSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    mapping = view;
+    mappedSize = (size_t)info.st_size;
+#endif
+
+    data = (const uint8_t*)mapping;
+    size = mappedSize;
+    if (!Parse()) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool ReplayReader::Load(const uint8_t* bytes, size_t length) {
+    Close();
+    data = bytes;
+    size = length;
+    if (!Parse()) {
+        data = nullptr;
+        size = 0;
+        return false;
+    }
+    return true;
+}
+
+void ReplayReader::Close() {
+    if (mapping) {
+#if defined(_WIN32)
+        UnmapViewOfFile(mapping);
+#else
+        munmap(mapping, mappedSize);
+#endif
+        mapping = nullptr;
+        mappedSize = 0;
+    }
+    data = nullptr;
+    size = 0;
+    inputBits = nullptr;
+    index = nullptr;
+    keyframeCount = 0;
+    tickCount = 0;
+}
+
+bool ReplayReader::Parse() {
+    if (size < REPLAY_HEADER_SIZE + REPLAY_TRAILER_SIZE) {
+        return false;
+    }
+    if (GetU32(data) != REPLAY_MAGIC || GetU16(data + 4) != REPLAY_VERSION) {
+        return false;
+    }
+    if (GetU16(data + 24) != REPLAY_TANK_BYTES || GetU16(data + 26) != REPLAY_BULLET_BYTES) {
+        return false;
+    }
+
+    playerCount = GetU16(data + 6);
+    mazeSeed = GetU32(data + 8);
+    startTick = GetU32(data + 12);
+    tickCount = GetU32(data + 16);
+    keyframeInterval = (int)GetU32(data + 20);
+    if (playerCount < 1 || playerCount > MAX_PLAYERS || keyframeInterval < 1) {
+        return false;
+    }
+
+    uint64_t inputBytes = ((uint64_t)tickCount * playerCount * REPLAY_INPUT_BITS + 7) / 8;
+    if (REPLAY_HEADER_SIZE + inputBytes > size) {
+        return false;
+    }
+    inputBits = data + REPLAY_HEADER_SIZE;
+
+    // Trailer points at the index
+    const uint8_t* trailer = data + size - REPLAY_TRAILER_SIZE;
+    if (GetU32(trailer + 8) != REPLAY_INDEX_MAGIC) {
+        return false;
+    }
+    uint64_t indexOffset = GetU64(trailer);
+    if (indexOffset + 4 > size - REPLAY_TRAILER_SIZE) {
+        return false;
+    }
+    keyframeCount = GetU32(data + indexOffset);
+    if (indexOffset + 4 + (uint64_t)keyframeCount * 8 > size - REPLAY_TRAILER_SIZE) {
+        return false;
+    }
+    index = data + indexOffset + 4;
+
+    // Every recorded tick must be covered by a keyframe
+    uint64_t needed = (tickCount + (uint64_t)keyframeInterval - 1) / keyframeInterval;
+    return keyframeCount >= needed && (tickCount == 0 || keyframeCount > 0);
+}
+
+uint8_t ReplayReader::Input(uint32_t tick, int player) const {
+    uint64_t bit = ((uint64_t)(tick - startTick) * playerCount + player) * REPLAY_INPUT_BITS;
+
+    // A field spans at most two bytes
+    size_t byte = (size_t)(bit >> 3);
+    uint32_t word = inputBits[byte];
+    uint64_t inputBytes = ((uint64_t)tickCount * playerCount * REPLAY_INPUT_BITS + 7) / 8;
+    if (byte + 1 < inputBytes) {
+        word |= (uint32_t)inputBits[byte + 1] << 8;
+    }
+    return (uint8_t)((word >> (bit & 7)) & ((1u << REPLAY_INPUT_BITS) - 1));
+}
+
+bool ReplayReader::ReadKeyframe(uint32_t keyframe, GameState& state) {
+    if (keyframe >= keyframeCount) {
+        return false;
+    }
+    uint64_t offset = GetU64(index + (size_t)keyframe * 8);
+    if (offset + KEYFRAME_HEADER_SIZE > size) {
+        return false;
+    }
+    const uint8_t* p = data + offset;
+    uint32_t bulletCount = GetU32(p + 4);
+    uint64_t bodySize = (uint64_t)playerCount * (4 + REPLAY_TANK_BYTES) + (uint64_t)bulletCount * REPLAY_BULLET_BYTES;
+    if (bulletCount > (uint32_t)SNAPSHOT_MAX_BULLETS || offset + KEYFRAME_HEADER_SIZE + bodySize > size) {
+        return false;
+    }
+
+    scratch.tick = GetU32(p);
+    scratch.mazeSeed = mazeSeed;
+    scratch.playerCount = playerCount;
+    scratch.bulletCount = (int32_t)bulletCount;
+    scratch.winner = (int32_t)GetU32(p + 8);
+    scratch.gameOver = p[12];
+    scratch.gameRunning = p[13];
+    p += KEYFRAME_HEADER_SIZE;
+    for (int i = 0; i < playerCount; i++, p += 4) {
+        scratch.scores[i] = (int32_t)GetU32(p);
+    }
+    for (int i = 0; i < playerCount; i++) {
+        p = GetTank(p, scratch.tanks[i]);
+    }
+    for (uint32_t i = 0; i < bulletCount; i++) {
+        p = GetBullet(p, scratch.bullets[i]);
+    }
+
+    state.RestoreSnapshot(scratch);
+    state.particles.Clear();
+    return true;
+}
+
+bool ReplayReader::Seek(GameState& state, uint32_t tick) {
+    if (tick < startTick || tick > EndTick()) {
+        return false;
+    }
+
+    if (keyframeCount == 0) {
+        return false;
+    }
+
+    // Nearest keyframe at or before the tick, then re-simulate the gap
+    uint32_t keyframe = (tick - startTick) / (uint32_t)keyframeInterval;
+    if (keyframe >= keyframeCount) {
+        keyframe = keyframeCount - 1;
+    }
+    if (!ReadKeyframe(keyframe, state)) {
+        return false;
+    }
+
+    while (state.tick < tick) {
+        Step(state);
+    }
+    return true;
+}
+
+bool ReplayReader::Step(GameState& state) const {
+    if (state.tick < startTick || state.tick >= EndTick()) {
+        return false;
+    }
+    for (int p = 0; p < playerCount; p++) {
+        state.ApplyInput(p, Input(state.tick, p));
+    }
+    state.Update();
+    return true;
+}
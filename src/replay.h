@@ -0,0 +1,129 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "game.h"
+#include "snapshot.h"
+
+// Replay files.
+// A replay stores only what the simulation cannot reproduce by itself: the
+// maze seed and every player's InputButton flags for every tick, packed at
+// REPLAY_INPUT_BITS bits per player per tick. Every keyframeInterval ticks a
+// full keyframe (the used part of a GameSnapshot) is added, and a footer
+// index maps keyframe number to file offset, so seeking to any tick restores
+// one keyframe and re-simulates at most keyframeInterval - 1 ticks.
+//
+// Layout (all integers little-endian):
+//   header    magic "TTRP", version, player count, seed, start tick, tick
+//             count, keyframe interval, tank and bullet record sizes
+//   inputs    tickCount * playerCount * REPLAY_INPUT_BITS bits, LSB first
+//   keyframes one per interval, starting at the start tick
+//   index     keyframe count, then one 64-bit offset per keyframe
+//   trailer   64-bit index offset, magic "TTRI"
+//
+// Keyframe tanks and bullets are written field by field (floats as their
+// IEEE-754 bits), so files hold no struct padding and do not depend on the
+// compiler's layout; the header records the record sizes so a replay whose
+// records do not match this build is rejected, not misread.
+// The maze is regenerated from the seed with the playback state's generator.
+const uint32_t REPLAY_MAGIC = 0x50525454;        // "TTRP"
+const uint32_t REPLAY_INDEX_MAGIC = 0x49525454;  // "TTRI"
+const uint16_t REPLAY_VERSION = 2;
+const int REPLAY_INPUT_BITS = 5;                 // Bits used by InputButton
+const int REPLAY_TANK_BYTES = 37;                // Encoded Tank record
+const int REPLAY_BULLET_BYTES = 37;              // Encoded Bullet record
+const int REPLAY_DEFAULT_KEYFRAME_INTERVAL = 600;
+
+// Records a match in memory and writes it out as a replay file
+class ReplayWriter {
+public:
+    explicit ReplayWriter(int keyframeInterval = REPLAY_DEFAULT_KEYFRAME_INTERVAL);
+
+    // Start recording from the state as it is now (normally right after Initialize)
+    void Begin(const GameState& state);
+
+    // Record the inputs about to be applied for the state's current tick;
+    // call before ApplyInput/Update. buttons holds one entry per player.
+    void RecordTick(const GameState& state, const uint8_t* buttons);
+
+    // Encode the whole replay
+    void Serialize(std::vector<uint8_t>& out) const;
+
+    // Write the replay to a file; returns false on I/O failure
+    bool Save(const char* path) const;
+
+    // Size in bytes of the encoded replay
+    size_t EncodedSize() const;
+
+    uint32_t TickCount() const { return tickCount; }
+
+private:
+    void AddKeyframe(const GameState& state);
+
+    int keyframeInterval;
+    int playerCount;
+    uint32_t mazeSeed;
+    uint32_t startTick;
+    uint32_t tickCount;
+    std::vector<uint8_t> inputBits;          // Packed inputs
+    std::vector<uint8_t> keyframes;          // Encoded keyframes, back to back
+    std::vector<uint64_t> keyframeOffsets;   // Offsets into keyframes
+};
+
+// Reads a replay from a memory-mapped file or a buffer and plays it back.
+// Nothing is copied out of the mapping; inputs are decoded on demand.
+class ReplayReader {
+public:
+    ReplayReader();
+    ~ReplayReader();
+
+    // Map a replay file; returns false if it cannot be read or is invalid
+    bool Open(const char* path);
+
+    // Use a replay already in memory; the buffer must outlive the reader
+    bool Load(const uint8_t* data, size_t size);
+
+    // Unmap and forget the replay
+    void Close();
+
+    int PlayerCount() const { return playerCount; }
+    uint32_t MazeSeed() const { return mazeSeed; }
+    uint32_t StartTick() const { return startTick; }
+    uint32_t EndTick() const { return startTick + tickCount; }
+    uint32_t TickCount() const { return tickCount; }
+    int KeyframeInterval() const { return keyframeInterval; }
+
+    // Recorded InputButton flags of a player for a tick in [StartTick, EndTick)
+    uint8_t Input(uint32_t tick, int player) const;
+
+    // Put the state at the given tick: restore the nearest earlier keyframe
+    // and re-simulate the rest. Returns false if the tick is out of range.
+    bool Seek(GameState& state, uint32_t tick);
+
+    // Apply the recorded inputs for the state's tick and update once;
+    // returns false once the recording is exhausted
+    bool Step(GameState& state) const;
+
+private:
+    bool Parse();
+    bool ReadKeyframe(uint32_t index, GameState& state);
+
+    const uint8_t* data;
+    size_t size;
+    void* mapping;           // Platform mapping handle owned by the reader
+    size_t mappedSize;
+
+    int playerCount;
+    uint32_t mazeSeed;
+    uint32_t startTick;
+    uint32_t tickCount;
+    int keyframeInterval;
+    const uint8_t* inputBits;
+    const uint8_t* index;
+    uint32_t keyframeCount;
+    GameSnapshot scratch;    // Staging for ReadKeyframe
+};
+
+#endif // REPLAY_H
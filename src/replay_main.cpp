@@ -0,0 +1,238 @@
+// TroubleTanks - Headless replay analyzer
+// Plays recorded matches (see replay.h) back through GameState with no
+// rendering, as fast as the CPU allows on every core, and reports per-match
+// statistics as CSV on stdout with corpus totals on stderr.
+//
+// Usage: trouble_replay [--threads N] [--summary] PATH...
+//
+// Each PATH is a replay file or a directory searched recursively for *.ttr
+// files. Paths are handed out to workers one at a time as they are found, and
+// each worker keeps a single GameState and maps a single replay at a time,
+// so memory use does not grow with the size of the corpus.
+
+#include "game.h"
+#include "replay.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Hands out replay paths to workers, walking directories lazily
+class ReplayFeed {
+public:
+    ReplayFeed(char** paths, int count) : paths(paths), count(count), next(0), walking(false) {}
+
+    // Next replay path; returns false once every input is exhausted
+    bool Next(std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (true) {
+            if (walking) {
+                std::error_code error;
+                while (walker != fs::recursive_directory_iterator()) {
+                    fs::path candidate = walker->path();
+                    bool isReplay = walker->is_regular_file(error) && candidate.extension() == ".ttr";
+                    walker.increment(error);
+                    if (error) {
+                        walker = fs::recursive_directory_iterator();
+                    }
+                    if (isReplay) {
+                        path = candidate.string();
+                        return true;
+                    }
+                }
+                walking = false;
+            }
+
+            if (next >= count) {
+                return false;
+            }
+            const char* arg = paths[next++];
+            std::error_code error;
+            if (fs::is_directory(arg, error)) {
+                walker = fs::recursive_directory_iterator(arg, error);
+                walking = !error;
+                continue;
+            }
+            path = arg;
+            return true;
+        }
+    }
+
+private:
+    std::mutex mutex;
+    char** paths;
+    int count;
+    int next;
+    bool walking;
+    fs::recursive_directory_iterator walker;
+};
+
+// Totals over every match a worker analyzed
+struct CorpusTotals {
+    uint64_t matches;
+    uint64_t failed;
+    uint64_t ticks;
+    uint64_t kills;
+    uint64_t shots;
+    uint64_t firstKillTicks;     // Sum over matches with a kill
+    uint64_t matchesWithKill;
+    uint64_t bulletsByBounces[MAX_BULLET_BOUNCES + 1];
+
+    CorpusTotals() { memset(this, 0, sizeof(*this)); }
+
+    void Merge(const CorpusTotals& other) {
+        matches += other.matches;
+        failed += other.failed;
+        ticks += other.ticks;
+        kills += other.kills;
+        shots += other.shots;
+        firstKillTicks += other.firstKillTicks;
+        matchesWithKill += other.matchesWithKill;
+        for (int b = 0; b <= MAX_BULLET_BOUNCES; b++) {
+            bulletsByBounces[b] += other.bulletsByBounces[b];
+        }
+    }
+};
+
+static std::mutex g_outputMutex;
+static bool g_perMatch = true;
+
+static void AnalyzeReplays(ReplayFeed& feed, CorpusTotals& totals) {
+    GameState state;
+    ReplayReader reader;
+    std::string path;
+
+    while (feed.Next(path)) {
+        if (!reader.Open(path.c_str()) || !reader.Seek(state, reader.StartTick())) {
+            totals.failed++;
+            std::lock_guard<std::mutex> lock(g_outputMutex);
+            fprintf(stderr, "trouble_replay: cannot read %s\n", path.c_str());
+            continue;
+        }
+
+        // The keyframe restore does not carry counters; start them from here
+        state.stats.Clear();
+        while (reader.Step(state)) {
+        }
+
+        // Bullets still in flight at the end count with the bounces made so far
+        GameStats& stats = state.stats;
+        for (const Bullet& bullet : state.bullets) {
+            stats.RetireBullet(bullet);
+        }
+
+        uint64_t shots = 0;
+        for (int p = 0; p < state.playerCount; p++) {
+            shots += stats.shotsFired[p];
+        }
+
+        totals.matches++;
+        totals.ticks += reader.TickCount();
+        totals.kills += stats.kills;
+        totals.shots += shots;
+        if (stats.firstKillTick >= 0) {
+            totals.firstKillTicks += (uint64_t)(stats.firstKillTick - (int32_t)reader.StartTick());
+            totals.matchesWithKill++;
+        }
+        for (int b = 0; b <= MAX_BULLET_BOUNCES; b++) {
+            totals.bulletsByBounces[b] += stats.bulletsByBounces[b];
+        }
+
+        if (g_perMatch) {
+            int firstKill = (stats.firstKillTick >= 0) ? stats.firstKillTick - (int32_t)reader.StartTick() : -1;
+            std::lock_guard<std::mutex> lock(g_outputMutex);
+            printf("%s,%u,%d,%u,%d,%u,%llu,%d", path.c_str(), reader.MazeSeed(), reader.PlayerCount(),
+                   reader.TickCount(), state.winner, stats.kills, (unsigned long long)shots, firstKill);
+            for (int b = 0; b <= MAX_BULLET_BOUNCES; b++) {
+                printf(",%u", stats.bulletsByBounces[b]);
+            }
+            printf("\n");
+        }
+        reader.Close();
+    }
+}
+
+static void PrintUsage() {
+    printf("Usage: trouble_replay [--threads N] [--summary] PATH...\n");
+    printf("  PATH         Replay file, or directory searched for *.ttr files\n");
+    printf("  --threads N  Worker threads (default: one per core)\n");
+    printf("  --summary    Only print corpus totals, not one line per match\n");
+}
+
+int main(int argc, char** argv) {
+    int threads = 0;
+    std::vector<char*> paths;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            g_perMatch = false;
+        } else if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        PrintUsage();
+        return 1;
+    }
+    if (threads <= 0) {
+        threads = (int)std::thread::hardware_concurrency();
+        if (threads <= 0) {
+            threads = 1;
+        }
+    }
+
+    if (g_perMatch) {
+        printf("file,seed,players,ticks,winner,kills,shots,first_kill_tick");
+        for (int b = 0; b <= MAX_BULLET_BOUNCES; b++) {
+            printf(",bullets_%d_bounces", b);
+        }
+        printf("\n");
+    }
+
+    ReplayFeed feed(paths.data(), (int)paths.size());
+    std::vector<CorpusTotals> workerTotals(threads);
+    std::vector<std::thread> workers;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread(AnalyzeReplays, std::ref(feed), std::ref(workerTotals[t])));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    CorpusTotals totals;
+    for (const CorpusTotals& worker : workerTotals) {
+        totals.Merge(worker);
+    }
+
+    fprintf(stderr, "matches:         %llu (%llu unreadable)\n",
+            (unsigned long long)totals.matches, (unsigned long long)totals.failed);
+    fprintf(stderr, "workers:         %d\n", threads);
+    fprintf(stderr, "elapsed:         %.3f s\n", seconds);
+    fprintf(stderr, "matches/sec:     %.0f\n", seconds > 0 ? totals.matches / seconds : 0.0);
+    fprintf(stderr, "ticks/sec:       %.0f\n", seconds > 0 ? totals.ticks / seconds : 0.0);
+    fprintf(stderr, "kills:           %llu\n", (unsigned long long)totals.kills);
+    fprintf(stderr, "shots fired:     %llu\n", (unsigned long long)totals.shots);
+    fprintf(stderr, "avg first kill:  %.1f ticks (%llu matches with a kill)\n",
+            totals.matchesWithKill ? (double)totals.firstKillTicks / totals.matchesWithKill : 0.0,
+            (unsigned long long)totals.matchesWithKill);
+    for (int b = 0; b <= MAX_BULLET_BOUNCES; b++) {
+        fprintf(stderr, "bullets, %d bounces: %llu\n", b, (unsigned long long)totals.bulletsByBounces[b]);
+    }
+
+    return totals.failed > 0 ? 2 : 0;
+}
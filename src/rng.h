@@ -0,0 +1,57 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// xoshiro128** pseudo-random generator.
+// Small (16 bytes of state), fast and fully determined by its seed, so every
+// match, room and bot can own one instead of sharing the global rand().
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 1) { Seed(seed); }
+
+    // Expand a 64-bit seed into the full state with splitmix64
+    void Seed(uint64_t seed) {
+        for (int i = 0; i < 4; i++) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            state[i] = (uint32_t)((z ^ (z >> 31)) >> 32);
+        }
+        if ((state[0] | state[1] | state[2] | state[3]) == 0) {
+            state[0] = 1;
+        }
+    }
+
+    uint32_t Next() {
+        uint32_t result = RotateLeft(state[1] * 5, 7) * 9;
+        uint32_t t = state[1] << 9;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = RotateLeft(state[3], 11);
+        return result;
+    }
+
+    // Uniform integer in [0, bound) using a multiply-shift (no division)
+    uint32_t NextBelow(uint32_t bound) {
+        return (uint32_t)(((uint64_t)Next() * bound) >> 32);
+    }
+
+    // Uniform float in [0, 1)
+    float NextFloat() {
+        return (Next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+private:
+    static uint32_t RotateLeft(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    uint32_t state[4];
+};
+
+#endif // RNG_H
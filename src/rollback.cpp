@@ -0,0 +1,136 @@
+#include "rollback.h"
+#include "profiler.h"
+
+RollbackSession::RollbackSession(GameState& state, int localPlayer, int maxRollback)
+    : state(state), maxRollback(maxRollback < 1 ? 1 : maxRollback),
+      snapshots(this->maxRollback + 2), history(INPUT_HISTORY) {
+    // Predictions must never be overwritten by inputs for ticks still ahead
+    if (this->maxRollback > INPUT_HISTORY / 2) {
+        this->maxRollback = INPUT_HISTORY / 2;
+    }
+    Reset(localPlayer);
+}
+
+void RollbackSession::Reset(int player) {
+    localPlayer = player;
+    for (int p = 0; p < MAX_PLAYERS; p++) {
+        confirmedTicks[p] = state.tick;
+        lastConfirmed[p] = 0;
+        held[p].clear();
+    }
+    for (TickInputs& inputs : history) {
+        for (int p = 0; p < MAX_PLAYERS; p++) {
+            inputs.buttons[p] = 0;
+        }
+    }
+    pendingRollback = false;
+    rollbackTick = 0;
+    rollbacks = 0;
+    resimulatedTicks = 0;
+}
+
+bool RollbackSession::CanAdvance() const {
+    for (int p = 0; p < state.playerCount; p++) {
+        if (p != localPlayer && state.tick - confirmedTicks[p] >= (uint32_t)maxRollback) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RollbackSession::AdvanceTick(uint8_t localButtons) {
+    Synchronize();
+
+    uint32_t tick = state.tick;
+    InputsFor(tick).buttons[localPlayer] = localButtons;
+    lastConfirmed[localPlayer] = localButtons;
+    confirmedTicks[localPlayer] = tick + 1;
+
+    Predict(tick);
+    Simulate();
+    ConfirmHeld();
+}
+
+// Is a tick too far ahead for its history slot, which still holds inputs
+// needed for rollback?
+static bool BeyondHistory(uint32_t tick, uint32_t currentTick, int maxRollback) {
+    return tick >= currentTick + (uint32_t)(RollbackSession::INPUT_HISTORY - maxRollback - 1);
+}
+
+void RollbackSession::AddRemoteInput(int player, uint32_t tick, uint8_t buttons) {
+    if (player < 0 || player >= state.playerCount || player == localPlayer) {
+        return;
+    }
+    if (tick != confirmedTicks[player] + (uint32_t)held[player].size()) {
+        return;
+    }
+    if (!held[player].empty() || BeyondHistory(tick, state.tick, maxRollback)) {
+        held[player].push_back(buttons);
+        return;
+    }
+    Confirm(player, buttons);
+}
+
+void RollbackSession::ConfirmHeld() {
+    for (int p = 0; p < state.playerCount; p++) {
+        while (!held[p].empty() && !BeyondHistory(confirmedTicks[p], state.tick, maxRollback)) {
+            Confirm(p, held[p].front());
+            held[p].pop_front();
+        }
+    }
+}
+
+void RollbackSession::Confirm(int player, uint8_t buttons) {
+    uint32_t tick = confirmedTicks[player];
+    TickInputs& inputs = InputsFor(tick);
+    if (tick < state.tick && inputs.buttons[player] != buttons) {
+        // Already simulated with a wrong prediction
+        if (!pendingRollback || tick < rollbackTick) {
+            rollbackTick = tick;
+        }
+        pendingRollback = true;
+    }
+    inputs.buttons[player] = buttons;
+    lastConfirmed[player] = buttons;
+    confirmedTicks[player] = tick + 1;
+}
+
+void RollbackSession::Synchronize() {
+    if (!pendingRollback) {
+        return;
+    }
+    pendingRollback = false;
+    TROUBLE_PROFILE_SCOPE("Rollback");
+
+    uint32_t target = state.tick;
+    if (!snapshots.Restore(rollbackTick, state)) {
+        return; // Outside the window (CanAdvance keeps this from happening) or not saved
+    }
+    rollbacks++;
+    resimulatedTicks += target - rollbackTick;
+
+    // Re-predict unconfirmed ticks from the newest inputs while replaying
+    while (state.tick < target) {
+        Predict(state.tick);
+        Simulate();
+    }
+}
+
+void RollbackSession::Predict(uint32_t tick) {
+    TickInputs& inputs = InputsFor(tick);
+    for (int p = 0; p < state.playerCount; p++) {
+        if (tick >= confirmedTicks[p]) {
+            inputs.buttons[p] = lastConfirmed[p];
+        }
+    }
+}
+
+void RollbackSession::Simulate() {
+    snapshots.Save(state);
+
+    const TickInputs& inputs = InputsFor(state.tick);
+    for (int p = 0; p < state.playerCount; p++) {
+        state.ApplyInput(p, inputs.buttons[p]);
+    }
+    state.Update();
+}
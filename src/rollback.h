@@ -0,0 +1,90 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "game.h"
+#include "snapshot.h"
+
+// Rollback session for peer-to-peer matches.
+// Every peer runs the full simulation and applies its own input immediately.
+// Inputs of remote players that have not arrived yet are predicted by
+// repeating their last confirmed input. A snapshot is saved before every
+// tick; when a remote input arrives that differs from the prediction used for
+// its tick, the next Synchronize() restores that tick's snapshot and
+// re-simulates forward with the corrected inputs. Local play therefore never
+// waits on the network unless the local player gets more than maxRollback
+// ticks ahead of a remote player's confirmed input.
+//
+// Inputs are keyed by GameState::tick, so all peers must start from the same
+// seed and tick (see Reset).
+class RollbackSession {
+public:
+    static const int INPUT_HISTORY = 64;    // Ticks of input kept (power of two)
+
+    RollbackSession(GameState& state, int localPlayer, int maxRollback = 10);
+
+    // Forget all inputs and continue from the state's current tick
+    void Reset(int localPlayer);
+
+    // Is there room to simulate another tick without outrunning the rollback window?
+    bool CanAdvance() const;
+
+    // Apply local input for the current tick, predict the remote players and
+    // simulate one tick (correcting any earlier misprediction first)
+    void AdvanceTick(uint8_t localButtons);
+
+    // Record a remote player's input for a tick. Inputs must arrive in tick
+    // order per player without gaps (UdpConnection delivers them so);
+    // duplicates and gaps are ignored. Inputs too far ahead of the
+    // simulation to fit the input history are held until it catches up.
+    void AddRemoteInput(int player, uint32_t tick, uint8_t buttons);
+
+    // Roll back and re-simulate if a confirmed input contradicted a prediction
+    void Synchronize();
+
+    int LocalPlayer() const { return localPlayer; }
+    int MaxRollback() const { return maxRollback; }
+
+    // First tick whose input from player is not yet known
+    uint32_t ConfirmedTicks(int player) const { return confirmedTicks[player]; }
+
+    uint64_t Rollbacks() const { return rollbacks; }
+    uint64_t ResimulatedTicks() const { return resimulatedTicks; }
+
+private:
+    // Inputs applied (or to be applied) on one tick, confirmed or predicted
+    struct TickInputs {
+        uint8_t buttons[MAX_PLAYERS];
+    };
+
+    TickInputs& InputsFor(uint32_t tick) { return history[tick & (INPUT_HISTORY - 1)]; }
+
+    // Store the next confirmed input of a remote player
+    void Confirm(int player, uint8_t buttons);
+
+    // Confirm held inputs that now fit the history
+    void ConfirmHeld();
+
+    // Fill in predictions for every player whose input for tick is unknown
+    void Predict(uint32_t tick);
+
+    // Save the pre-tick snapshot, apply the tick's inputs and update
+    void Simulate();
+
+    GameState& state;
+    int localPlayer;
+    int maxRollback;
+    SnapshotRing snapshots;
+    std::vector<TickInputs> history;
+    uint32_t confirmedTicks[MAX_PLAYERS];  // Inputs are known for all earlier ticks
+    uint8_t lastConfirmed[MAX_PLAYERS];    // Latest known input, used as the prediction
+    std::deque<uint8_t> held[MAX_PLAYERS]; // Inputs from confirmedTicks on, too far ahead to store yet
+    bool pendingRollback;
+    uint32_t rollbackTick;                 // Earliest mispredicted tick
+    uint64_t rollbacks;
+    uint64_t resimulatedTicks;
+};
+
+#endif // ROLLBACK_H
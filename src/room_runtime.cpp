@@ -0,0 +1,151 @@
+#include "room_runtime.h"
+#include "profiler.h"
+#include <chrono>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+RoomRuntime::RoomRuntime(int workerCount, bool pinThreads)
+    : roundNumber(0), workersRemaining(0), stopping(false) {
+    int hardwareThreads = (int)std::thread::hardware_concurrency();
+    if (hardwareThreads <= 0) {
+        hardwareThreads = 1;
+    }
+    if (workerCount <= 0) {
+        workerCount = hardwareThreads;
+    }
+
+    for (int i = 0; i < workerCount; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (int i = 0; i < workerCount; i++) {
+        workers[i]->thread = std::thread(&RoomRuntime::WorkerMain, this, i);
+
+#if defined(__linux__)
+        // Keep each worker on one core so its home rooms stay in that core's cache
+        if (pinThreads) {
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(i % hardwareThreads, &cpus);
+            pthread_setaffinity_np(workers[i]->thread.native_handle(), sizeof(cpus), &cpus);
+        }
+#else
+        (void)pinThreads;
+#endif
+    }
+}
+
+RoomRuntime::~RoomRuntime() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startRound.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+int RoomRuntime::CreateRoom(int players, unsigned int seed) {
+    int id = (int)rooms.size();
+    rooms.push_back(std::unique_ptr<Room>(new Room(id, players)));
+
+    Room& room = *rooms.back();
+    room.state.Initialize(seed);
+    room.homeWorker = id % (int)workers.size();
+    workers[room.homeWorker]->homeRooms.push_back(&room);
+    return id;
+}
+
+void RoomRuntime::TickAll() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (auto& worker : workers) {
+        worker->cursor.store(0, std::memory_order_relaxed);
+    }
+    workersRemaining = (int)workers.size();
+    roundNumber++;
+    startRound.notify_all();
+    roundDone.wait(lock, [this] { return workersRemaining == 0; });
+}
+
+void RoomRuntime::ClearStats() {
+    for (auto& room : rooms) {
+        room->tickLatency.Clear();
+    }
+    for (auto& worker : workers) {
+        worker->tickLatency.Clear();
+        worker->steals = 0;
+    }
+}
+
+void RoomRuntime::WorkerMain(int index) {
+    uint64_t lastRound = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startRound.wait(lock, [&] { return stopping || roundNumber != lastRound; });
+            if (stopping) {
+                return;
+            }
+            lastRound = roundNumber;
+        }
+
+        RunRound(index);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            workersRemaining--;
+            if (workersRemaining == 0) {
+                roundDone.notify_one();
+            }
+        }
+    }
+}
+
+void RoomRuntime::RunRound(int index) {
+    Worker& self = *workers[index];
+
+    // Home rooms first, in order
+    int count = (int)self.homeRooms.size();
+    while (true) {
+        int next = self.cursor.fetch_add(1, std::memory_order_relaxed);
+        if (next >= count) {
+            break;
+        }
+        TickRoom(*self.homeRooms[next], self);
+    }
+
+    // Then steal from the other workers until every room has been claimed
+    int workerCount = (int)workers.size();
+    for (int offset = 1; offset < workerCount; offset++) {
+        Worker& victim = *workers[(index + offset) % workerCount];
+        int victimCount = (int)victim.homeRooms.size();
+        while (victim.cursor.load(std::memory_order_relaxed) < victimCount) {
+            int next = victim.cursor.fetch_add(1, std::memory_order_relaxed);
+            if (next >= victimCount) {
+                break;
+            }
+            TickRoom(*victim.homeRooms[next], self);
+            self.steals++;
+        }
+    }
+}
+
+void RoomRuntime::TickRoom(Room& room, Worker& worker) {
+    if (!room.active) {
+        return;
+    }
+    TROUBLE_PROFILE_SCOPE("RoomTick");
+    auto start = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < room.state.playerCount; p++) {
+        room.state.ApplyInput(p, room.inputs[p]);
+    }
+    room.state.Update();
+
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    room.tickLatency.Record(ns);
+    worker.tickLatency.Record(ns);
+}
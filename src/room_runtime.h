@@ -0,0 +1,90 @@
+#ifndef ROOM_RUNTIME_H
+#define ROOM_RUNTIME_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "game.h"
+#include "latency_histogram.h"
+
+// One independent match hosted by the runtime
+struct Room {
+    int id;                          // Index in the runtime
+    int homeWorker;                  // Worker that normally ticks this room
+    bool active;                     // Ticked by TickAll(); idle rooms are skipped
+    GameState state;                 // Simulation state, without particles
+    uint8_t inputs[MAX_PLAYERS];     // Input flags applied on the next tick
+    LatencyHistogram tickLatency;    // Duration of each tick of this room
+
+    // Nothing renders a hosted room, so its state keeps no particle ring
+    Room(int roomId, int players) : id(roomId), homeWorker(0), active(true), state(players, 0) {
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            inputs[i] = 0;
+        }
+    }
+};
+
+// Multi-room server runtime.
+// Owns any number of independent rooms and ticks all of them once per
+// TickAll() on a pool of worker threads (one per core by default). Each room
+// is pinned to a home worker, which ticks its rooms in order so their state
+// stays warm in that core's cache. A worker that runs out of home rooms
+// steals unclaimed rooms from other workers, so one slow room cannot hold
+// back a whole round. Rooms are claimed through a per-worker atomic cursor,
+// so owners and thieves never take locks on the hot path.
+//
+// Rooms must only be created, edited or read between calls to TickAll().
+class RoomRuntime {
+public:
+    // workerCount = 0 uses one worker per hardware thread
+    explicit RoomRuntime(int workerCount = 0, bool pinThreads = true);
+    ~RoomRuntime();
+
+    // Add a room; returns its id
+    int CreateRoom(int players, unsigned int seed);
+
+    int RoomCount() const { return (int)rooms.size(); }
+    Room& GetRoom(int id) { return *rooms[id]; }
+    int WorkerCount() const { return (int)workers.size(); }
+
+    // Apply each active room's pending inputs and advance it by one tick
+    void TickAll();
+
+    // Tick latency of every room ticked by a worker, and how many it stole
+    const LatencyHistogram& GetWorkerLatency(int worker) const { return workers[worker]->tickLatency; }
+    uint64_t GetWorkerSteals(int worker) const { return workers[worker]->steals; }
+
+    // Forget recorded latencies for all rooms and workers
+    void ClearStats();
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::vector<Room*> homeRooms;          // Rooms pinned to this worker
+        std::atomic<int> cursor;               // Next unclaimed home room
+        LatencyHistogram tickLatency;          // Every tick this worker ran
+        uint64_t steals;                       // Rooms taken from other workers
+
+        Worker() : cursor(0), steals(0) {}
+    };
+
+    void WorkerMain(int index);
+    void RunRound(int index);
+    static void TickRoom(Room& room, Worker& worker);
+
+    std::vector<std::unique_ptr<Room>> rooms;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex mutex;
+    std::condition_variable startRound;
+    std::condition_variable roundDone;
+    uint64_t roundNumber;                      // Incremented to start a round
+    int workersRemaining;                      // Workers still busy this round
+    bool stopping;
+};
+
+#endif // ROOM_RUNTIME_H
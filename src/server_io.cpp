@@ -0,0 +1,302 @@
+#include "server_io.h"
+#include "packets.h"
+#include <cstring>
+
+// Poller user value of the listener; connections use their id, which
+// starts at 1, so an event for a connection closed earlier in the same
+// batch finds nothing instead of a dangling pointer
+static void* const LISTENER_TAG = nullptr;
+
+static void* ConnectionTag(uint32_t id) {
+    return (void*)(uintptr_t)id;
+}
+
+void ServerCounters::Clear() {
+    accepted.store(0);
+    closed.store(0);
+    framesIn.store(0);
+    framesOut.store(0);
+    bytesIn.store(0);
+    bytesOut.store(0);
+    corrupt.store(0);
+    stalled.store(0);
+    sendsDropped.store(0);
+    eventsDropped.store(0);
+}
+
+// ServerIo methods
+ServerIo::ServerIo()
+    : listener(NET_INVALID_SOCKET), running(false), stopping(false), nextConnectionId(1), dispatching(0),
+      events(new SpscQueue<ServerEvent, SERVER_QUEUE_SIZE>()), sends(new SpscQueue<ServerSend, SERVER_QUEUE_SIZE>()) {
+    dispatcher.Register(PACKET_INPUT, OnInput);
+    dispatcher.Register(PACKET_SNAPSHOT_ACK, OnSnapshotAck);
+    dispatcher.Register(PACKET_DISCONNECT, OnLeave);
+}
+
+ServerIo::~ServerIo() {
+    Stop();
+}
+
+bool ServerIo::Start(uint16_t port) {
+    Stop();
+    listener = OpenTcpListener(port, SERVER_BACKLOG);
+    if (listener == NET_INVALID_SOCKET) {
+        return false;
+    }
+    if (!poller.Valid() || !poller.Add(listener, NET_POLL_READ, LISTENER_TAG)) {
+        CloseSocket(listener);
+        listener = NET_INVALID_SOCKET;
+        return false;
+    }
+
+    while (events->Front() != nullptr) {
+        events->Pop();
+    }
+    counters.Clear();
+    stopping.store(false);
+    running = true;
+    thread = std::thread(&ServerIo::ThreadMain, this);
+    return true;
+}
+
+void ServerIo::Stop() {
+    if (!running) {
+        return;
+    }
+    stopping.store(true);
+    poller.Wake();
+    thread.join();
+
+    poller.Remove(listener);
+    CloseSocket(listener);
+    listener = NET_INVALID_SOCKET;
+    running = false;
+}
+
+bool ServerIo::Send(uint32_t connection, const uint8_t* data, size_t size) {
+    ServerSend* send = running && size <= (size_t)FRAME_MAX_PAYLOAD ? sends->Back() : nullptr;
+    if (send == nullptr) {
+        counters.sendsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    send->connection = connection;
+    send->type = SERVER_SEND_FRAME;
+    send->size = (uint16_t)size;
+    memcpy(send->data, data, size);
+    sends->Push();
+    return true;
+}
+
+bool ServerIo::Close(uint32_t connection) {
+    ServerSend* send = running ? sends->Back() : nullptr;
+    if (send == nullptr) {
+        counters.sendsDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    send->connection = connection;
+    send->type = SERVER_SEND_CLOSE;
+    send->size = 0;
+    sends->Push();
+    return true;
+}
+
+void ServerIo::Flush() {
+    if (running) {
+        poller.Wake();
+    }
+}
+
+bool ServerIo::QueueEvent(const ServerEvent& event, bool mustDeliver) {
+    // Inputs and acks are superseded by the next ones, so they may be
+    // dropped; the simulation must see every connect and disconnect, and it
+    // drains the queue every tick, so those wait for room
+    while (!events->TryPush(event)) {
+        if (!mustDeliver || stopping.load()) {
+            counters.eventsDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+void ServerIo::ThreadMain() {
+    const int MAX_READY = 256;
+    NetPollEvent ready[MAX_READY];
+    while (!stopping.load()) {
+        int count = poller.Wait(ready, MAX_READY, 100);
+        for (int i = 0; i < count; i++) {
+            if (ready[i].user == LISTENER_TAG) {
+                AcceptAll();
+                continue;
+            }
+            auto found = connections.find((uint32_t)(uintptr_t)ready[i].user);
+            if (found == connections.end()) {
+                continue;
+            }
+            Connection& connection = *found->second;
+            if ((ready[i].flags & NET_POLL_WRITE) && !connection.dirty) {
+                connection.dirty = true;
+                dirty.push_back(&connection);
+            }
+            if (ready[i].flags & (NET_POLL_READ | NET_POLL_CLOSED)) {
+                ReadFrom(connection);
+            }
+        }
+        ApplySends();
+        FlushDirty();
+    }
+
+    for (auto& entry : connections) {
+        poller.Remove(entry.second->socket);
+        CloseSocket(entry.second->socket);
+    }
+    connections.clear();
+    dirty.clear();
+    while (sends->Front() != nullptr) {
+        sends->Pop();
+    }
+}
+
+void ServerIo::AcceptAll() {
+    NetAddress from;
+    NetSocket socket;
+    while ((socket = AcceptStream(listener, from)) != NET_INVALID_SOCKET) {
+        uint32_t id = nextConnectionId++;
+        if (nextConnectionId == 0) {
+            nextConnectionId = 1;
+        }
+        if (!poller.Add(socket, NET_POLL_READ, ConnectionTag(id))) {
+            CloseSocket(socket);
+            continue;
+        }
+        connections[id] = std::unique_ptr<Connection>(new Connection(id, socket));
+        counters.accepted.fetch_add(1, std::memory_order_relaxed);
+
+        ServerEvent event = {};
+        event.connection = id;
+        event.type = SERVER_CONNECTED;
+        QueueEvent(event, true);
+    }
+}
+
+void ServerIo::ReadFrom(Connection& connection) {
+    // One recv() normally drains the socket; frames from a client that
+    // keeps sending are handled on the next wakeup, so it cannot starve the
+    // rest
+    int received = connection.reader.Receive(connection.socket);
+    if (received > 0) {
+        counters.bytesIn.fetch_add(received, std::memory_order_relaxed);
+        dispatching = connection.id;
+        int frames = connection.reader.DispatchFrames(dispatcher, this);
+        counters.framesIn.fetch_add(frames, std::memory_order_relaxed);
+    }
+    if (received < 0 || connection.reader.Corrupt()) {
+        if (connection.reader.Corrupt()) {
+            counters.corrupt.fetch_add(1, std::memory_order_relaxed);
+        }
+        CloseConnection(connection);
+    }
+}
+
+void ServerIo::ApplySends() {
+    while (ServerSend* send = sends->Front()) {
+        auto found = connections.find(send->connection);
+        if (found != connections.end()) {
+            Connection& connection = *found->second;
+            if (send->type == SERVER_SEND_CLOSE) {
+                // Whatever was queued before the close still goes out
+                connection.writer.Flush(connection.socket);
+                CloseConnection(connection);
+            } else if (!connection.writer.Append(send->data, send->size)) {
+                counters.stalled.fetch_add(1, std::memory_order_relaxed);
+                CloseConnection(connection);
+            } else {
+                counters.framesOut.fetch_add(1, std::memory_order_relaxed);
+                if (!connection.dirty) {
+                    connection.dirty = true;
+                    dirty.push_back(&connection);
+                }
+            }
+        }
+        sends->Pop();
+    }
+}
+
+void ServerIo::FlushDirty() {
+    for (Connection* connection : dirty) {
+        // Closed after it was marked; its entry is gone from the map
+        if (connection == nullptr) {
+            continue;
+        }
+        connection->dirty = false;
+        size_t before = connection->writer.PendingSize();
+        if (!connection->writer.Flush(connection->socket)) {
+            CloseConnection(*connection);
+            continue;
+        }
+        counters.bytesOut.fetch_add(before - connection->writer.PendingSize(), std::memory_order_relaxed);
+
+        // Only wait for writability while the socket is behind
+        bool behind = connection->writer.PendingSize() > 0;
+        if (behind != connection->waitingToWrite) {
+            connection->waitingToWrite = behind;
+            poller.Modify(connection->socket, NET_POLL_READ | (behind ? NET_POLL_WRITE : 0),
+                          ConnectionTag(connection->id));
+        }
+    }
+    dirty.clear();
+}
+
+void ServerIo::CloseConnection(Connection& connection) {
+    uint32_t id = connection.id;
+    for (Connection*& pending : dirty) {
+        if (pending == &connection) {
+            pending = nullptr;
+        }
+    }
+    poller.Remove(connection.socket);
+    CloseSocket(connection.socket);
+    connections.erase(id);
+    counters.closed.fetch_add(1, std::memory_order_relaxed);
+
+    ServerEvent event = {};
+    event.connection = id;
+    event.type = SERVER_DISCONNECTED;
+    QueueEvent(event, true);
+}
+
+void ServerIo::OnInput(void* context, const uint8_t* data, size_t size) {
+    ServerIo& io = *(ServerIo*)context;
+    BitReader reader(data, size);
+    InputPacket packet;
+    if (ReadPacket(reader, packet)) {
+        ServerEvent event = {};
+        event.connection = io.dispatching;
+        event.type = SERVER_INPUT;
+        event.tick = packet.tick;
+        event.buttons = packet.buttons;
+        io.QueueEvent(event, false);
+    }
+}
+
+void ServerIo::OnSnapshotAck(void* context, const uint8_t* data, size_t size) {
+    ServerIo& io = *(ServerIo*)context;
+    BitReader reader(data, size);
+    SnapshotAckPacket packet;
+    if (ReadPacket(reader, packet)) {
+        ServerEvent event = {};
+        event.connection = io.dispatching;
+        event.type = SERVER_SNAPSHOT_ACK;
+        event.sequence = packet.sequence;
+        io.QueueEvent(event, false);
+    }
+}
+
+void ServerIo::OnLeave(void* context, const uint8_t*, size_t) {
+    ServerIo& io = *(ServerIo*)context;
+    ServerEvent event = {};
+    event.connection = io.dispatching;
+    event.type = SERVER_LEAVE;
+    io.QueueEvent(event, true);
+}
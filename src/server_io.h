@@ -0,0 +1,153 @@
+#ifndef SERVER_IO_H
+#define SERVER_IO_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "framing.h"
+#include "net_poller.h"
+#include "net_socket.h"
+#include "spsc_queue.h"
+
+const int SERVER_QUEUE_SIZE = 8192;                 // Events or sends in flight each way
+const int SERVER_RECEIVE_BUFFER = 16 * 1024;        // Clients only send inputs and acks
+const int SERVER_BACKLOG = 128;
+
+// I/O thread -> simulation
+enum ServerEventType {
+    SERVER_CONNECTED,
+    SERVER_DISCONNECTED,    // Closed by the client, an error, or Close()
+    SERVER_INPUT,           // tick and buttons
+    SERVER_SNAPSHOT_ACK,    // sequence
+    SERVER_LEAVE            // Client sent a DisconnectPacket
+};
+
+struct ServerEvent {
+    uint32_t connection;
+    uint8_t type;
+    uint8_t buttons;
+    uint16_t sequence;
+    uint32_t tick;
+};
+
+// Simulation -> I/O thread
+enum ServerSendType {
+    SERVER_SEND_FRAME,
+    SERVER_SEND_CLOSE
+};
+
+struct ServerSend {
+    uint32_t connection;
+    uint8_t type;
+    uint16_t size;
+    uint8_t data[FRAME_MAX_PAYLOAD];
+};
+
+// Totals since Start(), written by the I/O thread and readable anywhere
+struct ServerCounters {
+    std::atomic<uint64_t> accepted;
+    std::atomic<uint64_t> closed;
+    std::atomic<uint64_t> framesIn;
+    std::atomic<uint64_t> framesOut;
+    std::atomic<uint64_t> bytesIn;
+    std::atomic<uint64_t> bytesOut;
+    std::atomic<uint64_t> corrupt;          // Connections dropped for a bad frame
+    std::atomic<uint64_t> stalled;          // Connections dropped for not reading
+    std::atomic<uint64_t> sendsDropped;     // Simulation found the send queue full
+    std::atomic<uint64_t> eventsDropped;    // Inputs or acks lost to a full event queue
+
+    ServerCounters() { Clear(); }
+    void Clear();
+    uint64_t Open() const { return accepted.load() - closed.load(); }
+};
+
+// Socket side of the dedicated server: one thread that accepts TCP clients
+// and moves framed packets (see framing.h) between them and the simulation.
+// The thread sleeps in a NetPoller (epoll on Linux) on the listener and
+// every connection, reads whatever each ready socket holds in one recv(),
+// decodes every complete frame into a small ServerEvent, and writes queued
+// frames out as far as each socket takes them, waiting for writability only
+// on connections that are behind. The simulation only touches the two SPSC
+// queues, so a slow or vanished client never stalls a tick; a client whose
+// unsent frames pass FRAME_SEND_LIMIT is dropped.
+class ServerIo {
+public:
+    ServerIo();
+    ~ServerIo();
+
+    // Listen on the port (0 picks one) and start the thread
+    bool Start(uint16_t port);
+    void Stop();
+    bool Running() const { return running; }
+    uint16_t Port() const { return running ? LocalPort(listener) : 0; }
+
+    // Simulation side: oldest event, valid until PopEvent()
+    const ServerEvent* PeekEvent() { return events->Front(); }
+    void PopEvent() { events->Pop(); }
+
+    // Simulation side: queue a frame or a close for a connection; false if
+    // the send queue is full. Nothing goes out until Flush().
+    bool Send(uint32_t connection, const uint8_t* data, size_t size);
+    bool Close(uint32_t connection);
+
+    template <typename Packet>
+    bool SendPacket(uint32_t connection, const Packet& packet) {
+        BitWriter writer(FRAME_MAX_PAYLOAD);
+        WritePacket(writer, packet);
+        return Send(connection, writer.Data(), writer.Size());
+    }
+
+    // Have the I/O thread write out everything queued
+    void Flush();
+
+    const ServerCounters& Counters() const { return counters; }
+
+private:
+    struct Connection {
+        uint32_t id;
+        NetSocket socket;
+        FrameReader reader;
+        FrameWriter writer;
+        bool waitingToWrite;        // Polled for writability
+        bool dirty;                 // Has frames queued since the last flush
+
+        Connection(uint32_t connectionId, NetSocket connectionSocket)
+            : id(connectionId), socket(connectionSocket), reader(SERVER_RECEIVE_BUFFER),
+              waitingToWrite(false), dirty(false) {}
+    };
+
+    // I/O thread
+    void ThreadMain();
+    void AcceptAll();
+    void ReadFrom(Connection& connection);
+    void ApplySends();
+    void FlushDirty();
+    void CloseConnection(Connection& connection);
+    bool QueueEvent(const ServerEvent& event, bool mustDeliver);
+
+    static void OnInput(void* context, const uint8_t* data, size_t size);
+    static void OnSnapshotAck(void* context, const uint8_t* data, size_t size);
+    static void OnLeave(void* context, const uint8_t* data, size_t size);
+
+    NetSocket listener;
+    NetPoller poller;
+    std::thread thread;
+    bool running;
+    std::atomic<bool> stopping;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Connection>> connections;
+    std::vector<Connection*> dirty;
+    uint32_t nextConnectionId;
+    uint32_t dispatching;               // Connection whose frames are being dispatched
+    PacketDispatcher dispatcher;
+
+    std::unique_ptr<SpscQueue<ServerEvent, SERVER_QUEUE_SIZE>> events;
+    std::unique_ptr<SpscQueue<ServerSend, SERVER_QUEUE_SIZE>> sends;
+    ServerCounters counters;
+};
+
+#endif // SERVER_IO_H
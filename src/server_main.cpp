@@ -0,0 +1,360 @@
+// TroubleTanks - Headless dedicated server
+// Accepts TCP clients, pairs them into 2-player rooms and runs every room's
+// GameState at a fixed tick rate on a RoomRuntime worker pool, sending each
+// client a delta snapshot per tick (see game_server.h).
+//
+// Usage: trouble_server [--port N] [--tick-rate HZ] [--threads N] [--seed N]
+//                       [--stats S] [--duration S] [--bots N]
+//
+// Every --stats seconds one line reports connections, running rooms, the
+// whole-tick time percentiles over that window, ticks run late to catch up,
+// frame and byte rates, and connections or messages dropped. With --bots the
+// server also starts N scripted TCP clients against itself over loopback,
+// which send an input every tick and decode and ack every snapshot; use it
+// to check how many rooms a box sustains.
+
+#include "fixed_timestep.h"
+#include "framing.h"
+#include "game_server.h"
+#include "net_poller.h"
+#include "rng.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+static volatile std::sig_atomic_t g_stopRequested = 0;
+
+static void RequestStop(int) {
+    g_stopRequested = 1;
+}
+
+static double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+// One scripted client of the load generator
+struct Bot {
+    NetSocket socket;
+    FrameReader reader;
+    FrameWriter writer;
+    SnapshotDeltaDecoder decoder;
+    Rng rng;
+    bool started;           // Room is full and a round is running
+    uint32_t tick;
+    uint8_t buttons;
+    int holdTicks;
+    uint64_t snapshots;
+    uint64_t badSnapshots;
+
+    Bot(NetSocket botSocket, uint64_t seed)
+        : socket(botSocket), reader(SERVER_RECEIVE_BUFFER), rng(seed), started(false), tick(0), buttons(0),
+          holdTicks(0), snapshots(0), badSnapshots(0) {}
+
+    // Wander like the scripted drivers of trouble_sim: hold a direction for
+    // a while and fire now and then
+    uint8_t Drive() {
+        if (holdTicks-- <= 0) {
+            static const uint8_t moves[5] = { 0, INPUT_UP, INPUT_DOWN, INPUT_LEFT, INPUT_RIGHT };
+            buttons = moves[rng.NextBelow(5)];
+            holdTicks = 10 + (int)rng.NextBelow(40);
+        }
+        return (uint8_t)(buttons | (rng.NextBelow(4) == 0 ? INPUT_FIRE : 0));
+    }
+};
+
+static void OnBotJoined(void* context, const uint8_t*, size_t) {
+    Bot& bot = *(Bot*)context;
+    bot.started = false;
+    bot.decoder.Reset();
+}
+
+static void OnBotStart(void* context, const uint8_t*, size_t) {
+    ((Bot*)context)->started = true;
+}
+
+static void OnBotOpponentLeft(void* context, const uint8_t*, size_t) {
+    ((Bot*)context)->started = false;
+}
+
+static void OnBotSnapshot(void* context, const uint8_t* data, size_t size) {
+    static GameStatePacket packet;      // Only the load thread decodes
+    Bot& bot = *(Bot*)context;
+    BitReader reader(data, size);
+    if (!bot.decoder.Decode(reader, packet)) {
+        bot.badSnapshots++;
+        return;
+    }
+    bot.snapshots++;
+    SnapshotAckPacket ack;
+    ack.sequence = bot.decoder.LatestSequence();
+    bot.writer.AppendPacket(ack);
+}
+
+// Runs --bots clients on one thread with its own poller
+class LoadGenerator {
+public:
+    LoadGenerator() : connected(0), snapshots(0), badSnapshots(0), lost(0), stopping(false) {}
+
+    void Start(const NetAddress& server, int count, double tickRate) {
+        thread = std::thread(&LoadGenerator::Run, this, server, count, tickRate);
+    }
+
+    void Stop() {
+        stopping.store(true);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::atomic<int> connected;
+    std::atomic<uint64_t> snapshots;
+    std::atomic<uint64_t> badSnapshots;
+    std::atomic<uint64_t> lost;
+
+private:
+    void Run(NetAddress server, int count, double tickRate) {
+        PacketDispatcher dispatcher;
+        dispatcher.Register(PACKET_JOINED, OnBotJoined);
+        dispatcher.Register(PACKET_START, OnBotStart);
+        dispatcher.Register(PACKET_DISCONNECT, OnBotOpponentLeft);
+        dispatcher.Register(PACKET_SNAPSHOT, OnBotSnapshot);
+
+        NetPoller poller;
+        std::vector<std::unique_ptr<Bot>> bots;
+        for (int i = 0; i < count; i++) {
+            NetSocket socket = ConnectStream(server);
+            if (socket == NET_INVALID_SOCKET) {
+                lost++;
+                continue;
+            }
+            bots.push_back(std::unique_ptr<Bot>(new Bot(socket, i + 1)));
+            poller.Add(socket, NET_POLL_READ, bots.back().get());
+        }
+        connected = (int)bots.size();
+
+        const double period = 1.0 / tickRate;
+        auto start = std::chrono::steady_clock::now();
+        double nextTick = 0;
+        NetPollEvent ready[256];
+        while (!stopping.load()) {
+            double wait = nextTick - Seconds(start);
+            int readyCount = poller.Wait(ready, 256, wait > 0 ? (int)(wait * 1000.0) + 1 : 0);
+            for (int i = 0; i < readyCount; i++) {
+                Bot& bot = *(Bot*)ready[i].user;
+                if (bot.socket == NET_INVALID_SOCKET) {
+                    continue;
+                }
+                int received = bot.reader.Receive(bot.socket);
+                if (received > 0) {
+                    uint64_t before = bot.snapshots, beforeBad = bot.badSnapshots;
+                    bot.reader.DispatchFrames(dispatcher, &bot);
+                    snapshots.fetch_add(bot.snapshots - before, std::memory_order_relaxed);
+                    badSnapshots.fetch_add(bot.badSnapshots - beforeBad, std::memory_order_relaxed);
+                }
+                if (received < 0 || bot.reader.Corrupt()) {
+                    poller.Remove(bot.socket);
+                    CloseSocket(bot.socket);
+                    bot.socket = NET_INVALID_SOCKET;
+                    connected--;
+                    lost++;
+                }
+            }
+
+            bool tickDue = Seconds(start) >= nextTick;
+            if (tickDue) {
+                nextTick += period;
+            }
+            for (auto& bot : bots) {
+                if (bot->socket == NET_INVALID_SOCKET) {
+                    continue;
+                }
+                if (tickDue && bot->started) {
+                    InputPacket input;
+                    input.tick = bot->tick++;
+                    input.buttons = bot->Drive();
+                    bot->writer.AppendPacket(input);
+                }
+                bot->writer.Flush(bot->socket);
+            }
+        }
+
+        for (auto& bot : bots) {
+            if (bot->socket != NET_INVALID_SOCKET) {
+                bot->writer.AppendPacket(DisconnectPacket());
+                bot->writer.Flush(bot->socket);
+                CloseSocket(bot->socket);
+            }
+        }
+        connected = 0;
+    }
+
+    std::thread thread;
+    std::atomic<bool> stopping;
+};
+
+// Counters at the start of a stats window, to report rates
+struct CounterSnapshot {
+    uint64_t framesIn;
+    uint64_t framesOut;
+    uint64_t bytesOut;
+    uint64_t botSnapshots;
+
+    CounterSnapshot(const ServerCounters& counters, const LoadGenerator& bots)
+        : framesIn(counters.framesIn.load()), framesOut(counters.framesOut.load()),
+          bytesOut(counters.bytesOut.load()), botSnapshots(bots.snapshots.load()) {}
+};
+
+static void PrintStats(double elapsed, double window, const GameServer& server, const CounterSnapshot& before,
+                       uint64_t lateTicks, const LoadGenerator& loadGenerator, bool showBots) {
+    const ServerCounters& counters = server.IoCounters();
+    CounterSnapshot now(counters, loadGenerator);
+    const LatencyHistogram& tick = server.TickTime();
+    printf("[%7.1fs] clients %d (%llu opened, %llu closed)  rooms %d/%d  tick p50 %.2f p99 %.2f max %.2f ms, "
+           "%llu late  in %.0f/s out %.0f/s frames, %.0f KB/s  dropped %llu stalled %llu corrupt %llu sends %llu "
+           "events\n",
+           elapsed, server.ClientCount(), (unsigned long long)counters.accepted.load(),
+           (unsigned long long)counters.closed.load(), server.RunningRooms(), server.RoomCount(),
+           tick.Percentile(50) / 1e6, tick.Percentile(99) / 1e6, tick.Max() / 1e6, (unsigned long long)lateTicks,
+           (now.framesIn - before.framesIn) / window, (now.framesOut - before.framesOut) / window,
+           (now.bytesOut - before.bytesOut) / window / 1024.0, (unsigned long long)counters.stalled.load(),
+           (unsigned long long)counters.corrupt.load(), (unsigned long long)counters.sendsDropped.load(),
+           (unsigned long long)counters.eventsDropped.load());
+    if (showBots) {
+        printf("           bots %d connected, %.0f snapshots/s decoded, %llu undecodable, %llu lost\n",
+               loadGenerator.connected.load(), (now.botSnapshots - before.botSnapshots) / window,
+               (unsigned long long)loadGenerator.badSnapshots.load(), (unsigned long long)loadGenerator.lost.load());
+    }
+    fflush(stdout);
+}
+
+static void PrintUsage() {
+    printf("Usage: trouble_server [--port N] [--tick-rate HZ] [--threads N] [--seed N]\n");
+    printf("                      [--stats S] [--duration S] [--bots N]\n");
+    printf("  --port N       TCP port to listen on (default 8888)\n");
+    printf("  --tick-rate HZ Room ticks per second (default 60)\n");
+    printf("  --threads N    Room worker threads (default: one per core)\n");
+    printf("  --seed N       First maze seed (default 1)\n");
+    printf("  --stats S      Seconds between stats lines (default 5)\n");
+    printf("  --duration S   Exit after S seconds (default: run until interrupted)\n");
+    printf("  --bots N       Also run N scripted clients against this server\n");
+}
+
+int main(int argc, char** argv) {
+    int port = 8888;
+    double tickRate = 60.0;
+    int threads = 0;
+    unsigned int seed = 1;
+    double statsInterval = 5.0;
+    double duration = 0;
+    int botCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) {
+            tickRate = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            statsInterval = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            duration = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) {
+            botCount = atoi(argv[++i]);
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (port < 0 || port > 65535 || tickRate <= 0 || statsInterval <= 0) {
+        PrintUsage();
+        return 1;
+    }
+
+    NetStartup();
+    GameServer server(threads, seed);
+    if (!server.Start((uint16_t)port)) {
+        fprintf(stderr, "trouble_server: cannot listen on port %d\n", port);
+        NetCleanup();
+        return 1;
+    }
+    printf("listening on port %u, %.0f ticks/s\n", server.Port(), tickRate);
+    fflush(stdout);
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    LoadGenerator bots;
+    if (botCount > 0) {
+        bots.Start(NetAddress::Loopback(server.Port()), botCount, tickRate);
+    }
+
+    FixedTimestep timestep(tickRate, 4);
+    auto start = std::chrono::steady_clock::now();
+    double nextStats = statsInterval;
+    double windowStart = 0;
+    CounterSnapshot windowCounters(server.IoCounters(), bots);
+    uint64_t lateTicks = 0;
+    uint64_t windowLateTicks = 0;
+    LatencyHistogram totalTickTime;
+
+    while (!g_stopRequested) {
+        double elapsed = Seconds(start);
+        if (duration > 0 && elapsed >= duration) {
+            break;
+        }
+
+        // More than one due tick means the last ones ran late
+        int due = timestep.Advance();
+        if (due > 1) {
+            windowLateTicks += due - 1;
+        }
+        for (int i = 0; i < due; i++) {
+            server.Tick();
+        }
+
+        if (elapsed >= nextStats) {
+            PrintStats(elapsed, elapsed - windowStart, server, windowCounters, windowLateTicks, bots, botCount > 0);
+            totalTickTime.Merge(server.TickTime());
+            server.ClearTickTime();
+            lateTicks += windowLateTicks;
+            windowLateTicks = 0;
+            windowStart = elapsed;
+            windowCounters = CounterSnapshot(server.IoCounters(), bots);
+            nextStats += statsInterval;
+        }
+
+        std::this_thread::sleep_for(std::chrono::duration<double>(timestep.TimeUntilNextTick()));
+    }
+
+    bots.Stop();
+    totalTickTime.Merge(server.TickTime());
+    lateTicks += windowLateTicks;
+    const ServerCounters& counters = server.IoCounters();
+    printf("\nticks:        %llu (%llu late)\n", (unsigned long long)server.Ticks(), (unsigned long long)lateTicks);
+    printf("tick time:    p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms of %.2f ms\n", totalTickTime.Percentile(50) / 1e6,
+           totalTickTime.Percentile(90) / 1e6, totalTickTime.Percentile(99) / 1e6, totalTickTime.Max() / 1e6,
+           1000.0 / tickRate);
+    printf("connections:  %llu opened, %llu closed, %llu stalled, %llu corrupt\n",
+           (unsigned long long)counters.accepted.load(), (unsigned long long)counters.closed.load(),
+           (unsigned long long)counters.stalled.load(), (unsigned long long)counters.corrupt.load());
+    printf("rooms:        %d created, %llu rounds started, %llu snapshots too large to send\n", server.RoomCount(),
+           (unsigned long long)server.RoundsStarted(), (unsigned long long)server.OversizedSnapshots());
+    printf("frames:       %llu in, %llu out, %.1f MB out\n", (unsigned long long)counters.framesIn.load(),
+           (unsigned long long)counters.framesOut.load(), counters.bytesOut.load() / 1048576.0);
+    if (botCount > 0) {
+        printf("bots:         %llu snapshots decoded, %llu undecodable, %llu connections lost\n",
+               (unsigned long long)bots.snapshots.load(), (unsigned long long)bots.badSnapshots.load(),
+               (unsigned long long)bots.lost.load());
+    }
+
+    server.Stop();
+    NetCleanup();
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "shot_solver.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SHOT_SOLVER_SSE2 1
+#endif
+
+ShotTarget ShotTarget::FromTank(const Tank& tank) {
+    ShotTarget target;
+    target.x = tank.x;
+    target.y = tank.y;
+    target.width = (float)TANK_WIDTH;
+    target.height = (float)TANK_HEIGHT;
+    target.velocityX = tank.velocityX;
+    target.velocityY = tank.velocityY;
+    return target;
+}
+
+ShotSolver::ShotSolver(int count) {
+    liveLanes = 0;
+    angleCount = (count < 8) ? 8 : (count + 7) & ~7;
+    dirX.resize(angleCount);
+    dirY.resize(angleCount);
+    for (int i = 0; i < angleCount; i++) {
+        float angle = 6.2831853f * i / angleCount;
+        dirX[i] = cosf(angle);
+        dirY[i] = sinf(angle);
+    }
+    x.resize(angleCount);
+    y.resize(angleCount);
+    vx.resize(angleCount);
+    vy.resize(angleCount);
+    cellX.resize(angleCount);
+    cellY.resize(angleCount);
+    alive.resize(angleCount);
+    bounces.resize(angleCount);
+    hit.resize(angleCount);
+}
+
+void ShotSolver::SweepLane(const GameState& state, int lane) {
+    // Same steps as GameState::MoveBullet, minus the effects
+    float remaining = 1.0f;
+    while (remaining > 0.0f) {
+        float dx = vx[lane] * remaining;
+        float dy = vy[lane] * remaining;
+
+        WallHit wall;
+        if (!state.RaycastWalls(x[lane], y[lane], dx, dy, wall)) {
+            x[lane] += dx;
+            y[lane] += dy;
+            break;
+        }
+
+        x[lane] += dx * wall.t + wall.normalX * WALL_HIT_EPSILON;
+        y[lane] += dy * wall.t + wall.normalY * WALL_HIT_EPSILON;
+        if (wall.normalX != 0) {
+            vx[lane] = -vx[lane] * 0.8f;
+        } else {
+            vy[lane] = -vy[lane] * 0.8f;
+        }
+
+        if (++bounces[lane] >= MAX_BULLET_BOUNCES) {
+            alive[lane] = 0;
+            liveLanes--;
+            vx[lane] = 0;
+            vy[lane] = 0;
+            return;
+        }
+        remaining *= 1.0f - wall.t;
+    }
+    cellX[lane] = (int32_t)floorf(x[lane] / WALL_SIZE);
+    cellY[lane] = (int32_t)floorf(y[lane] / WALL_SIZE);
+}
+
+ShotPlan ShotSolver::Solve(const GameState& state, float startX, float startY, const ShotTarget& target) {
+    ShotPlan plan;
+    plan.found = false;
+    plan.angle = 0;
+    plan.ticks = 0;
+    plan.bounces = 0;
+
+    // A bullet fired from inside a wall dies at once
+    int startCellX = (int)floorf(startX / WALL_SIZE);
+    int startCellY = (int)floorf(startY / WALL_SIZE);
+    if (state.IsWall(startCellX, startCellY)) {
+        return plan;
+    }
+
+    for (int i = 0; i < angleCount; i++) {
+        x[i] = startX;
+        y[i] = startY;
+        vx[i] = dirX[i] * BULLET_SPEED;
+        vy[i] = dirY[i] * BULLET_SPEED;
+        cellX[i] = startCellX;
+        cellY[i] = startCellY;
+        alive[i] = -1;
+        bounces[i] = 0;
+    }
+    liveLanes = angleCount;
+
+    float targetX = target.x;
+    float targetY = target.y;
+    float targetVelX = target.velocityX;
+    float targetVelY = target.velocityY;
+
+    // A bullet is hit-tested after each move while its lifetime lasts
+    for (int tick = 1; tick < BULLET_LIFETIME && liveLanes > 0; tick++) {
+        // Tanks move before bullets within a tick (see Tank::Update)
+        targetX += targetVelX;
+        targetY += targetVelY;
+        targetVelX *= 0.9f;
+        targetVelY *= 0.9f;
+        targetX = fminf(fmaxf(targetX, 0.0f), GameState::ArenaType::WIDTH - target.width);
+        targetY = fminf(fmaxf(targetY, 0.0f), GameState::ArenaType::HEIGHT - target.height);
+        const float x0 = targetX, x1 = targetX + target.width;
+        const float y0 = targetY, y1 = targetY + target.height;
+
+        bool anyHit = false;
+        int i = 0;
+
+#if defined(__AVX2__)
+        const __m256 inv = _mm256_set1_ps(1.0f / WALL_SIZE);
+        const __m256 bx0 = _mm256_set1_ps(x0), bx1 = _mm256_set1_ps(x1);
+        const __m256 by0 = _mm256_set1_ps(y0), by1 = _mm256_set1_ps(y1);
+        for (; i + 8 <= angleCount; i += 8) {
+            __m256 nx = _mm256_add_ps(_mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&vx[i]));
+            __m256 ny = _mm256_add_ps(_mm256_loadu_ps(&y[i]), _mm256_loadu_ps(&vy[i]));
+            __m256i live = _mm256_loadu_si256((const __m256i*)&alive[i]);
+
+            // Positions are never negative inside a walled maze, so truncation is floor
+            __m256i cx = _mm256_cvttps_epi32(_mm256_mul_ps(nx, inv));
+            __m256i cy = _mm256_cvttps_epi32(_mm256_mul_ps(ny, inv));
+            __m256i same = _mm256_and_si256(_mm256_cmpeq_epi32(cx, _mm256_loadu_si256((const __m256i*)&cellX[i])),
+                                            _mm256_cmpeq_epi32(cy, _mm256_loadu_si256((const __m256i*)&cellY[i])));
+            __m256 stay = _mm256_castsi256_ps(_mm256_and_si256(same, live));
+            int sweep = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(same, live)));
+
+            _mm256_storeu_ps(&x[i], _mm256_blendv_ps(_mm256_loadu_ps(&x[i]), nx, stay));
+            _mm256_storeu_ps(&y[i], _mm256_blendv_ps(_mm256_loadu_ps(&y[i]), ny, stay));
+
+            __m256 inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(nx, bx0, _CMP_GE_OQ), _mm256_cmp_ps(nx, bx1, _CMP_LE_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(ny, by0, _CMP_GE_OQ), _mm256_cmp_ps(ny, by1, _CMP_LE_OQ)));
+            int hits = _mm256_movemask_ps(_mm256_and_ps(inside, stay));
+            for (int lane = 0; lane < 8; lane++) {
+                hit[i + lane] = (uint8_t)((hits >> lane) & 1);
+            }
+            anyHit |= hits != 0;
+
+            // Lanes entering another cell take the exact sweep
+            while (sweep) {
+                int lane = i + LowestSetBit((uint64_t)sweep);
+                sweep &= sweep - 1;
+                SweepLane(state, lane);
+                if (alive[lane] && x[lane] >= x0 && x[lane] <= x1 && y[lane] >= y0 && y[lane] <= y1) {
+                    hit[lane] = 1;
+                    anyHit = true;
+                }
+            }
+        }
+#elif defined(SHOT_SOLVER_SSE2)
+        const __m128 inv = _mm_set1_ps(1.0f / WALL_SIZE);
+        const __m128 bx0 = _mm_set1_ps(x0), bx1 = _mm_set1_ps(x1);
+        const __m128 by0 = _mm_set1_ps(y0), by1 = _mm_set1_ps(y1);
+        for (; i + 4 <= angleCount; i += 4) {
+            __m128 px = _mm_loadu_ps(&x[i]);
+            __m128 py = _mm_loadu_ps(&y[i]);
+            __m128 nx = _mm_add_ps(px, _mm_loadu_ps(&vx[i]));
+            __m128 ny = _mm_add_ps(py, _mm_loadu_ps(&vy[i]));
+            __m128i live = _mm_loadu_si128((const __m128i*)&alive[i]);
+
+            // Positions are never negative inside a walled maze, so truncation is floor
+            __m128i cx = _mm_cvttps_epi32(_mm_mul_ps(nx, inv));
+            __m128i cy = _mm_cvttps_epi32(_mm_mul_ps(ny, inv));
+            __m128i same = _mm_and_si128(_mm_cmpeq_epi32(cx, _mm_loadu_si128((const __m128i*)&cellX[i])),
+                                         _mm_cmpeq_epi32(cy, _mm_loadu_si128((const __m128i*)&cellY[i])));
+            __m128 stay = _mm_castsi128_ps(_mm_and_si128(same, live));
+            int sweep = _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(same, live)));
+
+            _mm_storeu_ps(&x[i], _mm_or_ps(_mm_and_ps(stay, nx), _mm_andnot_ps(stay, px)));
+            _mm_storeu_ps(&y[i], _mm_or_ps(_mm_and_ps(stay, ny), _mm_andnot_ps(stay, py)));
+
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(nx, bx0), _mm_cmple_ps(nx, bx1)),
+                                       _mm_and_ps(_mm_cmpge_ps(ny, by0), _mm_cmple_ps(ny, by1)));
+            int hits = _mm_movemask_ps(_mm_and_ps(inside, stay));
+            for (int lane = 0; lane < 4; lane++) {
+                hit[i + lane] = (uint8_t)((hits >> lane) & 1);
+            }
+            anyHit |= hits != 0;
+
+            // Lanes entering another cell take the exact sweep
+            while (sweep) {
+                int lane = i + LowestSetBit((uint64_t)sweep);
+                sweep &= sweep - 1;
+                SweepLane(state, lane);
+                if (alive[lane] && x[lane] >= x0 && x[lane] <= x1 && y[lane] >= y0 && y[lane] <= y1) {
+                    hit[lane] = 1;
+                    anyHit = true;
+                }
+            }
+        }
+#endif
+
+        // Scalar fallback
+        for (; i < angleCount; i++) {
+            hit[i] = 0;
+            if (!alive[i]) {
+                continue;
+            }
+            float nx = x[i] + vx[i];
+            float ny = y[i] + vy[i];
+            if ((int32_t)floorf(nx / WALL_SIZE) == cellX[i] && (int32_t)floorf(ny / WALL_SIZE) == cellY[i]) {
+                x[i] = nx;
+                y[i] = ny;
+            } else {
+                SweepLane(state, i);
+                if (!alive[i]) {
+                    continue;
+                }
+            }
+            if (x[i] >= x0 && x[i] <= x1 && y[i] >= y0 && y[i] <= y1) {
+                hit[i] = 1;
+                anyHit = true;
+            }
+        }
+
+        if (!anyHit) {
+            continue;
+        }
+
+        // Fewest bounces among the lanes that hit first
+        int fewest = MAX_BULLET_BOUNCES;
+        for (int lane = 0; lane < angleCount; lane++) {
+            if (hit[lane] && bounces[lane] < fewest) {
+                fewest = bounces[lane];
+            }
+        }
+        for (int lane = 0; lane < angleCount; lane++) {
+            hit[lane] = hit[lane] && bounces[lane] == fewest;
+        }
+
+        // Longest run of neighboring hitting angles (wrapping around), aimed at its middle
+        int first = 0;
+        while (first < angleCount && hit[first]) {
+            first++;
+        }
+        int bestStart = 0, bestLength = angleCount;
+        if (first < angleCount) {
+            bestLength = 0;
+            int runStart = 0, runLength = 0;
+            for (int n = 1; n <= angleCount; n++) {
+                int lane = (first + n) % angleCount;
+                if (hit[lane]) {
+                    if (runLength++ == 0) {
+                        runStart = lane;
+                    }
+                } else {
+                    if (runLength > bestLength) {
+                        bestStart = runStart;
+                        bestLength = runLength;
+                    }
+                    runLength = 0;
+                }
+            }
+        }
+
+        float middle = bestStart + (bestLength - 1) * 0.5f;
+        plan.found = true;
+        plan.angle = 6.2831853f * fmodf(middle, (float)angleCount) / angleCount;
+        plan.ticks = tick;
+        plan.bounces = fewest;
+        return plan;
+    }
+    return plan;
+}
+
+ShotPlan ShotSolver::SolveTanks(const GameState& state, int shooter, int target) {
+    if (shooter < 0 || shooter >= state.playerCount || target < 0 || target >= state.playerCount ||
+        shooter == target || !state.tanks[shooter].alive || !state.tanks[target].alive) {
+        ShotPlan none;
+        none.found = false;
+        none.angle = 0;
+        none.ticks = 0;
+        none.bounces = 0;
+        return none;
+    }
+    const Tank& tank = state.tanks[shooter];
+    return Solve(state, tank.x + TANK_WIDTH / 2.0f, tank.y + TANK_HEIGHT / 2.0f,
+                 ShotTarget::FromTank(state.tanks[target]));
+}
@@ -0,0 +1,71 @@
+#ifndef SHOT_SOLVER_H
+#define SHOT_SOLVER_H
+
+#include <cstdint>
+#include <vector>
+#include "game.h"
+
+// Box a shot has to enter, e.g. a tank, with the velocity it coasts at
+struct ShotTarget {
+    float x, y;                 // Top-left corner
+    float width, height;
+    float velocityX, velocityY; // Decays by tank friction every tick
+
+    // Target an alive tank as it will coast without further input
+    static ShotTarget FromTank(const Tank& tank);
+};
+
+// Best firing solution found by ShotSolver
+struct ShotPlan {
+    bool found;           // Did any candidate angle hit within the bullet lifetime?
+    float angle;          // Firing angle in radians, as Tank::rotation
+    int ticks;            // Ticks from firing until the bullet reaches the target
+    int bounces;          // Wall bounces on the way
+};
+
+// Ricochet-aware shot planning for bots.
+// Fires a fan of candidate angles at once as a structure-of-arrays batch of
+// virtual bullets and steps them tick by tick with the same movement,
+// reflection and 0.8 energy loss as GameState::MoveBullet, up to
+// MAX_BULLET_BOUNCES and the bullet lifetime. Bullets move less than a cell
+// per tick, so most steps stay inside one cell: those lanes are advanced and
+// hit-tested with SSE2/AVX2 kernels, and only lanes that cross into another
+// cell fall back to the scalar grid sweep. The search stops on the first tick
+// any lane hits, so the answer is the fastest shot (or once every lane has
+// used up its bounces). Among the lanes hitting on that tick the one with the
+// fewest bounces wins, aimed at the middle of its run of neighboring hitting
+// angles so small aim errors still land.
+//
+// Other tanks in the way are not considered. A solver keeps its lane arrays
+// between calls, so give every thread its own.
+class ShotSolver {
+public:
+    static const int DEFAULT_ANGLES = 256;
+
+    // Constructor; angleCount is rounded up to a multiple of 8
+    explicit ShotSolver(int angleCount = DEFAULT_ANGLES);
+
+    // Search angles for a bullet fired from (x, y) toward the target
+    ShotPlan Solve(const GameState& state, float x, float y, const ShotTarget& target);
+
+    // Search angles for player shooter's tank firing at player target's tank
+    ShotPlan SolveTanks(const GameState& state, int shooter, int target);
+
+    int AngleCount() const { return angleCount; }
+
+private:
+    // Sweep one lane across a cell boundary the way MoveBullet does
+    void SweepLane(const GameState& state, int lane);
+
+    int angleCount;
+    std::vector<float> dirX, dirY;         // Unit direction of every candidate angle
+    std::vector<float> x, y;               // Lane positions
+    std::vector<float> vx, vy;             // Lane velocities
+    std::vector<int32_t> cellX, cellY;     // Cell each lane is in
+    std::vector<int32_t> alive;            // -1 while the lane's bullet is live, else 0
+    std::vector<int32_t> bounces;
+    std::vector<uint8_t> hit;              // Lanes that hit on the current tick
+    int liveLanes;                         // Lanes whose bullet has not expired
+};
+
+#endif // SHOT_SOLVER_H
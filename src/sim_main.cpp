@@ -0,0 +1,268 @@
+// TroubleTanks - Headless match runner
+// Runs batches of seeded matches through GameState with scripted inputs and
+// no rendering, as fast as the CPU allows, and reports simulation throughput.
+//
+// Usage: trouble_sim [--matches N] [--ticks N] [--seed N] [--players N] [--record DIR]
+//        trouble_sim --rooms N [--threads N] [--ticks N] [--seed N] [--players N]
+//
+// With --rooms the matches run concurrently as rooms of a RoomRuntime, and
+// per-core and per-room tick latency percentiles are reported. With --record
+// every match is written to DIR as a replay file (see replay.h). With --trace
+// the profiler's events are written as Chrome trace JSON when the profiler
+// is compiled in (TROUBLE_ENABLE_PROFILER).
+
+#include "game.h"
+#include "profiler.h"
+#include "replay.h"
+#include "room_runtime.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Scripted driver for one tank: holds a direction for a while, then picks a
+// new one from its own LCG so runs are reproducible for a given seed.
+struct ScriptedDriver {
+    unsigned int state;
+    int direction;
+    int holdTicks;
+
+    ScriptedDriver(unsigned int seed = 1) : state(seed), direction(0), holdTicks(0) {}
+
+    unsigned int Next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 16;
+    }
+
+    // Produce this tick's InputButton flags
+    uint8_t Drive() {
+        if (holdTicks <= 0) {
+            direction = Next() % 5; // 0 = idle, 1-4 = up/down/left/right
+            holdTicks = 10 + Next() % 40;
+        }
+        holdTicks--;
+
+        static const uint8_t moves[5] = { 0, INPUT_UP, INPUT_DOWN, INPUT_LEFT, INPUT_RIGHT };
+        uint8_t buttons = moves[direction];
+        if (Next() % 4 == 0) {
+            buttons |= INPUT_FIRE;
+        }
+        return buttons;
+    }
+};
+
+// Tick rooms concurrently on the runtime's worker pool
+static int RunRooms(int roomCount, int threads, int ticks, unsigned int baseSeed, int players) {
+    RoomRuntime runtime(threads);
+    std::vector<ScriptedDriver> drivers;
+    unsigned int nextSeed = baseSeed;
+
+    for (int r = 0; r < roomCount; r++) {
+        runtime.CreateRoom(players, nextSeed);
+        for (int p = 0; p < players; p++) {
+            drivers.push_back(ScriptedDriver(nextSeed * MAX_PLAYERS + p + 1));
+        }
+        nextSeed++;
+    }
+    players = runtime.GetRoom(0).state.playerCount;
+
+    long long finishedMatches = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int tick = 0; tick < ticks; tick++) {
+        for (int r = 0; r < roomCount; r++) {
+            Room& room = runtime.GetRoom(r);
+
+            // Start a fresh match in rooms whose match has ended
+            if (room.state.gameOver) {
+                room.state.Initialize(nextSeed++);
+                room.state.particles.Clear();
+                finishedMatches++;
+            }
+            for (int p = 0; p < players; p++) {
+                room.inputs[p] = drivers[r * players + p].Drive();
+            }
+        }
+        runtime.TickAll();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    long long totalTicks = (long long)roomCount * ticks;
+
+    printf("rooms:            %d\n", roomCount);
+    printf("workers:          %d\n", runtime.WorkerCount());
+    printf("players:          %d\n", players);
+    printf("rounds:           %d\n", ticks);
+    printf("finished matches: %lld\n", finishedMatches);
+    printf("elapsed:          %.3f s\n", seconds);
+    printf("room ticks/sec:   %.0f\n", seconds > 0 ? totalTicks / seconds : 0.0);
+
+    printf("\nper-core tick latency (ns):\n");
+    printf("  core      ticks      p50      p90      p99      max   steals\n");
+    for (int w = 0; w < runtime.WorkerCount(); w++) {
+        const LatencyHistogram& h = runtime.GetWorkerLatency(w);
+        printf("  %4d %10llu %8llu %8llu %8llu %8llu %8llu\n", w,
+               (unsigned long long)h.Count(),
+               (unsigned long long)h.Percentile(50), (unsigned long long)h.Percentile(90),
+               (unsigned long long)h.Percentile(99), (unsigned long long)h.Max(),
+               (unsigned long long)runtime.GetWorkerSteals(w));
+    }
+
+    // Summarize the per-room distributions by their p50 and p99
+    std::vector<uint64_t> roomP50, roomP99;
+    for (int r = 0; r < roomCount; r++) {
+        roomP50.push_back(runtime.GetRoom(r).tickLatency.Percentile(50));
+        roomP99.push_back(runtime.GetRoom(r).tickLatency.Percentile(99));
+    }
+    std::sort(roomP50.begin(), roomP50.end());
+    std::sort(roomP99.begin(), roomP99.end());
+    printf("\nper-room tick latency (ns):\n");
+    printf("  median room p50: %llu\n", (unsigned long long)roomP50[roomCount / 2]);
+    printf("  median room p99: %llu\n", (unsigned long long)roomP99[roomCount / 2]);
+    printf("  worst room p99:  %llu\n", (unsigned long long)roomP99[roomCount - 1]);
+
+    return 0;
+}
+
+// Run matches one after another on this thread
+static int RunMatches(int matchCount, int maxTicks, unsigned int baseSeed, int players, const char* recordDir) {
+    long long totalTicks = 0;
+    int wins[MAX_PLAYERS + 1] = { 0 }; // [0] = ties, [n] = player n
+    int unfinished = 0;
+
+    GameState state(players);
+    players = state.playerCount;
+    ScriptedDriver drivers[MAX_PLAYERS];
+    uint8_t buttons[MAX_PLAYERS];
+    ReplayWriter recorder;
+    long long recordedBytes = 0;
+    int recordFailures = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int match = 0; match < matchCount; match++) {
+        unsigned int seed = baseSeed + (unsigned int)match;
+        state.Initialize(seed);
+        state.particles.Clear();
+
+        for (int p = 0; p < players; p++) {
+            drivers[p] = ScriptedDriver(seed * MAX_PLAYERS + p + 1);
+        }
+
+        if (recordDir) {
+            recorder.Begin(state);
+        }
+
+        int tick = 0;
+        for (; tick < maxTicks && !state.gameOver; tick++) {
+            for (int p = 0; p < players; p++) {
+                buttons[p] = drivers[p].Drive();
+            }
+            if (recordDir) {
+                recorder.RecordTick(state, buttons);
+            }
+            for (int p = 0; p < players; p++) {
+                state.ApplyInput(p, buttons[p]);
+            }
+            state.Update();
+        }
+        totalTicks += tick;
+
+        if (recordDir) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s/match_%u.ttr", recordDir, seed);
+            recordedBytes += (long long)recorder.EncodedSize();
+            if (!recorder.Save(path)) {
+                recordFailures++;
+            }
+        }
+
+        if (state.gameOver && state.winner >= 0 && state.winner <= players) {
+            wins[state.winner]++;
+        } else {
+            unfinished++;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    printf("matches:       %d\n", matchCount);
+    printf("total ticks:   %lld\n", totalTicks);
+    printf("elapsed:       %.3f s\n", seconds);
+    printf("ticks/sec:     %.0f\n", seconds > 0 ? totalTicks / seconds : 0.0);
+    printf("players:       %d\n", players);
+    for (int p = 1; p <= players; p++) {
+        printf("player %-2d wins: %d\n", p, wins[p]);
+    }
+    printf("ties:          %d\n", wins[0]);
+    printf("unfinished:    %d\n", unfinished);
+    if (recordDir) {
+        printf("recorded:      %d matches, %.1f KB avg, %d failed\n", matchCount - recordFailures,
+               matchCount > 0 ? recordedBytes / 1024.0 / matchCount : 0.0, recordFailures);
+    }
+
+    return 0;
+}
+
+static void PrintUsage() {
+    printf("Usage: trouble_sim [--matches N] [--ticks N] [--seed N] [--players N] [--record DIR]\n");
+    printf("       trouble_sim --rooms N [--threads N] [--ticks N] [--seed N] [--players N]\n");
+    printf("  --matches N  Number of matches to run (default 1000)\n");
+    printf("  --ticks N    Maximum ticks per match (default 3000)\n");
+    printf("  --seed N     Base seed; match i uses seed + i (default 1)\n");
+    printf("  --players N  Players per match, 1-%d (default 2)\n", MAX_PLAYERS);
+    printf("  --rooms N    Run N concurrent rooms for --ticks rounds instead\n");
+    printf("  --threads N  Worker threads for --rooms (default: one per core)\n");
+    printf("  --record DIR Write each match to DIR/match_<seed>.ttr\n");
+    printf("  --trace FILE Write profiler events as Chrome trace JSON\n");
+}
+
+int main(int argc, char** argv) {
+    int matchCount = 1000;
+    int maxTicks = 3000;
+    unsigned int baseSeed = 1;
+    int players = 2;
+    int roomCount = 0;
+    int threads = 0;
+    const char* recordDir = nullptr;
+    const char* tracePath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--matches") == 0 && i + 1 < argc) {
+            matchCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            maxTicks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            baseSeed = (unsigned int)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            players = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rooms") == 0 && i + 1 < argc) {
+            roomCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordDir = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracePath = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (tracePath && !ProfilerEnabled()) {
+        fprintf(stderr, "trouble_sim: --trace needs a build with TROUBLE_ENABLE_PROFILER\n");
+        return 1;
+    }
+
+    int result = (roomCount > 0) ? RunRooms(roomCount, threads, maxTicks, baseSeed, players)
+                                 : RunMatches(matchCount, maxTicks, baseSeed, players, recordDir);
+    if (tracePath && !WriteProfilerTrace(tracePath)) {
+        fprintf(stderr, "trouble_sim: cannot write %s\n", tracePath);
+        return 1;
+    }
+    return result;
+}
@@ -0,0 +1,95 @@
+#include "snapshot.h"
+#include <cstring>
+
+template <typename ArenaT>
+bool BasicGameState<ArenaT>::SaveSnapshot(GameSnapshot& snapshot) const {
+    snapshot.tick = tick;
+    snapshot.mazeSeed = mazeSeed;
+    snapshot.playerCount = playerCount;
+    snapshot.winner = winner;
+    snapshot.gameOver = gameOver ? 1 : 0;
+    snapshot.gameRunning = gameRunning ? 1 : 0;
+    snapshot.padding[0] = 0;
+    snapshot.padding[1] = 0;
+    memcpy(snapshot.scores, scores, sizeof(scores[0]) * playerCount);
+    memcpy(snapshot.tanks, tanks, sizeof(Tank) * playerCount);
+
+    // Only a pool built larger than the default can hold more bullets
+    int count = bullets.Count();
+    bool fits = count <= SNAPSHOT_MAX_BULLETS;
+    if (!fits) {
+        count = SNAPSHOT_MAX_BULLETS;
+    }
+    snapshot.bulletCount = count;
+    memcpy(snapshot.bullets, bullets.begin(), sizeof(Bullet) * count);
+    return fits;
+}
+
+template <typename ArenaT>
+void BasicGameState<ArenaT>::RestoreSnapshot(const GameSnapshot& snapshot) {
+    // Same match unless the seed differs; regenerate the maze only then
+    if (snapshot.mazeSeed != mazeSeed) {
+        mazeSeed = snapshot.mazeSeed;
+        GenerateMaze(maze, mazeSeed, mazeGenerator);
+        CopyWalls();
+    }
+
+    tick = snapshot.tick;
+    playerCount = snapshot.playerCount;
+    winner = snapshot.winner;
+    gameOver = snapshot.gameOver != 0;
+    gameRunning = snapshot.gameRunning != 0;
+    memcpy(scores, snapshot.scores, sizeof(scores[0]) * playerCount);
+    memcpy(tanks, snapshot.tanks, sizeof(Tank) * playerCount);
+
+    bullets.Assign(snapshot.bullets, snapshot.bulletCount);
+
+    // The broadphase is derived from tank positions
+    RebuildTankHash();
+}
+
+// Snapshot methods for the arenas instantiated in game.cpp
+template bool BasicGameState<StandardArena>::SaveSnapshot(GameSnapshot& snapshot) const;
+template void BasicGameState<StandardArena>::RestoreSnapshot(const GameSnapshot& snapshot);
+template bool BasicGameState<LargeArena>::SaveSnapshot(GameSnapshot& snapshot) const;
+template void BasicGameState<LargeArena>::RestoreSnapshot(const GameSnapshot& snapshot);
+template bool BasicGameState<HugeArena>::SaveSnapshot(GameSnapshot& snapshot) const;
+template void BasicGameState<HugeArena>::RestoreSnapshot(const GameSnapshot& snapshot);
+
+SnapshotRing::SnapshotRing(int capacity) : overflowedSaves(0) {
+    int size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mask = size - 1;
+    slots.resize(size);
+    valid.assign(size, 0);
+}
+
+bool SnapshotRing::Save(const GameState& state) {
+    int slot = (int)(state.tick & (uint32_t)mask);
+    if (!state.SaveSnapshot(slots[slot])) {
+        valid[slot] = 0;
+        overflowedSaves++;
+        return false;
+    }
+    valid[slot] = 1;
+    return true;
+}
+
+const GameSnapshot* SnapshotRing::Find(uint32_t tick) const {
+    int slot = (int)(tick & (uint32_t)mask);
+    if (!valid[slot] || slots[slot].tick != tick) {
+        return nullptr;
+    }
+    return &slots[slot];
+}
+
+bool SnapshotRing::Restore(uint32_t tick, GameState& state) const {
+    const GameSnapshot* snapshot = Find(tick);
+    if (!snapshot) {
+        return false;
+    }
+    state.RestoreSnapshot(*snapshot);
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "game.h"
+
+// A snapshot holds as many bullets as a default BulletPool, so a state that
+// is restored and re-simulated never loses one
+const int SNAPSHOT_MAX_BULLETS = BulletPool::DEFAULT_CAPACITY;
+
+// Flat copy of everything GameState::Update reads and writes.
+// The maze is not stored (it is fixed for a match and identified by its seed)
+// and neither are particles (purely cosmetic). Entity arrays have fixed
+// capacity and no pointers, so a snapshot can be copied with one memcpy,
+// kept in preallocated rings, or written straight to disk. Only the first
+// playerCount scores and tanks and bulletCount bullets are saved and
+// restored; the rest of the arrays is left as it was.
+struct GameSnapshot {
+    uint32_t tick;                           // GameState::tick when saved
+    uint32_t mazeSeed;                       // Maze the state belongs to
+    int32_t playerCount;
+    int32_t bulletCount;                     // Live entries in bullets
+    int32_t winner;
+    uint8_t gameOver;
+    uint8_t gameRunning;
+    uint8_t padding[2];
+    int32_t scores[MAX_PLAYERS];
+    Tank tanks[MAX_PLAYERS];
+    Bullet bullets[SNAPSHOT_MAX_BULLETS];
+};
+
+static_assert(std::is_trivially_copyable<GameSnapshot>::value,
+              "GameSnapshot must stay trivially copyable");
+
+// Fixed-size ring of snapshots indexed by tick.
+// Slot memory is allocated once; Save() and Restore() never allocate. A
+// snapshot is found only while fewer than Capacity() newer ticks have been
+// saved over it.
+class SnapshotRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SnapshotRing(int capacity = 32);
+
+    // Save the state under its current tick, overwriting the oldest slot.
+    // False if the state has more bullets than a snapshot holds; the slot is
+    // then left empty, so the tick can never be restored wrongly.
+    bool Save(const GameState& state);
+
+    // Snapshot saved for a tick, or nullptr if it was not saved or has been
+    // overwritten
+    const GameSnapshot* Find(uint32_t tick) const;
+
+    // Restore the state saved for a tick; returns false if not available
+    bool Restore(uint32_t tick, GameState& state) const;
+
+    int Capacity() const { return mask + 1; }
+
+    // Saves refused because the state had too many bullets
+    uint64_t OverflowedSaves() const { return overflowedSaves; }
+
+private:
+    std::vector<GameSnapshot> slots;
+    std::vector<uint8_t> valid;
+    int mask;
+    uint64_t overflowedSaves;
+};
+
+#endif // SNAPSHOT_H
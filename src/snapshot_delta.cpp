@@ -0,0 +1,336 @@
+#include "snapshot_delta.h"
+#include <cmath>
+#include <utility>
+
+// Baseline coordinate moved on by its velocity for distance ticks. Both ends
+// compute this from the same quantized values, so they agree exactly.
+static int PredictCoordinate(uint16_t baseline, uint16_t velocity, int distance) {
+    // Position steps per velocity step, and the velocity step of zero speed
+    static const double positionSteps = (2.0 * WIRE_VELOCITY_MAX / ((1 << WIRE_VELOCITY_BITS) - 1)) *
+                                        (((1 << WIRE_POSITION_BITS) - 1) / (double)WIRE_POSITION_MAX);
+    static const double zero = ((1 << WIRE_VELOCITY_BITS) - 1) / 2.0;
+    return (int)baseline + (int)floor((velocity - zero) * positionSteps * distance + 0.5);
+}
+
+// Coordinate as its zigzag residual from the prediction, in the smallest of
+// three sizes: "1" + tiny residual, "01" + small residual or "00" + the
+// full value
+static void WriteCoordinate(BitWriter& writer, uint16_t value, int predicted) {
+    int residual = (int)value - predicted;
+    uint32_t zigzag = ((uint32_t)residual << 1) ^ (uint32_t)(residual >> 31);
+    if (zigzag < (1u << SNAPSHOT_TINY_DELTA_BITS)) {
+        writer.WriteBits(1, 1);
+        writer.WriteBits(zigzag, SNAPSHOT_TINY_DELTA_BITS);
+    } else if (zigzag < (1u << SNAPSHOT_SMALL_DELTA_BITS)) {
+        writer.WriteBits(2, 2);
+        writer.WriteBits(zigzag, SNAPSHOT_SMALL_DELTA_BITS);
+    } else {
+        writer.WriteBits(0, 2);
+        writer.WriteBits(value, WIRE_POSITION_BITS);
+    }
+}
+
+static uint16_t ReadCoordinate(BitReader& reader, int predicted) {
+    uint32_t zigzag;
+    if (reader.ReadBool()) {
+        zigzag = reader.ReadBits(SNAPSHOT_TINY_DELTA_BITS);
+    } else if (reader.ReadBool()) {
+        zigzag = reader.ReadBits(SNAPSHOT_SMALL_DELTA_BITS);
+    } else {
+        return (uint16_t)reader.ReadBits(WIRE_POSITION_BITS);
+    }
+    int residual = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+    return (uint16_t)(predicted + residual);
+}
+
+// Lifetime counts down once per tick
+static uint8_t PredictLifetime(uint8_t baseline, int distance) {
+    return (uint8_t)(baseline > distance ? baseline - distance : 0);
+}
+
+// Tank deltas
+static int TankChanges(const WireTank& tank, const WireTank& baseline) {
+    int mask = 0;
+    if (tank.x != baseline.x || tank.y != baseline.y) mask |= TANK_DELTA_POSITION;
+    if (tank.velocityX != baseline.velocityX || tank.velocityY != baseline.velocityY) mask |= TANK_DELTA_VELOCITY;
+    if (tank.rotation != baseline.rotation) mask |= TANK_DELTA_ROTATION;
+    if (tank.alive != baseline.alive || tank.cooldown != baseline.cooldown || tank.player != baseline.player) {
+        mask |= TANK_DELTA_STATUS;
+    }
+    return mask;
+}
+
+static void WriteTankDelta(BitWriter& writer, const WireTank& tank, const WireTank& baseline, int distance) {
+    int mask = TankChanges(tank, baseline);
+    writer.WriteBool(mask != 0);
+    if (mask == 0) {
+        return;
+    }
+    writer.WriteBits((uint32_t)mask, TANK_DELTA_FIELDS);
+    if (mask & TANK_DELTA_POSITION) {
+        WriteCoordinate(writer, tank.x, PredictCoordinate(baseline.x, baseline.velocityX, distance));
+        WriteCoordinate(writer, tank.y, PredictCoordinate(baseline.y, baseline.velocityY, distance));
+    }
+    if (mask & TANK_DELTA_VELOCITY) {
+        writer.WriteBits(tank.velocityX, WIRE_VELOCITY_BITS);
+        writer.WriteBits(tank.velocityY, WIRE_VELOCITY_BITS);
+    }
+    if (mask & TANK_DELTA_ROTATION) {
+        writer.WriteBits(tank.rotation, WIRE_ROTATION_BITS);
+    }
+    if (mask & TANK_DELTA_STATUS) {
+        writer.WriteBits(tank.alive, 1);
+        writer.WriteBits(tank.cooldown, WIRE_COOLDOWN_BITS);
+        writer.WriteBits(tank.player, WIRE_PLAYER_BITS);
+    }
+}
+
+static void ReadTankDelta(BitReader& reader, WireTank& tank, const WireTank& baseline, int distance) {
+    tank = baseline;
+    if (!reader.ReadBool()) {
+        return;
+    }
+    int mask = (int)reader.ReadBits(TANK_DELTA_FIELDS);
+    if (mask & TANK_DELTA_POSITION) {
+        tank.x = ReadCoordinate(reader, PredictCoordinate(baseline.x, baseline.velocityX, distance));
+        tank.y = ReadCoordinate(reader, PredictCoordinate(baseline.y, baseline.velocityY, distance));
+    }
+    if (mask & TANK_DELTA_VELOCITY) {
+        tank.velocityX = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+        tank.velocityY = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    }
+    if (mask & TANK_DELTA_ROTATION) {
+        tank.rotation = (uint16_t)reader.ReadBits(WIRE_ROTATION_BITS);
+    }
+    if (mask & TANK_DELTA_STATUS) {
+        tank.alive = (uint8_t)reader.ReadBits(1);
+        tank.cooldown = (uint8_t)reader.ReadBits(WIRE_COOLDOWN_BITS);
+        tank.player = (uint8_t)reader.ReadBits(WIRE_PLAYER_BITS);
+    }
+}
+
+// Bullet deltas
+// Bullets fly straight between bounces, so a bullet only counts as changed
+// where it left the predicted path
+static int BulletChanges(const WireBullet& bullet, const WireBullet& baseline, int distance) {
+    int mask = 0;
+    if (bullet.x != PredictCoordinate(baseline.x, baseline.velocityX, distance) ||
+        bullet.y != PredictCoordinate(baseline.y, baseline.velocityY, distance)) {
+        mask |= BULLET_DELTA_POSITION;
+    }
+    if (bullet.velocityX != baseline.velocityX || bullet.velocityY != baseline.velocityY) mask |= BULLET_DELTA_VELOCITY;
+    if (bullet.lifetime != PredictLifetime(baseline.lifetime, distance)) mask |= BULLET_DELTA_LIFETIME;
+    if (bullet.owner != baseline.owner || bullet.bounces != baseline.bounces) mask |= BULLET_DELTA_STATUS;
+    return mask;
+}
+
+static void WriteBulletDelta(BitWriter& writer, const WireBullet& bullet, const WireBullet& baseline, int distance) {
+    int mask = BulletChanges(bullet, baseline, distance);
+    writer.WriteBool(mask != 0);
+    if (mask == 0) {
+        return;
+    }
+    writer.WriteBits((uint32_t)mask, BULLET_DELTA_FIELDS);
+    if (mask & BULLET_DELTA_POSITION) {
+        WriteCoordinate(writer, bullet.x, PredictCoordinate(baseline.x, baseline.velocityX, distance));
+        WriteCoordinate(writer, bullet.y, PredictCoordinate(baseline.y, baseline.velocityY, distance));
+    }
+    if (mask & BULLET_DELTA_VELOCITY) {
+        writer.WriteBits(bullet.velocityX, WIRE_VELOCITY_BITS);
+        writer.WriteBits(bullet.velocityY, WIRE_VELOCITY_BITS);
+    }
+    if (mask & BULLET_DELTA_LIFETIME) {
+        writer.WriteBits(bullet.lifetime, WIRE_LIFETIME_BITS);
+    }
+    if (mask & BULLET_DELTA_STATUS) {
+        writer.WriteBits(bullet.owner, WIRE_PLAYER_BITS);
+        writer.WriteBits(bullet.bounces, WIRE_BOUNCE_BITS);
+    }
+}
+
+static void ReadBulletDelta(BitReader& reader, WireBullet& bullet, const WireBullet& baseline, int distance) {
+    bullet = baseline;
+    bullet.x = (uint16_t)PredictCoordinate(baseline.x, baseline.velocityX, distance);
+    bullet.y = (uint16_t)PredictCoordinate(baseline.y, baseline.velocityY, distance);
+    bullet.lifetime = PredictLifetime(baseline.lifetime, distance);
+    if (!reader.ReadBool()) {
+        return;
+    }
+    int mask = (int)reader.ReadBits(BULLET_DELTA_FIELDS);
+    if (mask & BULLET_DELTA_POSITION) {
+        bullet.x = ReadCoordinate(reader, PredictCoordinate(baseline.x, baseline.velocityX, distance));
+        bullet.y = ReadCoordinate(reader, PredictCoordinate(baseline.y, baseline.velocityY, distance));
+    }
+    if (mask & BULLET_DELTA_VELOCITY) {
+        bullet.velocityX = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+        bullet.velocityY = (uint16_t)reader.ReadBits(WIRE_VELOCITY_BITS);
+    }
+    if (mask & BULLET_DELTA_LIFETIME) {
+        bullet.lifetime = (uint8_t)reader.ReadBits(WIRE_LIFETIME_BITS);
+    }
+    if (mask & BULLET_DELTA_STATUS) {
+        bullet.owner = (uint8_t)reader.ReadBits(WIRE_PLAYER_BITS);
+        bullet.bounces = (uint8_t)reader.ReadBits(WIRE_BOUNCE_BITS);
+    }
+}
+
+// SnapshotDeltaEncoder methods
+SnapshotDeltaEncoder::SnapshotDeltaEncoder() {
+    Reset();
+}
+
+void SnapshotDeltaEncoder::Reset() {
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++) {
+        historySequence[i] = 0;
+        historyValid[i] = false;
+    }
+    nextSequence = 0;
+    ackedSequence = 0;
+    hasAck = false;
+    fullSnapshots = 0;
+    deltaSnapshots = 0;
+}
+
+uint16_t SnapshotDeltaEncoder::Encode(const GameStatePacket& packet, BitWriter& writer) {
+    uint16_t sequence = nextSequence++;
+    int slot = sequence % SNAPSHOT_HISTORY;
+    WireGameState& current = history[slot];
+
+    // Pick the baseline before this snapshot takes over its slot
+    uint16_t distance = (uint16_t)(sequence - ackedSequence);
+    bool delta = hasAck && distance > 0 && distance < SNAPSHOT_HISTORY;
+    const WireGameState* baseline = delta ? &history[ackedSequence % SNAPSHOT_HISTORY] : nullptr;
+
+    QuantizeGameState(packet, current);
+    historySequence[slot] = sequence;
+    historyValid[slot] = true;
+
+    writer.WriteBits(PACKET_SNAPSHOT, WIRE_TYPE_BITS);
+    writer.WriteBits(sequence, 16);
+    writer.WriteBits(delta ? distance : 0, SNAPSHOT_DISTANCE_BITS);
+
+    if (!delta) {
+        fullSnapshots++;
+        writer.WriteVarUint((uint32_t)current.tanks.size());
+        for (const WireTank& tank : current.tanks) {
+            WriteWireTank(writer, tank);
+        }
+        writer.WriteVarUint((uint32_t)current.bullets.size());
+        for (const WireBullet& bullet : current.bullets) {
+            WriteWireBullet(writer, bullet);
+        }
+        return sequence;
+    }
+
+    // Entities past the end of the baseline's lists are sent in full
+    deltaSnapshots++;
+    writer.WriteVarUint((uint32_t)current.tanks.size());
+    for (size_t i = 0; i < current.tanks.size(); i++) {
+        if (i < baseline->tanks.size()) {
+            WriteTankDelta(writer, current.tanks[i], baseline->tanks[i], distance);
+        } else {
+            WriteWireTank(writer, current.tanks[i]);
+        }
+    }
+    writer.WriteVarUint((uint32_t)current.bullets.size());
+    for (size_t i = 0; i < current.bullets.size(); i++) {
+        if (i < baseline->bullets.size()) {
+            WriteBulletDelta(writer, current.bullets[i], baseline->bullets[i], distance);
+        } else {
+            WriteWireBullet(writer, current.bullets[i]);
+        }
+    }
+    return sequence;
+}
+
+void SnapshotDeltaEncoder::Acknowledge(uint16_t sequence) {
+    int slot = sequence % SNAPSHOT_HISTORY;
+    if (!historyValid[slot] || historySequence[slot] != sequence) {
+        return;
+    }
+    // Only snapshots actually sent, and not yet overwritten, can be baselines
+    uint16_t age = (uint16_t)(nextSequence - 1 - sequence);
+    if (age >= SNAPSHOT_HISTORY) {
+        return;
+    }
+    if (!hasAck || SequenceNewer(sequence, ackedSequence)) {
+        ackedSequence = sequence;
+        hasAck = true;
+    }
+}
+
+// SnapshotDeltaDecoder methods
+SnapshotDeltaDecoder::SnapshotDeltaDecoder() {
+    Reset();
+}
+
+void SnapshotDeltaDecoder::Reset() {
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++) {
+        historySequence[i] = 0;
+        historyValid[i] = false;
+    }
+    latestSequence = 0;
+    hasLatest = false;
+}
+
+bool SnapshotDeltaDecoder::Decode(BitReader& reader, GameStatePacket& packet) {
+    if (reader.ReadBits(WIRE_TYPE_BITS) != PACKET_SNAPSHOT) {
+        return false;
+    }
+    uint16_t sequence = (uint16_t)reader.ReadBits(16);
+    uint32_t distance = reader.ReadBits(SNAPSHOT_DISTANCE_BITS);
+    if (reader.Overflowed() || (hasLatest && !SequenceNewer(sequence, latestSequence))) {
+        return false;
+    }
+
+    const WireGameState* baseline = nullptr;
+    if (distance > 0) {
+        uint16_t baselineSequence = (uint16_t)(sequence - distance);
+        int baselineSlot = baselineSequence % SNAPSHOT_HISTORY;
+        if (!historyValid[baselineSlot] || historySequence[baselineSlot] != baselineSequence) {
+            return false;
+        }
+        baseline = &history[baselineSlot];
+    }
+
+    // Decode into scratch so a malformed packet leaves the history intact
+    WireGameState& current = scratch;
+    uint32_t tankCount = reader.ReadVarUint();
+    if (tankCount > (uint32_t)MAX_PLAYERS || reader.Overflowed()) {
+        return false;
+    }
+    current.tanks.resize(tankCount);
+    for (size_t i = 0; i < current.tanks.size(); i++) {
+        if (baseline && i < baseline->tanks.size()) {
+            ReadTankDelta(reader, current.tanks[i], baseline->tanks[i], (int)distance);
+        } else {
+            ReadWireTank(reader, current.tanks[i]);
+        }
+    }
+    // Every bullet costs at least one bit
+    uint32_t bulletCount = reader.ReadVarUint();
+    if (bulletCount > (uint32_t)WIRE_MAX_BULLETS || reader.Overflowed() || bulletCount > reader.BitsLeft()) {
+        return false;
+    }
+    current.bullets.resize(bulletCount);
+    for (size_t i = 0; i < current.bullets.size(); i++) {
+        if (baseline && i < baseline->bullets.size()) {
+            ReadBulletDelta(reader, current.bullets[i], baseline->bullets[i], (int)distance);
+        } else {
+            ReadWireBullet(reader, current.bullets[i]);
+        }
+    }
+    if (reader.Overflowed()) {
+        return false;
+    }
+
+    int slot = sequence % SNAPSHOT_HISTORY;
+    std::swap(history[slot], scratch);
+    historySequence[slot] = sequence;
+    historyValid[slot] = true;
+    latestSequence = sequence;
+    hasLatest = true;
+
+    DequantizeGameState(history[slot], packet);
+    return true;
+}
@@ -0,0 +1,107 @@
+#ifndef SNAPSHOT_DELTA_H
+#define SNAPSHOT_DELTA_H
+
+#include <cstdint>
+#include "bitstream.h"
+#include "packets.h"
+
+const int SNAPSHOT_HISTORY = 32;          // Snapshots each end remembers as possible baselines
+const int SNAPSHOT_DISTANCE_BITS = 5;     // Sequence distance back to the baseline, 0 = full
+const int SNAPSHOT_TINY_DELTA_BITS = 4;   // Zigzag position residuals up to +-0.5 px
+const int SNAPSHOT_SMALL_DELTA_BITS = 10; // Zigzag position residuals up to +-32 px
+
+// Per-field change bits of a tank in a delta snapshot
+enum TankDeltaField {
+    TANK_DELTA_POSITION = 1 << 0,
+    TANK_DELTA_VELOCITY = 1 << 1,
+    TANK_DELTA_ROTATION = 1 << 2,
+    TANK_DELTA_STATUS   = 1 << 3,   // alive, cooldown, player
+    TANK_DELTA_FIELDS   = 4
+};
+
+// Per-field change bits of a bullet in a delta snapshot
+enum BulletDeltaField {
+    BULLET_DELTA_POSITION = 1 << 0,
+    BULLET_DELTA_VELOCITY = 1 << 1,
+    BULLET_DELTA_LIFETIME = 1 << 2,
+    BULLET_DELTA_STATUS   = 1 << 3, // owner, bounces
+    BULLET_DELTA_FIELDS   = 4
+};
+
+// Server side of delta-compressed game state snapshots, one per client.
+// Every snapshot gets a 16-bit sequence number and is remembered in a ring
+// of SNAPSHOT_HISTORY quantized states. Once the client acknowledges a
+// sequence, later snapshots are encoded against the newest acknowledged one:
+// each entity costs one bit when nothing changed, otherwise a mask of the
+// field groups that changed followed by only those fields. Positions are
+// predicted from the baseline position and velocity (and bullet lifetimes
+// from the baseline lifetime) assuming one snapshot per tick, and only the
+// residual is sent, so a bullet flying straight costs a single bit; other
+// send rates still decode exactly, just less compactly. Without a usable
+// baseline (nothing acked yet, or the newest ack is SNAPSHOT_HISTORY or more
+// snapshots old) the snapshot is sent in full. Bullets are matched to the
+// baseline by slot, so a bullet that moved slots (BulletPool removal swaps)
+// costs a larger delta.
+//
+// Wire layout: PACKET_SNAPSHOT tag, sequence (16 bits), distance back to the
+// baseline (SNAPSHOT_DISTANCE_BITS, 0 = full), tank count, tanks, bullet
+// count, bullets. Lists are as long as the packet's; tanks and bullets past
+// the end of the baseline's lists are sent in full. A snapshot that encodes
+// larger than WIRE_MAX_PACKET_BYTES cannot be sent (see FitsOnWire); the
+// client then never acks it, so it never becomes a baseline.
+class SnapshotDeltaEncoder {
+public:
+    SnapshotDeltaEncoder();
+
+    // Forget all history and acks, e.g. when a client (re)joins
+    void Reset();
+
+    // Append the next snapshot of the state; returns its sequence number
+    uint16_t Encode(const GameStatePacket& packet, BitWriter& writer);
+
+    // The client has decoded the snapshot with this sequence number. Acks
+    // older than the newest one, or for snapshots no longer in the history,
+    // are ignored.
+    void Acknowledge(uint16_t sequence);
+
+    uint32_t FullSnapshots() const { return fullSnapshots; }
+    uint32_t DeltaSnapshots() const { return deltaSnapshots; }
+
+private:
+    WireGameState history[SNAPSHOT_HISTORY];
+    uint16_t historySequence[SNAPSHOT_HISTORY];
+    bool historyValid[SNAPSHOT_HISTORY];
+    uint16_t nextSequence;
+    uint16_t ackedSequence;
+    bool hasAck;
+    uint32_t fullSnapshots;
+    uint32_t deltaSnapshots;
+};
+
+// Client side: rebuilds snapshots from their baselines.
+// Snapshots are latest-wins: one that is not newer than the last decoded
+// snapshot is rejected, as is one whose baseline is no longer known. The
+// caller acknowledges LatestSequence() after every successful decode.
+class SnapshotDeltaDecoder {
+public:
+    SnapshotDeltaDecoder();
+
+    void Reset();
+
+    // Decode a PACKET_SNAPSHOT; false if it is malformed, stale or its
+    // baseline is missing (the packet is then dropped and not acknowledged)
+    bool Decode(BitReader& reader, GameStatePacket& packet);
+
+    bool HasSnapshot() const { return hasLatest; }
+    uint16_t LatestSequence() const { return latestSequence; }
+
+private:
+    WireGameState history[SNAPSHOT_HISTORY];
+    uint16_t historySequence[SNAPSHOT_HISTORY];
+    bool historyValid[SNAPSHOT_HISTORY];
+    WireGameState scratch;          // Snapshot being decoded
+    uint16_t latestSequence;
+    bool hasLatest;
+};
+
+#endif // SNAPSHOT_DELTA_H
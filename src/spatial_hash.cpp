@@ -0,0 +1,41 @@
+#include "spatial_hash.h"
+
+void SpatialHash::Insert(int id, float minX, float minY, float maxX, float maxY) {
+    int x0 = CellOf(minX);
+    int y0 = CellOf(minY);
+    int x1 = CellOf(maxX);
+    int y1 = CellOf(maxY);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            Entry entry;
+            entry.key = CellKey(x, y);
+            entry.id = id;
+            pending.push_back(entry);
+        }
+    }
+}
+
+void SpatialHash::Build() {
+    // Keep roughly two buckets per entry so most buckets hold a single cell
+    uint32_t bucketCount = 16;
+    while (bucketCount < pending.size() * 2) {
+        bucketCount <<= 1;
+    }
+    bucketMask = bucketCount - 1;
+
+    // Count entries per bucket, then turn the counts into start offsets
+    bucketStart.assign(bucketCount + 1, 0);
+    for (const Entry& entry : pending) {
+        bucketStart[(Hash(entry.key) & bucketMask) + 1]++;
+    }
+    for (uint32_t b = 0; b < bucketCount; b++) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+
+    // Scatter entries into place; cursor starts at each bucket's offset
+    items.resize(pending.size());
+    cursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+    for (const Entry& entry : pending) {
+        items[cursor[Hash(entry.key) & bucketMask]++] = entry;
+    }
+}
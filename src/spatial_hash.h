@@ -0,0 +1,77 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Uniform-grid spatial hash for broadphase queries.
+// Objects are inserted into every grid cell their bounding box overlaps, then
+// Build() sorts them into per-bucket runs (a counting sort, so the cost is
+// linear in the number of entries). The bucket count scales with the number
+// of entries, not with the arena size, so a sparse large arena costs the same
+// as a dense small one. Each entry keeps its cell key, so hash collisions
+// never leak objects from other cells into a query. Within a cell, objects
+// are visited in insertion order.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize) : cellSize(cellSize), bucketMask(0) {}
+
+    // Start a new frame; keeps allocated storage
+    void Clear() { pending.clear(); }
+
+    // Stage an object covering the box [minX, maxX] x [minY, maxY]
+    void Insert(int id, float minX, float minY, float maxX, float maxY);
+
+    // Sort staged objects into buckets; call before querying
+    void Build();
+
+    int CellOf(float v) const { return (int)floorf(v / cellSize); }
+
+    // Call visit(id) for every object in cell (cellX, cellY) until it returns false
+    template <typename Visit>
+    void QueryCell(int cellX, int cellY, Visit visit) const {
+        if (bucketStart.empty()) {
+            return;
+        }
+        uint64_t key = CellKey(cellX, cellY);
+        uint32_t bucket = Hash(key) & bucketMask;
+        for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+            if (items[i].key == key && !visit(items[i].id)) {
+                return;
+            }
+        }
+    }
+
+    // Call visit(id) for every object in the cell containing (x, y)
+    template <typename Visit>
+    void QueryPoint(float x, float y, Visit visit) const {
+        QueryCell(CellOf(x), CellOf(y), visit);
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        int id;
+    };
+
+    static uint64_t CellKey(int cellX, int cellY) {
+        return ((uint64_t)(uint32_t)cellY << 32) | (uint32_t)cellX;
+    }
+
+    static uint32_t Hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return (uint32_t)key;
+    }
+
+    float cellSize;
+    uint32_t bucketMask;
+    std::vector<Entry> pending;          // Staged entries for this frame
+    std::vector<Entry> items;            // Entries grouped by bucket
+    std::vector<uint32_t> bucketStart;   // Start of each bucket's run in items
+    std::vector<uint32_t> cursor;        // Scratch fill positions used by Build
+};
+
+#endif // SPATIAL_HASH_H
@@ -0,0 +1,102 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue between exactly one producer thread and one
+// consumer thread.
+// Items live in a fixed ring allocated with the queue, so pushing and
+// popping never allocate, lock or make a system call; a full queue makes
+// TryPush fail instead of waiting. The producer owns tail and the consumer
+// owns head, each on its own cache line, and each side keeps a cached copy
+// of the other's index so it only touches the shared line when the cached
+// value says the queue looks full (or empty).
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), cachedTail(0), tail(0), cachedHead(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only: copy the item in; false if the queue is full
+    bool TryPush(const T& item) {
+        T* back = Back();
+        if (back == nullptr) {
+            return false;
+        }
+        *back = item;
+        Push();
+        return true;
+    }
+
+    // Producer only: the free slot the next item goes in, or null if the
+    // queue is full. Fill it in place and Push() it, so large items are
+    // never copied
+    T* Back() {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (position - cachedHead == Capacity) {
+                return nullptr;
+            }
+        }
+        return &items[position & (Capacity - 1)];
+    }
+
+    // Producer only: publish the slot Back() returned
+    void Push() {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer only: the oldest item, or null if the queue is empty. It
+    // stays valid and in place until Pop()
+    T* Front() {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (position == cachedTail) {
+                return nullptr;
+            }
+        }
+        return &items[position & (Capacity - 1)];
+    }
+
+    // Consumer only: release the item Front() returned
+    void Pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer only: copy the oldest item out; false if the queue is empty
+    bool TryPop(T& item) {
+        T* front = Front();
+        if (front == nullptr) {
+            return false;
+        }
+        item = *front;
+        Pop();
+        return true;
+    }
+
+    // Either side: a snapshot that may already be stale
+    size_t SizeApprox() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    static size_t MaxSize() { return Capacity; }
+
+private:
+    // Consumer's line
+    alignas(64) std::atomic<size_t> head;
+    size_t cachedTail;
+    // Producer's line
+    alignas(64) std::atomic<size_t> tail;
+    size_t cachedHead;
+
+    alignas(64) T items[Capacity];
+};
+
+#endif // SPSC_QUEUE_H
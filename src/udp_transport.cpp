@@ -0,0 +1,326 @@
+#include "udp_transport.h"
+#include "packets.h"
+
+static const int INPUT_COUNT_BITS = 8;       // Holds 0..UDP_INPUT_WINDOW
+static const int INPUT_BUTTON_BITS = 5;      // InputButton flags
+
+static void WriteBytes(BitWriter& writer, const uint8_t* data, size_t size) {
+    writer.WriteVarUint((uint32_t)size);
+    for (size_t i = 0; i < size; i++) {
+        writer.WriteBits(data[i], 8);
+    }
+}
+
+static bool ReadBytes(BitReader& reader, std::vector<uint8_t>& data, size_t maxSize) {
+    uint32_t size = reader.ReadVarUint();
+    if (size > maxSize || size * 8 > reader.BitsLeft()) {
+        return false;
+    }
+    data.resize(size);
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)reader.ReadBits(8);
+    }
+    return true;
+}
+
+// UdpConnection methods
+UdpConnection::UdpConnection() {
+    Reset();
+}
+
+void UdpConnection::Reset(double now) {
+    localSequence = 0;
+    for (SentDatagram& record : sent) {
+        record.sequence = 0;
+        record.pending = false;
+        record.sendTime = 0;
+        record.firstReliable = 0;
+        record.reliableCount = 0;
+    }
+    inputsOut.clear();
+    nextInputOut = 0;
+    anyInputOut = false;
+    latestOut.clear();
+    latestPending = false;
+    reliableOut.clear();
+    nextReliableId = 0;
+
+    remoteSequence = 0;
+    receivedBits = 0;
+    receivedAny = false;
+    inputsIn.clear();
+    nextInputIn = 0;
+    anyInputIn = false;
+    latestIn.clear();
+    latestInSequence = 0;
+    latestAvailable = false;
+    anyLatest = false;
+    reliableIn.clear();
+    nextReliableIn = 0;
+
+    lastReceiveTime = now;
+    roundTripTime = 0;
+    datagramsSent = 0;
+    datagramsReceived = 0;
+    datagramsAcked = 0;
+    datagramsLost = 0;
+}
+
+bool UdpConnection::QueueInput(uint32_t tick, uint8_t buttons) {
+    if (!inputsOut.empty() && tick == inputsOut.back().tick) {
+        inputsOut.back().buttons = buttons;
+        return true;
+    }
+    // A skipped tick would leave the peer waiting for it forever, and a peer
+    // that has not acked a whole window is not keeping up
+    if ((anyInputOut && tick != nextInputOut) || inputsOut.size() >= (size_t)UDP_INPUT_WINDOW) {
+        return false;
+    }
+    QueuedInput input;
+    input.tick = tick;
+    input.buttons = buttons;
+    inputsOut.push_back(input);
+    nextInputOut = tick + 1;
+    anyInputOut = true;
+    return true;
+}
+
+void UdpConnection::SendLatest(const uint8_t* data, size_t size) {
+    latestOut.assign(data, data + size);
+    latestPending = true;
+}
+
+bool UdpConnection::SendReliable(const uint8_t* data, size_t size) {
+    if ((int)reliableOut.size() >= UDP_RELIABLE_WINDOW || size > (size_t)UDP_RELIABLE_MAX_SIZE) {
+        return false;
+    }
+    ReliableMessage message;
+    message.id = nextReliableId++;
+    message.acked = false;
+    message.data.assign(data, data + size);
+    reliableOut.push_back(message);
+    return true;
+}
+
+size_t UdpConnection::WriteDatagram(BitWriter& writer, double now) {
+    uint16_t sequence = localSequence++;
+    SentDatagram& record = sent[sequence % UDP_SENT_HISTORY];
+    if (record.pending) {
+        datagramsLost++;
+    }
+
+    writer.WriteBits(UDP_PROTOCOL_ID, 16);
+    writer.WriteBits(sequence, 16);
+    writer.WriteBits(remoteSequence, 16);
+    writer.WriteBits(receivedAny ? receivedBits : 0, UDP_ACK_BITS);
+
+    // Which remote inputs we have, then ours from the oldest unacked tick
+    writer.WriteBool(anyInputIn);
+    if (anyInputIn) {
+        writer.WriteBits(nextInputIn, 32);
+    }
+    int inputs = (int)inputsOut.size();
+    writer.WriteBits((uint32_t)inputs, INPUT_COUNT_BITS);
+    if (inputs > 0) {
+        writer.WriteBits(inputsOut.front().tick, 32);
+        for (int i = 0; i < inputs; i++) {
+            writer.WriteBits(inputsOut[i].buttons, INPUT_BUTTON_BITS);
+        }
+    }
+
+    writer.WriteBool(latestPending);
+    if (latestPending) {
+        WriteBytes(writer, latestOut.data(), latestOut.size());
+        latestPending = false;
+    }
+
+    // As many unacked reliable messages, oldest first, as fit the datagram
+    size_t budget = writer.Size() + 8;
+    int count = 0;
+    for (const ReliableMessage& message : reliableOut) {
+        budget += message.data.size() + 2;
+        if (budget > (size_t)UDP_MAX_DATAGRAM) {
+            break;
+        }
+        count++;
+    }
+    writer.WriteVarUint((uint32_t)count);
+    if (count > 0) {
+        writer.WriteBits(reliableOut.front().id, 16);
+        for (int i = 0; i < count; i++) {
+            WriteBytes(writer, reliableOut[i].data.data(), reliableOut[i].data.size());
+        }
+    }
+
+    record.sequence = sequence;
+    record.pending = true;
+    record.sendTime = now;
+    record.firstReliable = count > 0 ? reliableOut.front().id : 0;
+    record.reliableCount = (uint16_t)count;
+    datagramsSent++;
+    return writer.Size();
+}
+
+bool UdpConnection::ReadDatagram(const uint8_t* data, size_t size, double now) {
+    BitReader reader(data, size);
+    if (reader.ReadBits(16) != UDP_PROTOCOL_ID) {
+        return false;
+    }
+    uint16_t sequence = (uint16_t)reader.ReadBits(16);
+    uint16_t ack = (uint16_t)reader.ReadBits(16);
+    uint32_t ackBits = reader.ReadBits(UDP_ACK_BITS);
+
+    // Parse everything before acting on any of it, so a truncated datagram
+    // changes nothing
+    bool hasInputAck = reader.ReadBool();
+    uint32_t inputAck = hasInputAck ? reader.ReadBits(32) : 0;
+    int inputs = (int)reader.ReadBits(INPUT_COUNT_BITS);
+    if (inputs > UDP_INPUT_WINDOW) {
+        return false;
+    }
+    uint32_t firstTick = inputs > 0 ? reader.ReadBits(32) : 0;
+    uint8_t buttons[UDP_INPUT_WINDOW];
+    for (int i = 0; i < inputs; i++) {
+        buttons[i] = (uint8_t)reader.ReadBits(INPUT_BUTTON_BITS);
+    }
+
+    std::vector<uint8_t> latest;
+    bool hasLatest = reader.ReadBool();
+    if (hasLatest && !ReadBytes(reader, latest, UDP_MAX_DATAGRAM)) {
+        return false;
+    }
+
+    uint32_t reliableCount = reader.ReadVarUint();
+    if (reliableCount > (uint32_t)UDP_RELIABLE_WINDOW) {
+        return false;
+    }
+    uint16_t firstReliable = reliableCount > 0 ? (uint16_t)reader.ReadBits(16) : 0;
+    std::vector<std::vector<uint8_t>> reliable(reliableCount);
+    for (uint32_t i = 0; i < reliableCount; i++) {
+        if (!ReadBytes(reader, reliable[i], UDP_RELIABLE_MAX_SIZE)) {
+            return false;
+        }
+    }
+    if (reader.Overflowed()) {
+        return false;
+    }
+
+    // Remember what we received for our own acks
+    if (!receivedAny) {
+        remoteSequence = sequence;
+        receivedBits = 0;
+        receivedAny = true;
+    } else if (SequenceNewer(sequence, remoteSequence)) {
+        uint16_t shift = (uint16_t)(sequence - remoteSequence);
+        receivedBits = (shift < UDP_ACK_BITS) ? (receivedBits << shift) : 0;
+        if (shift <= UDP_ACK_BITS) {
+            receivedBits |= 1u << (shift - 1);   // The previous newest
+        }
+        remoteSequence = sequence;
+    } else {
+        uint16_t age = (uint16_t)(remoteSequence - sequence);
+        if (age >= 1 && age <= UDP_ACK_BITS) {
+            receivedBits |= 1u << (age - 1);
+        }
+    }
+
+    // The peer's acks
+    Acknowledge(ack, now);
+    for (int i = 0; i < UDP_ACK_BITS; i++) {
+        if (ackBits & (1u << i)) {
+            Acknowledge((uint16_t)(ack - 1 - i), now);
+        }
+    }
+
+    // Inputs the peer has are resent no more
+    if (hasInputAck) {
+        while (!inputsOut.empty() && (int32_t)(inputAck - inputsOut.front().tick) > 0) {
+            inputsOut.pop_front();
+        }
+    }
+
+    // Inputs not delivered yet, continuing exactly from the last one. The
+    // peer resends from the oldest tick we have not acked, which is never
+    // past the one we expect, so nothing is skipped.
+    if (!anyInputIn && inputs > 0) {
+        nextInputIn = firstTick;
+        anyInputIn = true;
+    }
+    for (int i = 0; i < inputs; i++) {
+        if (firstTick + (uint32_t)i == nextInputIn) {
+            QueuedInput input;
+            input.tick = nextInputIn++;
+            input.buttons = buttons[i];
+            inputsIn.push_back(input);
+        }
+    }
+
+    if (hasLatest && (!anyLatest || SequenceNewer(sequence, latestInSequence))) {
+        latestIn.swap(latest);
+        latestInSequence = sequence;
+        latestAvailable = true;
+        anyLatest = true;
+    }
+
+    // Reliable messages arrive as a run starting at the sender's oldest
+    // unacked one, which is never past the next one we expect
+    for (uint32_t i = 0; i < reliableCount; i++) {
+        if ((uint16_t)(firstReliable + i) == nextReliableIn) {
+            reliableIn.push_back(std::move(reliable[i]));
+            nextReliableIn++;
+        }
+    }
+
+    lastReceiveTime = now;
+    datagramsReceived++;
+    return true;
+}
+
+void UdpConnection::Acknowledge(uint16_t sequence, double now) {
+    SentDatagram& record = sent[sequence % UDP_SENT_HISTORY];
+    if (!record.pending || record.sequence != sequence) {
+        return;
+    }
+    record.pending = false;
+    datagramsAcked++;
+
+    double sample = now - record.sendTime;
+    roundTripTime = (roundTripTime == 0) ? sample : roundTripTime + 0.1 * (sample - roundTripTime);
+
+    for (ReliableMessage& message : reliableOut) {
+        if ((uint16_t)(message.id - record.firstReliable) < record.reliableCount) {
+            message.acked = true;
+        }
+    }
+    while (!reliableOut.empty() && reliableOut.front().acked) {
+        reliableOut.pop_front();
+    }
+}
+
+bool UdpConnection::PopInput(uint32_t& tick, uint8_t& buttons) {
+    if (inputsIn.empty()) {
+        return false;
+    }
+    tick = inputsIn.front().tick;
+    buttons = inputsIn.front().buttons;
+    inputsIn.pop_front();
+    return true;
+}
+
+bool UdpConnection::TakeLatest(std::vector<uint8_t>& message) {
+    if (!latestAvailable) {
+        return false;
+    }
+    message = latestIn;
+    latestAvailable = false;
+    return true;
+}
+
+bool UdpConnection::PopReliable(std::vector<uint8_t>& message) {
+    if (reliableIn.empty()) {
+        return false;
+    }
+    message.swap(reliableIn.front());
+    reliableIn.pop_front();
+    return true;
+}
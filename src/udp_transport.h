@@ -0,0 +1,147 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "bitstream.h"
+
+const uint16_t UDP_PROTOCOL_ID = 0x5454;     // "TT"; datagrams without it are dropped
+const int UDP_MAX_DATAGRAM = 1200;           // Stays under a typical path MTU
+const int UDP_INPUT_WINDOW = 240;            // Most unacked input ticks; all fit in a datagram
+                                             // beside a WIRE_MAX_PACKET_BYTES latest message
+const int UDP_ACK_BITS = 32;                 // Older sequences acknowledged per datagram
+const int UDP_SENT_HISTORY = 256;            // Sent datagrams remembered for acks
+const int UDP_RELIABLE_WINDOW = 32;          // Reliable messages in flight at once
+const int UDP_RELIABLE_MAX_SIZE = 256;       // Largest reliable message in bytes
+
+// One end of a UDP conversation with a single peer.
+// The connection only builds and parses datagrams; the caller owns the
+// socket and the clock, so the protocol runs the same over a real socket
+// or in a test harness. Every datagram carries:
+//
+//   protocol id   16 bits
+//   sequence      16 bits, one per datagram sent
+//   ack           newest sequence received from the peer
+//   ack bits      UDP_ACK_BITS bits: was (ack - 1 - i) received too?
+//   input ack     next input tick expected from the peer
+//   inputs        every local input the peer has not acked yet (at most
+//                 UDP_INPUT_WINDOW), oldest tick first, so any number of
+//                 lost datagrams in a row only delays inputs
+//   latest        optional unreliable message (snapshots, snapshot acks):
+//                 sent once, and the receiver keeps only the newest
+//   reliable      every reliable message not yet acknowledged, oldest first
+//
+// Reliable messages are numbered and resent in each datagram until a
+// datagram carrying them is acked, and delivered strictly in order, so
+// events like a disconnect cannot be lost or reordered. Inputs are
+// delivered exactly once, in tick order and without gaps: a datagram whose
+// inputs start past the next expected tick is ignored for inputs, and the
+// peer resends from our input ack. Latest messages never wait on a lost
+// datagram.
+class UdpConnection {
+public:
+    UdpConnection();
+
+    // Forget all state, e.g. for a new peer; the silence timer starts at now
+    void Reset(double now = 0);
+
+    // Record this tick's local input; it rides along in every datagram until
+    // the peer acks it. Ticks must be consecutive: queuing the newest tick
+    // again replaces its buttons. False, and the input is not queued, if the
+    // tick skips ahead or UDP_INPUT_WINDOW inputs are already unacked; the
+    // peer can then never receive every tick, so the match is over.
+    bool QueueInput(uint32_t tick, uint8_t buttons);
+
+    // Unreliable latest-wins message for the next datagram, replacing any
+    // that has not been sent yet
+    void SendLatest(const uint8_t* data, size_t size);
+
+    // Queue a reliable ordered message; false if the window is full or the
+    // message is too large
+    bool SendReliable(const uint8_t* data, size_t size);
+
+    // Build the next datagram; returns its size in bytes
+    size_t WriteDatagram(BitWriter& writer, double now);
+
+    // Take in a datagram from the peer; false if it is not ours or malformed
+    bool ReadDatagram(const uint8_t* data, size_t size, double now);
+
+    // Remote inputs in tick order without gaps, each delivered once
+    bool PopInput(uint32_t& tick, uint8_t& buttons);
+
+    // Newest unreliable message received since the last call
+    bool TakeLatest(std::vector<uint8_t>& message);
+
+    // Next reliable message in order
+    bool PopReliable(std::vector<uint8_t>& message);
+
+    // Seconds since the last valid datagram, or since Reset()
+    double SilentFor(double now) const { return now - lastReceiveTime; }
+
+    // Smoothed round trip time in seconds (0 until the first ack)
+    double RoundTripTime() const { return roundTripTime; }
+
+    uint64_t DatagramsSent() const { return datagramsSent; }
+    uint64_t DatagramsReceived() const { return datagramsReceived; }
+    uint64_t DatagramsAcked() const { return datagramsAcked; }
+    uint64_t DatagramsLost() const { return datagramsLost; }   // Unacked when their history slot was reused
+    size_t InputsUnacked() const { return inputsOut.size(); }
+
+private:
+    struct SentDatagram {
+        uint16_t sequence;
+        bool pending;               // Sent and not yet acked or given up on
+        double sendTime;
+        uint16_t firstReliable;     // Reliable message ids carried
+        uint16_t reliableCount;
+    };
+
+    struct QueuedInput {
+        uint32_t tick;
+        uint8_t buttons;
+    };
+
+    struct ReliableMessage {
+        uint16_t id;
+        bool acked;
+        std::vector<uint8_t> data;
+    };
+
+    void Acknowledge(uint16_t sequence, double now);
+
+    // Sending
+    uint16_t localSequence;
+    SentDatagram sent[UDP_SENT_HISTORY];
+    std::deque<QueuedInput> inputsOut;           // Not yet acked by the peer, oldest first
+    uint32_t nextInputOut;       // Tick the next queued input must have
+    bool anyInputOut;
+    std::vector<uint8_t> latestOut;
+    bool latestPending;
+    std::deque<ReliableMessage> reliableOut;     // Unacked messages, oldest first
+    uint16_t nextReliableId;
+
+    // Receiving
+    uint16_t remoteSequence;     // Newest datagram received
+    uint32_t receivedBits;       // Bit i: remoteSequence - 1 - i was received
+    bool receivedAny;
+    std::deque<QueuedInput> inputsIn;            // Received, waiting for PopInput
+    uint32_t nextInputIn;        // Next remote tick to deliver; sent back as the input ack
+    bool anyInputIn;
+    std::vector<uint8_t> latestIn;
+    uint16_t latestInSequence;
+    bool latestAvailable;
+    bool anyLatest;
+    std::deque<std::vector<uint8_t>> reliableIn;
+    uint16_t nextReliableIn;     // Id of the next reliable message to deliver
+
+    double lastReceiveTime;
+    double roundTripTime;
+    uint64_t datagramsSent;
+    uint64_t datagramsReceived;
+    uint64_t datagramsAcked;
+    uint64_t datagramsLost;
+};
+
+#endif // UDP_TRANSPORT_H